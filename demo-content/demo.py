@@ -123,6 +123,14 @@ def parse_injection_input():
         except Exception as exp:
             print(f'Failed parsing injection input file: {exp}')
 
+def sync_start(conversation, processes):
+    '''
+    Start barrier of the processes of the conversation, unique to this run (Linux only)
+    '''
+    if platform.system() != 'Linux':
+        return ''
+    return f' -sync-start {conversation}-{os.getpid()}:{processes}'
+
 def collect_commands(conversation, alias, client_access_token, style, scale, right, up, forward, codec, args):
     folder = f'{conversations_folder}/{conversation}/'
     def_json = f'{folder}def.json'
@@ -145,12 +153,29 @@ def collect_commands(conversation, alias, client_access_token, style, scale, rig
                     f = b['media']
                     f = f'{folder}{f}'
                     media = 'A' if '.aac' in f or '.wav' in f or '.m4a' in f else 'AV'
-                    cmd = f'./{binary} -c {alias} -k {client_access_token} -l 3 -ld {directory} -initial-spatial-position {x};{y};{z} -initial-yaw-rotation {r} -initial-scale {scale} -u {name} -e {ext_id} -p user -m {media} --enable-media-io -f {f} -loop{spatial_style} -initial-right {right} -initial-up {up} -initial-forward {forward} -video-codec {codec}'.split(' ')
+                    cmd = f'./{binary} -c {alias} -k {client_access_token} -l 3 -ld {directory} -initial-spatial-position {x};{y};{z} -initial-yaw-rotation {r} -initial-scale {scale} -u {name} -e {ext_id} -p user -m {media} --enable-media-io -f {f} -loop{spatial_style} -initial-right {right} -initial-up {up} -initial-forward {forward} -video-codec {codec}{sync_start(conversation, len(j))}'.split(' ')
                     cmds.append(Popen(cmd))
                 else:
                     stop_injection_process(directory)
     return cmds
 
+def collect_host_command(conversation, alias, client_access_token, style, scale, right, up, forward, codec, args):
+    '''
+    Host every bot of the conversation in a single injection process
+    '''
+    folder = f'{conversations_folder}/{conversation}/'
+    directory = directory_prefix + conversation
+    if not os.path.exists(f'{folder}def.json'):
+        return []
+    if args.stop:
+        stop_injection_process(directory)
+        return []
+    if not os.path.exists(directory):
+        os.makedirs(directory)
+    spatial_style = f' -spatial {style}' if style != 'none' else ''
+    cmd = f'./{binary} --conversation {folder} -c {alias} -k {client_access_token} -l 3 -ld {directory} -initial-scale {scale} -loop{spatial_style} -initial-right {right} -initial-up {up} -initial-forward {forward} -video-codec {codec}'.split(' ')
+    return [Popen(cmd)]
+
 def setup_conference(client_access_token, alias, conversations, style, scale, right, up, forward, codec, args):
     '''
     This method scans the assets and use injection input json parameters to construct the injection command
@@ -165,7 +190,8 @@ def setup_conference(client_access_token, alias, conversations, style, scale, ri
             for conversation in assets:
                 if conversation.startswith(c):
                     found = True
-                    commands += collect_commands(conversation, alias, client_access_token, style, scale, right, up, forward, codec, args)
+                    collect = collect_host_command if args.host else collect_commands
+                    commands += collect(conversation, alias, client_access_token, style, scale, right, up, forward, codec, args)
             
             if not found:
                 print(f'Error - invalid conversation index specified {c}, request ignored')
@@ -178,6 +204,7 @@ def setup_cli():
     parser = argparse.ArgumentParser()
     parser.add_argument('-stop', default='', help='stop active injections for selected folders')
     parser.add_argument('-clear', default='', help='clear the log files and such for the previous injections')
+    parser.add_argument('-host', action='store_true', help='run all bots of a conversation inside of a single injection process')
     return parser.parse_args()
 
 args = setup_cli()
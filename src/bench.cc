@@ -0,0 +1,476 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022 - 2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+// Offline benchmark of the injection pipeline: decodes the media of the
+// conversations, then runs simulated bots which play the decoded media into a
+// loopback injector, with the conference calls completed locally after a
+// fixed latency. Reports the decode throughput, the pacing accuracy, the CPU
+// and memory used per bot and the startup latency, with no network and no
+// backend involved.
+
+#include "media/audio_decoder.h"
+#include "media/ffmpeg_decoder.h"
+#include "media/inj_file.h"
+#include "media/pcm_player.h"
+#include "media/video_decoder.h"
+#include "utils/commands_handler.h"
+#include "utils/conversation.h"
+#include "utils/json.h"
+
+#include <dolbyio/comms/async_result.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace dolbyio::comms::sample;
+using dolbyio::comms::async_result;
+using dolbyio::comms::async_result_with_solver;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+
+struct bench_params {
+  std::string conversations{"demo-content/conversations"};
+  std::vector<int> bot_counts{1, 10, 100};
+  std::chrono::seconds duration{10};
+  std::chrono::milliseconds call_latency{0};
+  std::string output{};
+  bool prepared{false};
+};
+
+// Percentiles of a set of samples, in the unit of the samples.
+struct distribution {
+  double p50{0}, p95{0}, p99{0}, max{0};
+
+  static distribution of(std::vector<double> samples) {
+    distribution dist;
+    if (samples.empty())
+      return dist;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double q) {
+      return samples[static_cast<size_t>(q * (samples.size() - 1))];
+    };
+    dist.p50 = at(0.50);
+    dist.p95 = at(0.95);
+    dist.p99 = at(0.99);
+    dist.max = samples.back();
+    return dist;
+  }
+
+  std::string json() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) << "{\"p50\": " << p50
+        << ", \"p95\": " << p95 << ", \"p99\": " << p99
+        << ", \"max\": " << max << "}";
+    return out.str();
+  }
+};
+
+double ms_between(clock_type::time_point from, clock_type::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+/**
+ * Stand-in for the SDK calls made while a bot joins (session opening,
+ * conference join, audio source setting). Every call completes after the
+ * configured latency, from a single thread, the way the SDK completes them
+ * from its event loop.
+ */
+class loopback_sdk {
+ public:
+  explicit loopback_sdk(std::chrono::milliseconds latency)
+      : latency_(latency), thread_([this]() { run(); }) {}
+
+  ~loopback_sdk() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      quit_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+  }
+
+  async_result<void> call() {
+    auto op = std::make_shared<async_result_with_solver<void>>(
+        async_result<void>::make());
+    auto result = op->get_result();
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      pending_.push_back({clock_type::now() + latency_, std::move(op)});
+    }
+    cond_.notify_all();
+    return result;
+  }
+
+ private:
+  struct pending_call {
+    clock_type::time_point due;
+    std::shared_ptr<async_result_with_solver<void>> op;
+  };
+
+  void run() {
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!quit_) {
+      if (pending_.empty()) {
+        cond_.wait(lock);
+        continue;
+      }
+      // Constant latency, the calls are due in order
+      const auto due = pending_.front().due;
+      if (cond_.wait_until(lock, due, [this]() { return quit_; }))
+        return;
+      auto call = std::move(pending_.front());
+      pending_.pop_front();
+      lock.unlock();
+      call.op->get_solver().resolve();
+      lock.lock();
+    }
+  }
+
+  const std::chrono::milliseconds latency_;
+  std::mutex lock_{};
+  std::condition_variable cond_{};
+  std::deque<pending_call> pending_{};
+  bool quit_{false};
+  std::thread thread_;
+};
+
+/**
+ * Injector consuming the frames locally, recording when each of them
+ * arrived.
+ */
+class loopback_injector : public dolbyio::comms::plugin::injector {
+ public:
+  loopback_injector()
+      : injector([](const dolbyio::comms::plugin::media_injection_status&) {
+        }) {
+    arrivals_.reserve(4096);
+  }
+
+  bool inject_audio_frame(
+      std::unique_ptr<dolbyio::comms::audio_frame>&&) override {
+    std::lock_guard<std::mutex> lock(lock_);
+    arrivals_.push_back(clock_type::now());
+    return true;
+  }
+
+  void inject_video_frame(const dolbyio::comms::video_frame&) override {}
+
+  std::optional<clock_type::time_point> first_frame() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (arrivals_.empty())
+      return std::nullopt;
+    return arrivals_.front();
+  }
+
+  // Deviation of the frames which arrived in the window from their ideal
+  // schedule, anchored on the first of them, in milliseconds.
+  std::vector<double> pacing_errors(clock_type::time_point from,
+                                    clock_type::time_point to) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::vector<double> errors;
+    auto first = std::lower_bound(arrivals_.begin(), arrivals_.end(), from);
+    for (auto it = first; it != arrivals_.end() && *it < to; ++it) {
+      const auto ideal = *first + (it - first) * pcm_player::frame_duration;
+      errors.push_back(std::abs(ms_between(ideal, *it)));
+    }
+    return errors;
+  }
+
+ private:
+  mutable std::mutex lock_{};
+  std::vector<clock_type::time_point> arrivals_{};
+};
+
+// Decoded (or mapped) audio of the media files, shared by the bots of a run
+// like the decode once cache shares it between the bots of a process.
+class audio_cache {
+ public:
+  explicit audio_cache(bool prepared) : prepared_(prepared) {}
+
+  std::shared_ptr<const pcm_buffer> get(const std::string& media) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto& buffer = buffers_[media];
+    if (!buffer && prepared_)
+      if (auto asset = inj_file::open(inj::prepared_path(media)))
+        buffer = asset->audio();
+    if (!buffer)
+      buffer = decode_audio_file(media);
+    return buffer;
+  }
+
+ private:
+  const bool prepared_;
+  std::mutex lock_{};
+  std::map<std::string, std::shared_ptr<const pcm_buffer>> buffers_{};
+};
+
+class simulated_bot {
+ public:
+  explicit simulated_bot(std::string media) : media_(std::move(media)) {}
+
+  // Same order as a bot joining: initialize the injection, open the
+  // session, join the conference and set the audio source, then start the
+  // capture.
+  void start(loopback_sdk& sdk, audio_cache& cache) {
+    started_ = clock_type::now();
+    player_ = std::make_unique<pcm_player>(injector_, true, []() {});
+    player_->play(cache.get(media_));
+    sdk.call()
+        .then([&sdk]() { return sdk.call(); })
+        .then([&sdk]() { return sdk.call(); })
+        .then([this]() { player_->set_capture(true); })
+        .on_error([this](std::exception_ptr&&) { failed_ = true; });
+  }
+
+  void stop() { player_.reset(); }
+
+  bool failed() const { return failed_; }
+  std::optional<double> startup_ms() const {
+    auto first = injector_.first_frame();
+    if (!first)
+      return std::nullopt;
+    return ms_between(started_, *first);
+  }
+  const loopback_injector& injector() const { return injector_; }
+
+ private:
+  std::string media_;
+  loopback_injector injector_{};
+  std::unique_ptr<pcm_player> player_{};
+  clock_type::time_point started_{};
+  std::atomic<bool> failed_{false};
+};
+
+std::vector<std::string> collect_media(const std::string& root) {
+  std::vector<std::string> media;
+  for (const auto& entry : std::filesystem::directory_iterator(root)) {
+    if (!std::filesystem::exists(entry.path() / "def.json"))
+      continue;
+    auto conv = conversation::load(entry.path().string());
+    for (const auto& bot : conv.bots)
+      media.push_back(
+          (std::filesystem::path(conv.folder) / bot.media).string());
+  }
+  std::sort(media.begin(), media.end());
+  if (media.empty())
+    throw std::runtime_error("No conversation found in " + root);
+  return media;
+}
+
+double cpu_seconds() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  auto seconds = [](const timeval& tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+  };
+  return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+double rss_mb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+    if (line.compare(0, 6, "VmRSS:") == 0)
+      return std::stod(line.substr(6)) / 1024;
+  return 0;
+}
+
+std::string bench_decode(const std::vector<std::string>& media) {
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(1) << "[";
+  std::cout << "Decode throughput" << std::endl;
+  std::vector<std::string> unique = media;
+  unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+  for (size_t i = 0; i < unique.size(); ++i) {
+    const auto& file = unique[i];
+    const auto start = clock_type::now();
+    const auto audio = decode_audio_file(file);
+    const double audio_ms = ms_between(start, clock_type::now());
+    const double realtime = audio->duration_ms() / std::max(audio_ms, 0.001);
+
+    size_t frames = 0;
+    double video_ms = 0;
+    if (ffmpeg_decoder::has_stream(file, AVMEDIA_TYPE_VIDEO)) {
+      const auto video_start = clock_type::now();
+      decode_video_file(file, [&frames](const i420_picture&) { ++frames; });
+      video_ms = ms_between(video_start, clock_type::now());
+    }
+    std::cout << "  " << file << ": audio " << std::fixed
+              << std::setprecision(1) << realtime << "x real time";
+    if (frames)
+      std::cout << ", video " << frames * 1000 / std::max(video_ms, 0.001)
+                << " frames/s";
+    std::cout << std::endl;
+    json << (i ? ", " : "") << "{\"file\": " << json_quote(file)
+         << ", \"audio_realtime_factor\": " << realtime
+         << ", \"video_frames\": " << frames
+         << ", \"video_decode_ms\": " << video_ms << "}";
+  }
+  json << "]";
+  return json.str();
+}
+
+std::string bench_bots(const bench_params& params,
+                       const std::vector<std::string>& media,
+                       int count) {
+  const double rss_before = rss_mb();
+  audio_cache cache{params.prepared};
+  loopback_sdk sdk{params.call_latency};
+  std::vector<std::unique_ptr<simulated_bot>> bots;
+  for (int i = 0; i < count; ++i)
+    bots.push_back(std::make_unique<simulated_bot>(media[i % media.size()]));
+
+  const auto start = clock_type::now();
+  for (auto& bot : bots)
+    bot->start(sdk, cache);
+
+  // Let every bot start before measuring
+  const auto settle_deadline = start + std::chrono::seconds(30);
+  while (clock_type::now() < settle_deadline &&
+         std::any_of(bots.begin(), bots.end(), [](const auto& bot) {
+           return !bot->failed() && !bot->startup_ms();
+         }))
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  const auto window_start = clock_type::now();
+  const double cpu_before = cpu_seconds();
+  std::this_thread::sleep_for(params.duration);
+  const auto window_end = clock_type::now();
+  const double cpu = cpu_seconds() - cpu_before;
+  const double rss = rss_mb();
+
+  std::vector<double> startup;
+  std::vector<double> pacing;
+  size_t failed = 0;
+  for (auto& bot : bots) {
+    bot->stop();
+    if (auto ms = bot->startup_ms())
+      startup.push_back(*ms);
+    else
+      ++failed;
+    auto errors = bot->injector().pacing_errors(window_start, window_end);
+    pacing.insert(pacing.end(), errors.begin(), errors.end());
+  }
+
+  const double window_s =
+      std::chrono::duration<double>(window_end - window_start).count();
+  const double cpu_percent = cpu / window_s / count * 100;
+  const double rss_per_bot = (rss - rss_before) / count;
+  const auto startup_dist = distribution::of(startup);
+  const auto pacing_dist = distribution::of(pacing);
+
+  std::cout << std::fixed << std::setprecision(2) << count << " bot(s): "
+            << cpu_percent << "% CPU and " << rss_per_bot
+            << "MB RSS per bot, startup p50 " << startup_dist.p50
+            << "ms max " << startup_dist.max << "ms, pacing error p99 "
+            << pacing_dist.p99 << "ms max " << pacing_dist.max << "ms";
+  if (failed)
+    std::cout << ", " << failed << " did not start";
+  std::cout << std::endl;
+
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3) << "{\"bots\": " << count
+       << ", \"cpu_percent_per_bot\": " << cpu_percent
+       << ", \"rss_mb_per_bot\": " << rss_per_bot
+       << ", \"startup_ms\": " << startup_dist.json()
+       << ", \"pacing_error_ms\": " << pacing_dist.json()
+       << ", \"frames\": " << pacing.size() << ", \"failed\": " << failed
+       << "}";
+  return json.str();
+}
+
+std::vector<int> parse_counts(const std::string& arg) {
+  std::vector<int> counts;
+  std::istringstream in(arg);
+  std::string item;
+  while (std::getline(in, item, ','))
+    counts.push_back(std::max(1, std::stoi(item)));
+  return counts;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bench_params params{};
+  commands_handler handler{};
+  handler.add_command_line_switch(
+      {"-c", "--conversations"},
+      "<dir>\n\tFolder of the conversations whose media is injected "
+      "(default: demo-content/conversations).",
+      [&params](const std::string& arg) { params.conversations = arg; });
+  handler.add_command_line_switch(
+      {"-bots", "--bots"},
+      "<n,n,...>\n\tNumbers of simulated bots of the runs (default: "
+      "1,10,100).",
+      [&params](const std::string& arg) {
+        params.bot_counts = parse_counts(arg);
+      });
+  handler.add_command_line_switch(
+      {"-duration", "--duration"},
+      "<seconds>\n\tMeasurement window of each run (default: 10).",
+      [&params](const std::string& arg) {
+        params.duration = std::chrono::seconds(std::max(1, std::stoi(arg)));
+      });
+  handler.add_command_line_switch(
+      {"-call-latency", "--call-latency"},
+      "<ms>\n\tLatency of each of the simulated SDK calls made while "
+      "joining (default: 0).",
+      [&params](const std::string& arg) {
+        params.call_latency = std::chrono::milliseconds(std::stoi(arg));
+      });
+  handler.add_command_line_switch(
+      {"-prepared", "--prepared"},
+      "\n\tUse the prepared assets (cpp_injection_prepare) of the media when "
+      "they exist.",
+      [&params]() { params.prepared = true; });
+  handler.add_command_line_switch(
+      {"-o", "--output"},
+      "<file>\n\tAlso write the results as JSON to the file.",
+      [&params](const std::string& arg) { params.output = arg; });
+
+  try {
+    handler.parse_command_line(argc, argv);
+    const auto media = collect_media(params.conversations);
+
+    std::ostringstream json;
+    json << "{\"decode\": " << bench_decode(media) << ", \"runs\": [";
+    for (size_t i = 0; i < params.bot_counts.size(); ++i)
+      json << (i ? ", " : "")
+           << bench_bots(params, media, params.bot_counts[i]);
+    json << "]}\n";
+
+    if (!params.output.empty()) {
+      std::ofstream out(params.output);
+      out << json.str();
+      if (!out)
+        throw std::runtime_error("Failed to write " + params.output);
+    }
+  } catch (const std::exception& ex) {
+    std::cerr << "Something went wrong: " << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
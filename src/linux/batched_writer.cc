@@ -0,0 +1,270 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/batched_writer.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+constexpr size_t page_size = 4096;
+// Staging buffers kept for reuse once written
+constexpr size_t max_free_buffers = 8;
+
+std::string segment_path(const std::string& prefix,
+                         unsigned index,
+                         const std::string& extension) {
+  char number[16];
+  std::snprintf(number, sizeof(number), ".%04u.", index);
+  return prefix + number + extension;
+}
+
+}  // namespace
+
+void batched_writer::buffer_deleter::operator()(uint8_t* data) const {
+  std::free(data);
+}
+
+batched_writer& batched_writer::instance() {
+  static batched_writer writer;
+  return writer;
+}
+
+batched_writer::batched_writer()
+    : written_(metrics::registry::instance().get_counter(
+          "recorder_written_bytes_total",
+          "Bytes of recorded media written to disk.")),
+      dropped_(metrics::registry::instance().get_counter(
+          "recorder_dropped_records_total",
+          "Records of media dropped because the disk could not keep up.")),
+      write_time_(metrics::registry::instance().get_histogram(
+          "recorder_write_seconds",
+          "Time spent writing a staging buffer to disk.")) {}
+
+batched_writer::~batched_writer() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    quit_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+std::shared_ptr<batched_writer::file> batched_writer::open(
+    std::string prefix,
+    std::string extension,
+    rotation policy) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!thread_.joinable())
+      thread_ = std::thread([this]() { run(); });
+  }
+  return std::make_shared<file>(*this, std::move(prefix), std::move(extension),
+                                policy);
+}
+
+batched_writer::buffer batched_writer::get_buffer() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!free_.empty()) {
+      auto data = std::move(free_.back());
+      free_.pop_back();
+      return data;
+    }
+  }
+  auto* data =
+      static_cast<uint8_t*>(std::aligned_alloc(page_size, buffer_size));
+  if (!data)
+    throw std::bad_alloc();
+  return buffer{data};
+}
+
+void batched_writer::submit(job&& work) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    jobs_.push_back(std::move(work));
+  }
+  cond_.notify_one();
+}
+
+void batched_writer::run() {
+  trace::set_thread_name("batched_writer");
+  std::unique_lock<std::mutex> lock(lock_);
+  for (;;) {
+    // Everything submitted is written before quitting
+    cond_.wait(lock, [this]() { return quit_ || !jobs_.empty(); });
+    if (jobs_.empty())
+      return;
+    auto work = std::move(jobs_.front());
+    jobs_.pop_front();
+    lock.unlock();
+    write(work);
+    lock.lock();
+    if (work.data && free_.size() < max_free_buffers)
+      free_.push_back(std::move(work.data));
+  }
+}
+
+void batched_writer::write(job& work) {
+  file& target = *work.target;
+  if (work.new_segment) {
+    if (target.fd_ >= 0)
+      ::close(target.fd_);
+    const std::string path =
+        segment_path(target.prefix_, ++target.index_, target.extension_);
+    // Never overwrites a recording, e.g. of another bot or a previous run
+    target.fd_ =
+        ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    target.offset_ = 0;
+    if (target.fd_ < 0)
+      std::cerr << "Failed to create " << path << ": " << strerror(errno)
+                << std::endl;
+  }
+
+  if (work.size > 0) {
+    if (target.fd_ >= 0) {
+      trace::scope scope("recorder", "write");
+      const auto start = std::chrono::steady_clock::now();
+      size_t done = 0;
+      while (done < work.size) {
+        const ssize_t ret = pwrite(target.fd_, work.data.get() + done,
+                                   work.size - done, target.offset_ + done);
+        if (ret < 0 && errno == EINTR)
+          continue;
+        if (ret <= 0) {
+          std::cerr << "Failed to write the recording: " << strerror(errno)
+                    << std::endl;
+          break;
+        }
+        done += ret;
+      }
+      target.offset_ += done;
+      written_.inc(done);
+      write_time_.observe(std::chrono::steady_clock::now() - start);
+    }
+    --target.pending_buffers_;
+  }
+
+  if (work.close && target.fd_ >= 0) {
+    ::close(target.fd_);
+    target.fd_ = -1;
+  }
+}
+
+batched_writer::file::file(batched_writer& writer,
+                           std::string prefix,
+                           std::string extension,
+                           rotation policy)
+    : writer_(writer),
+      prefix_(std::move(prefix)),
+      extension_(std::move(extension)),
+      policy_(policy) {
+  // The segments continue after the ones of a previous run
+  while (access(segment_path(prefix_, index_ + 1, extension_).c_str(), F_OK) ==
+         0)
+    ++index_;
+  segments_ = index_;
+}
+
+batched_writer::file::~file() {
+  // Only the writer thread is left holding the file, the segment has been
+  // closed already unless close() was not called.
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+void batched_writer::file::set_header(std::vector<uint8_t> header) {
+  header_ = std::move(header);
+}
+
+bool batched_writer::file::begin_record(size_t size, bool segment_start) {
+  const auto now = std::chrono::steady_clock::now();
+  if (segment_start && !new_segment_ &&
+      (segment_bytes_ + size > policy_.max_bytes ||
+       now - segment_start_ >= policy_.max_age)) {
+    flush(false);
+    new_segment_ = true;
+  }
+
+  // Nothing is written until a record which can start the segment
+  dropping_ = new_segment_ && !segment_start;
+  if (dropping_)
+    return false;
+  const size_t needed = (new_segment_ ? header_.size() : 0) + size;
+  if (pending_buffers_ + (staged_ + needed) / buffer_size >=
+      max_pending_buffers) {
+    writer_.dropped_.inc();
+    dropping_ = true;
+    return false;
+  }
+
+  if (new_segment_) {
+    new_segment_ = false;
+    starts_segment_ = true;
+    segment_bytes_ = header_.size();
+    segment_start_ = now;
+    ++segments_;
+    append(header_.data(), header_.size());
+  }
+  record_offset_ = segment_bytes_;
+  segment_bytes_ += size;
+  return true;
+}
+
+void batched_writer::file::append(const void* data, size_t size) {
+  if (dropping_)
+    return;
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    if (!staging_)
+      staging_ = writer_.get_buffer();
+    const size_t len = std::min(size, buffer_size - staged_);
+    std::memcpy(staging_.get() + staged_, bytes, len);
+    staged_ += len;
+    bytes += len;
+    size -= len;
+    if (staged_ == buffer_size)
+      flush(false);
+  }
+}
+
+void batched_writer::file::commit() {
+  flush(false);
+}
+
+void batched_writer::file::close() {
+  flush(true);
+  new_segment_ = true;
+}
+
+void batched_writer::file::flush(bool close) {
+  if (staged_ == 0 && !close)
+    return;
+  if (staged_ > 0)
+    ++pending_buffers_;
+  writer_.submit({shared_from_this(), std::move(staging_), staged_,
+                  starts_segment_, close});
+  staged_ = 0;
+  starts_segment_ = false;
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,155 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/metrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Writes the recorded media to disk from a single thread of the process, so
+ * that the media threads of the SDK never wait on the disk.
+ *
+ * The records appended to a file are copied into a staging buffer of 1MB,
+ * page aligned, which is handed to the writer thread once full and written
+ * with a single pwrite() at a page aligned offset. The files are rotated
+ * into numbered segments by size and age, on the record boundaries the
+ * caller allows (e.g. key frames). When the disk cannot keep up and a file
+ * has too much data waiting to be written, its new records are dropped
+ * rather than blocking the caller.
+ */
+class batched_writer {
+ public:
+  static constexpr size_t buffer_size = 1024 * 1024;
+  static constexpr size_t max_pending_buffers = 32;
+
+  struct rotation {
+    uint64_t max_bytes{256ull * 1024 * 1024};
+    std::chrono::seconds max_age{600};
+  };
+
+  class file;
+
+  static batched_writer& instance();
+
+  batched_writer();
+  ~batched_writer();
+
+  batched_writer(const batched_writer&) = delete;
+  batched_writer& operator=(const batched_writer&) = delete;
+
+  // Segments are named <prefix>.<index>.<extension>, numbered after the
+  // existing ones, the first file is only created by the first record.
+  std::shared_ptr<file> open(std::string prefix,
+                             std::string extension,
+                             rotation policy);
+
+ private:
+  struct buffer_deleter {
+    void operator()(uint8_t* data) const;
+  };
+  using buffer = std::unique_ptr<uint8_t, buffer_deleter>;
+
+  struct job {
+    std::shared_ptr<file> target;
+    buffer data;
+    size_t size;
+    bool new_segment;
+    bool close;
+  };
+
+  buffer get_buffer();
+  void submit(job&& work);
+  void run();
+  void write(job& work);
+
+  metrics::counter& written_;
+  metrics::counter& dropped_;
+  metrics::histogram& write_time_;
+
+  std::mutex lock_{};
+  std::condition_variable cond_{};
+  std::deque<job> jobs_{};
+  std::vector<buffer> free_{};
+  bool quit_{false};
+  std::thread thread_{};
+};
+
+class batched_writer::file
+    : public std::enable_shared_from_this<batched_writer::file> {
+ public:
+  file(batched_writer& writer,
+       std::string prefix,
+       std::string extension,
+       rotation policy);
+  ~file();
+
+  // Bytes written at the start of every segment, e.g. a container header.
+  void set_header(std::vector<uint8_t> header);
+
+  // Starts a record of the given size, to be written with append(). A new
+  // segment may only start with a record allowing it. Returns false if the
+  // record is dropped, its appends are ignored then.
+  bool begin_record(size_t size, bool segment_start = true);
+  void append(const void* data, size_t size);
+
+  // Segment of the last record begun, its index in the file names, and its
+  // offset in it.
+  unsigned segment() const { return segments_; }
+  uint64_t record_offset() const { return record_offset_; }
+
+  // Hands what is staged to the writer thread without waiting for a full
+  // buffer, for the data to be readable while the file is being recorded.
+  void commit();
+
+  // Writes what is staged and closes the current segment.
+  void close();
+
+ private:
+  friend class batched_writer;
+
+  void flush(bool close);
+
+  batched_writer& writer_;
+  const std::string prefix_;
+  const std::string extension_;
+  const rotation policy_;
+
+  // Producer side, appended from one thread at a time
+  std::vector<uint8_t> header_{};
+  buffer staging_{};
+  size_t staged_{0};
+  bool new_segment_{true};
+  bool starts_segment_{false};
+  bool dropping_{false};
+  uint64_t segment_bytes_{0};
+  unsigned segments_{0};
+  uint64_t record_offset_{0};
+  std::chrono::steady_clock::time_point segment_start_{};
+  std::atomic<size_t> pending_buffers_{0};
+
+  // Writer side
+  int fd_{-1};
+  unsigned index_{0};
+  uint64_t offset_{0};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,219 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/control_server.h"
+#include "utils/trace.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+constexpr size_t max_clients = 16;
+constexpr size_t max_line = 4096;
+// A client not reading its replies is not read from either past this
+constexpr size_t max_pending_replies = 64 * 1024;
+
+std::string trim(const std::string& s) {
+  const auto begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string::npos)
+    return {};
+  return s.substr(begin, s.find_last_not_of(" \t\r") - begin + 1);
+}
+
+}  // namespace
+
+std::unique_ptr<control_server> control_server::start(
+    event_loop& loop,
+    const std::string& log_dir,
+    handler&& on_command) {
+  if (log_dir.empty())
+    return nullptr;
+  try {
+    return std::make_unique<control_server>(loop, log_dir + "/control.sock",
+                                            std::move(on_command));
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << ", no control socket" << std::endl;
+    return nullptr;
+  }
+}
+
+control_server::control_server(event_loop& loop,
+                               const std::string& path,
+                               handler&& on_command)
+    : loop_(loop), path_(path), on_command_(std::move(on_command)) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    throw std::runtime_error("Control socket path too long: " + path);
+  std::strcpy(addr.sun_path, path.c_str());
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0)
+    throw std::runtime_error(std::string("Failed to create socket: ") +
+                             strerror(errno));
+  unlink(path.c_str());  // Left over by a previous run
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(listen_fd_, 8) < 0) {
+    const int err = errno;
+    close(listen_fd_);
+    throw std::runtime_error("Failed to listen on " + path + ": " +
+                             strerror(err));
+  }
+  loop_.watch(listen_fd_, EPOLLIN, [this](uint32_t) { accept_clients(); });
+}
+
+control_server::~control_server() {
+  for (const auto& [fd, c] : clients_) {
+    loop_.unwatch(fd);
+    close(fd);
+  }
+  loop_.unwatch(listen_fd_);
+  close(listen_fd_);
+  unlink(path_.c_str());
+}
+
+void control_server::accept_clients() {
+  for (;;) {
+    const int fd =
+        accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+      return;
+    if (clients_.size() >= max_clients) {
+      close(fd);
+      continue;
+    }
+    clients_.emplace(fd, client{});
+    loop_.watch(fd, EPOLLIN, [this, fd](uint32_t events) {
+      on_client_events(fd, events);
+    });
+  }
+}
+
+void control_server::on_client_events(int fd, uint32_t events) {
+  auto it = clients_.find(fd);
+  if (it == clients_.end())
+    return;
+  client& c = it->second;
+  bool open = true;
+  if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+    open = receive(fd, c);
+  if (open && !c.out.empty())
+    open = send_replies(fd, c);
+  if (!open) {
+    drop_client(fd);
+    return;
+  }
+  uint32_t interest = 0;
+  if (c.out.size() < max_pending_replies)
+    interest |= EPOLLIN;
+  if (!c.out.empty())
+    interest |= EPOLLOUT;
+  loop_.modify(fd, interest);
+}
+
+void control_server::drop_client(int fd) {
+  loop_.unwatch(fd);
+  close(fd);
+  clients_.erase(fd);
+}
+
+bool control_server::receive(int fd, client& c) {
+  char buf[4096];
+  bool open = true;
+  for (;;) {
+    const ssize_t len = recv(fd, buf, sizeof(buf), 0);
+    if (len > 0) {
+      c.in.append(buf, len);
+      continue;
+    }
+    if (len < 0 && errno == EINTR)
+      continue;
+    // Closed by the client, whose last commands are still answered
+    open = len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    break;
+  }
+
+  // All of the complete lines, their replies batched into a single send
+  size_t start = 0;
+  for (size_t end; (end = c.in.find('\n', start)) != std::string::npos;
+       start = end + 1) {
+    const auto line = trim(c.in.substr(start, end - start));
+    if (!line.empty())
+      c.out += run_command(line);
+  }
+  c.in.erase(0, start);
+  if (c.in.size() > max_line) {
+    c.out += "error line too long\n";
+    send_replies(fd, c);
+    return false;
+  }
+  if (!open)
+    send_replies(fd, c);
+  return open;
+}
+
+bool control_server::send_replies(int fd, client& c) {
+  while (!c.out.empty()) {
+    const ssize_t ret = send(fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return true;
+    if (ret <= 0)
+      return false;
+    c.out.erase(0, ret);
+  }
+  return true;
+}
+
+std::string control_server::run_command(const std::string& line) {
+  // Splits off the first word of the line
+  auto first_word = [](const std::string& s) {
+    const auto space = s.find_first_of(" \t");
+    if (space == std::string::npos)
+      return std::make_pair(s, std::string{});
+    return std::make_pair(s.substr(0, space), trim(s.substr(space)));
+  };
+  std::string bot;
+  auto [command, arg] = first_word(line);
+  if (command[0] == '@') {
+    bot = command.substr(1);
+    std::tie(command, arg) = first_word(arg);
+  }
+  if (command.empty())
+    return "error no command\n";
+
+  trace::scope scope("control", command);
+  std::optional<std::string> error;
+  try {
+    error = on_command_(bot, command, arg);
+  } catch (const std::exception& ex) {
+    error = ex.what();
+  }
+  if (!error)
+    return "ok\n";
+  // A reply is a single line
+  for (auto& ch : *error)
+    if (ch == '\n' || ch == '\r')
+      ch = ' ';
+  return "error " + *error + "\n";
+}
+
+}  // namespace dolbyio::comms::sample
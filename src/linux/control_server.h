@@ -0,0 +1,79 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/event_loop.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Runs the interactive commands of a daemonized process, whose stdin is
+ * /dev/null, received on a Unix socket next to its pid file, e.g.:
+ *
+ *   printf 'p\ns 30\nr\n' | socat - UNIX-CONNECT:<log dir>/control.sock
+ *
+ * Every line is a command, "[@<bot>] <command> [<argument>]", where the
+ * argument is the rest of the line and the bot defaults to all of them. A
+ * client may send any number of commands without waiting for the replies:
+ * they are run in order, one at a time whatever the client, and each gets a
+ * reply line in order, "ok" or "error <reason>". The replies to commands
+ * received together are sent together. Empty lines are ignored.
+ *
+ * The server runs on the event loop of the process, so the commands run on
+ * its thread, like the ones typed on stdin when not daemonized.
+ */
+class control_server {
+ public:
+  using handler = std::function<std::optional<std::string>(
+      const std::string& bot,
+      const std::string& command,
+      const std::string& arg)>;
+
+  // Starts the server on <log_dir>/control.sock, null if there is no log
+  // directory or the socket cannot be created.
+  static std::unique_ptr<control_server> start(event_loop& loop,
+                                               const std::string& log_dir,
+                                               handler&& on_command);
+
+  control_server(event_loop& loop,
+                 const std::string& path,
+                 handler&& on_command);
+  ~control_server();
+
+  control_server(const control_server&) = delete;
+  control_server& operator=(const control_server&) = delete;
+
+ private:
+  struct client {
+    std::string in;
+    std::string out;
+  };
+
+  void accept_clients();
+  void on_client_events(int fd, uint32_t events);
+  bool receive(int fd, client& c);
+  bool send_replies(int fd, client& c);
+  void drop_client(int fd);
+  std::string run_command(const std::string& line);
+
+  event_loop& loop_;
+  std::string path_;
+  handler on_command_;
+  int listen_fd_{-1};
+  std::map<int, client> clients_{};
+};
+
+}  // namespace dolbyio::comms::sample
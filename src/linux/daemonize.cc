@@ -12,37 +12,45 @@
 #include <fstream>
 
 #include <fcntl.h>
-#include <signal.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 namespace dolbyio::comms::sample {
 
-daemonize::daemonize(const std::string &log_dir) {
-  // Initialize semaphore with 0 used for indefinite wait
-  sem_init(&semaphore_, 0, 0);
-
-  pid_t pid;
-  pid = fork();
-  parent_exit(pid);
-
-  // Make the child the new session leader
-  if (setsid() < 0)
-    throw daemon::failure_exception();
-
-  pid = fork();
-  parent_exit(pid);
-
-  // Now we are in the child solely, close all descriptiors
-  int open_max;
-  for (open_max = sysconf(_SC_OPEN_MAX); open_max >= 0; open_max--)
-    close(open_max);
-
-  // Make sure all std fd's are at dev null
-  open("/dev/null", O_RDONLY);
-  open("/dev/null", O_WRONLY);
-  open("/dev/null", O_WRONLY);
+daemonize::daemonize(const std::string &log_dir, daemon::mode mode) {
+  if (mode == daemon::mode::foreground)
+    return;
+
+  if (mode == daemon::mode::detach) {
+    pid_t pid;
+    pid = fork();
+    parent_exit(pid);
+
+    // Make the child the new session leader
+    if (setsid() < 0)
+      throw daemon::failure_exception();
+
+    pid = fork();
+    parent_exit(pid);
+
+    // Now we are in the child solely, close all descriptiors
+    int open_max;
+    for (open_max = sysconf(_SC_OPEN_MAX); open_max >= 0; open_max--)
+      close(open_max);
+
+    // Make sure all std fd's are at dev null
+    open("/dev/null", O_RDONLY);
+    open("/dev/null", O_WRONLY);
+    open("/dev/null", O_WRONLY);
+  } else {
+    // The zygote connection stays open, only the std fd's are redirected
+    int null_fd = open("/dev/null", O_RDWR);
+    for (int fd = 0; fd <= 2; ++fd)
+      dup2(null_fd, fd);
+    if (null_fd > 2)
+      close(null_fd);
+  }
 
   pid_ = getpid();
   pid_file_ = log_dir + "/pid";
@@ -51,20 +59,14 @@ daemonize::daemonize(const std::string &log_dir) {
 }
 
 daemonize::~daemonize() {
+  if (pid_file_.empty())
+    return;
   close(0);
   close(1);
   close(2);
   remove(pid_file_.c_str());
 }
 
-void daemonize::wait_indefinitely() {
-  sem_wait(&semaphore_);
-}
-
-void daemonize::unblock_indefinte_wait() {
-  sem_post(&semaphore_);
-}
-
 void daemonize::parent_exit(pid_t pid) {
   if (pid < 0)
     throw daemon::failure_exception();
@@ -9,7 +9,7 @@
  *                Copyright (C) 2022-2023 by Dolby Laboratories.
  ***************************************************************************/
 
-#include <semaphore.h>
+#include <sys/types.h>
 #include <exception>
 #include <string>
 
@@ -21,21 +21,24 @@ namespace daemon {
 class parent_process_exception : std::exception {};
 
 class failure_exception : std::exception {};
+
+enum class mode {
+  detach,      // Double fork into a new session
+  foreground,  // Supervised by the orchestrator, no pid file either
+  forked,      // Already forked into its own session by the zygote
+};
 }  // namespace daemon
 
 class daemonize {
  public:
-  explicit daemonize(const std::string& log_dir);
+  explicit daemonize(const std::string& log_dir,
+                     daemon::mode mode = daemon::mode::detach);
   ~daemonize();
 
-  void wait_indefinitely();
-  void unblock_indefinte_wait();
-
  private:
   void parent_exit(pid_t pid);
   pid_t pid_{-1};
   std::string pid_file_{};
-  sem_t semaphore_{};
 };
 
 }  // namespace dolbyio::comms::sample
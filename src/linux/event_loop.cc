@@ -0,0 +1,198 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/event_loop.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+constexpr int max_events = 32;
+
+sigset_t termination_signals() {
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGINT);
+  sigaddset(&set, SIGTERM);
+  return set;
+}
+
+timespec to_timespec(std::chrono::nanoseconds ns) {
+  timespec ts{};
+  ts.tv_sec = ns.count() / 1000000000;
+  ts.tv_nsec = ns.count() % 1000000000;
+  return ts;
+}
+
+std::runtime_error system_error(const std::string& what) {
+  return std::runtime_error(what + ": " + strerror(errno));
+}
+
+}  // namespace
+
+void event_loop::block_signals() {
+  const sigset_t set = termination_signals();
+  pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+event_loop::event_loop() {
+  const sigset_t set = termination_signals();
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  signal_fd_ = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd_ < 0 || signal_fd_ < 0 || wake_fd_ < 0)
+    throw system_error("Failed to create the event loop");
+
+  watch(signal_fd_, EPOLLIN, [this](uint32_t) {
+    signalfd_siginfo info{};
+    while (read(signal_fd_, &info, sizeof(info)) == sizeof(info)) {
+      std::cerr << "Received " << strsignal(info.ssi_signo) << ", exiting"
+                << std::endl;
+      quit_ = true;
+    }
+  });
+  watch(wake_fd_, EPOLLIN, [this](uint32_t) {
+    uint64_t count = 0;
+    [[maybe_unused]] auto ret = read(wake_fd_, &count, sizeof(count));
+    run_posted();
+  });
+}
+
+event_loop::~event_loop() {
+  for (const auto& [key, w] : watchers_)
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, w.fd, nullptr);
+  close(wake_fd_);
+  close(signal_fd_);
+  close(epoll_fd_);
+}
+
+void event_loop::watch(int fd, uint32_t events, fd_cb cb) {
+  const uint64_t key = next_key_++;
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.u64 = key;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0)
+    throw system_error("Failed to watch descriptor " + std::to_string(fd));
+  watchers_[key] = {fd, std::make_shared<fd_cb>(std::move(cb))};
+  keys_[fd] = key;
+}
+
+void event_loop::modify(int fd, uint32_t events) {
+  auto it = keys_.find(fd);
+  if (it == keys_.end())
+    return;
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.u64 = it->second;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0)
+    throw system_error("Failed to watch descriptor " + std::to_string(fd));
+}
+
+void event_loop::unwatch(int fd) {
+  auto it = keys_.find(fd);
+  if (it == keys_.end())
+    return;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  watchers_.erase(it->second);
+  keys_.erase(it);
+}
+
+std::shared_ptr<void> event_loop::add_timer(clock::duration period,
+                                            std::function<void()> cb) {
+  const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0)
+    throw system_error("Failed to create a timer");
+  itimerspec spec{};
+  spec.it_value = spec.it_interval = to_timespec(period);
+  if (timerfd_settime(fd, 0, &spec, nullptr) < 0) {
+    close(fd);
+    throw system_error("Failed to arm a timer");
+  }
+  watch(fd, EPOLLIN, [fd, cb{std::move(cb)}](uint32_t) {
+    uint64_t expired = 0;
+    if (read(fd, &expired, sizeof(expired)) == sizeof(expired))
+      cb();
+  });
+  return std::shared_ptr<void>(nullptr, [this, fd](void*) {
+    unwatch(fd);
+    close(fd);
+  });
+}
+
+void event_loop::post(std::function<void()> cb) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    posted_.push_back(std::move(cb));
+  }
+  const uint64_t one = 1;
+  [[maybe_unused]] auto ret = write(wake_fd_, &one, sizeof(one));
+}
+
+void event_loop::stop() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    stopped_ = true;
+  }
+  const uint64_t one = 1;
+  [[maybe_unused]] auto ret = write(wake_fd_, &one, sizeof(one));
+}
+
+void event_loop::run_posted() {
+  std::vector<std::function<void()>> posted;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    posted.swap(posted_);
+    if (stopped_)
+      quit_ = true;
+  }
+  for (auto& cb : posted)
+    cb();
+}
+
+void event_loop::run() {
+  // Work posted before the loop was run, e.g. a stop
+  run_posted();
+  epoll_event events[max_events];
+  while (!quit_) {
+    const int count = epoll_wait(epoll_fd_, events, max_events, -1);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      std::cerr << "Event loop failed: " << strerror(errno) << std::endl;
+      return;
+    }
+    for (int i = 0; i < count && !quit_; ++i) {
+      // Unwatched by an earlier callback of this batch
+      auto it = watchers_.find(events[i].data.u64);
+      if (it == watchers_.end())
+        continue;
+      // Kept alive in case the callback unwatches its own descriptor
+      auto cb = it->second.cb;
+      try {
+        (*cb)(events[i].events);
+      } catch (const std::exception& ex) {
+        std::cerr << "Event loop callback failed: " << ex.what() << std::endl;
+      }
+    }
+  }
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,91 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Main loop of a bot process, multiplexing with epoll everything the main
+ * thread waits for once the bots have joined: the termination signals
+ * through a signalfd, timers through timerfds, sockets, and work posted from
+ * the SDK threads through an eventfd. The callbacks all run on the thread
+ * calling run(), one at a time, so the state they share needs no locking.
+ *
+ * Only post() and stop() may be called from other threads, everything else
+ * is called from the loop thread or before run().
+ */
+class event_loop {
+ public:
+  using clock = std::chrono::steady_clock;
+  // Gets the epoll events of the descriptor
+  using fd_cb = std::function<void(uint32_t events)>;
+
+  // Blocks SIGINT and SIGTERM in the calling thread, and so in the threads
+  // it starts afterwards, so that they are only received by the signalfd of
+  // the loop. To be called before any thread is started.
+  static void block_signals();
+
+  event_loop();
+  ~event_loop();
+
+  event_loop(const event_loop&) = delete;
+  event_loop& operator=(const event_loop&) = delete;
+
+  // Runs the callback whenever the descriptor, owned by the caller, is ready
+  // for any of the events, until it is unwatched.
+  void watch(int fd, uint32_t events, fd_cb cb);
+  void modify(int fd, uint32_t events);
+  void unwatch(int fd);
+
+  // Runs the callback every period, until the returned token is dropped.
+  // Expirations missed because the loop was busy are run only once.
+  std::shared_ptr<void> add_timer(clock::duration period,
+                                  std::function<void()> cb);
+
+  // Runs the callback on the loop thread, from any thread.
+  void post(std::function<void()> cb);
+
+  // Runs until stop() is called, from any thread, or until SIGINT or SIGTERM
+  // is received.
+  void run();
+  void stop();
+
+ private:
+  struct watcher {
+    int fd;
+    std::shared_ptr<fd_cb> cb;
+  };
+
+  void run_posted();
+
+  int epoll_fd_{-1};
+  int signal_fd_{-1};
+  int wake_fd_{-1};
+  // By a key of their own, as a descriptor may be closed and reused by the
+  // callbacks of the events being dispatched.
+  std::map<uint64_t, watcher> watchers_{};
+  std::map<int, uint64_t> keys_{};
+  uint64_t next_key_{1};
+  bool quit_{false};
+
+  std::mutex lock_{};
+  std::vector<std::function<void()>> posted_{};
+  bool stopped_{false};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,72 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/file_watcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+file_watcher::file_watcher(event_loop& loop,
+                           const std::string& path,
+                           std::function<void()> on_change)
+    : loop_(loop), on_change_(std::move(on_change)) {
+  const std::filesystem::path file{path};
+  name_ = file.filename().string();
+  auto folder = file.parent_path().string();
+  if (folder.empty())
+    folder = ".";
+
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0)
+    throw std::runtime_error(std::string("Failed to create inotify: ") +
+                             strerror(errno));
+  if (inotify_add_watch(inotify_fd_, folder.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    const int err = errno;
+    close(inotify_fd_);
+    throw std::runtime_error("Failed to watch " + folder + ": " +
+                             strerror(err));
+  }
+  loop_.watch(inotify_fd_, EPOLLIN, [this](uint32_t) { read_events(); });
+}
+
+file_watcher::~file_watcher() {
+  loop_.unwatch(inotify_fd_);
+  close(inotify_fd_);
+}
+
+void file_watcher::read_events() {
+  alignas(inotify_event) char buf[4096];
+  bool changed = false;
+  for (;;) {
+    const ssize_t len = read(inotify_fd_, buf, sizeof(buf));
+    if (len < 0 && errno == EINTR)
+      continue;
+    if (len <= 0)
+      break;
+    for (ssize_t pos = 0; pos < len;) {
+      const auto* ev = reinterpret_cast<const inotify_event*>(buf + pos);
+      if (ev->len && name_ == ev->name)
+        changed = true;
+      pos += sizeof(inotify_event) + ev->len;
+    }
+  }
+  if (changed)
+    on_change_();
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,44 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/event_loop.h"
+
+#include <functional>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Calls back on the event loop when a file has been written, with inotify.
+ * The folder of the file is watched rather than the file itself, so that
+ * the file is still followed once replaced by an editor saving it under
+ * another name and renaming it. The changes read together are reported once.
+ */
+class file_watcher {
+ public:
+  file_watcher(event_loop& loop,
+               const std::string& path,
+               std::function<void()> on_change);
+  ~file_watcher();
+
+  file_watcher(const file_watcher&) = delete;
+  file_watcher& operator=(const file_watcher&) = delete;
+
+ private:
+  void read_events();
+
+  event_loop& loop_;
+  std::string name_;
+  std::function<void()> on_change_;
+  int inotify_fd_{-1};
+};
+
+}  // namespace dolbyio::comms::sample
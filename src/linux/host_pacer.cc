@@ -0,0 +1,164 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/host_pacer.h"
+#include "utils/trace.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// The steady_clock of libstdc++ and libc++ is CLOCK_MONOTONIC, so its time
+// points are passed to the timerfd as they are.
+timespec to_timespec(std::chrono::nanoseconds ns) {
+  timespec ts{};
+  ts.tv_sec = ns.count() / 1000000000;
+  ts.tv_nsec = ns.count() % 1000000000;
+  return ts;
+}
+
+std::vector<double> lateness_buckets() {
+  return {0.00005, 0.0001, 0.00025, 0.0005, 0.001,
+          0.0025,  0.005,  0.01,    0.025,  0.05};
+}
+
+}  // namespace
+
+host_pacer& host_pacer::instance() {
+  static host_pacer pacer;
+  return pacer;
+}
+
+host_pacer::host_pacer()
+    : lateness_(metrics::registry::instance().get_histogram(
+          "pacer_tick_lateness_seconds",
+          "Delay between the ticks of the host pacer and its wake ups.",
+          {},
+          lateness_buckets())),
+      tick_duration_(metrics::registry::instance().get_histogram(
+          "pacer_tick_duration_seconds",
+          "Time spent injecting the frames of all of the bots on a tick.",
+          {},
+          lateness_buckets())),
+      jitter_(metrics::registry::instance().get_gauge(
+          "pacer_jitter_seconds",
+          "Smoothed variation of the lateness of the host pacer wake ups.")),
+      wakeups_(metrics::registry::instance().get_counter(
+          "pacer_wakeups_total",
+          "Wake ups of the host pacer thread.")),
+      missed_(metrics::registry::instance().get_counter(
+          "pacer_missed_ticks_total",
+          "Ticks of the host pacer skipped because it woke up too late.")) {}
+
+host_pacer::~host_pacer() {
+  if (!thread_.joinable())
+    return;
+  const uint64_t one = 1;
+  [[maybe_unused]] auto ret = write(wake_fd_, &one, sizeof(one));
+  thread_.join();
+  close(timer_fd_);
+  close(wake_fd_);
+}
+
+std::shared_ptr<void> host_pacer::add(tick_cb cb) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!thread_.joinable()) {
+    timer_fd_ =
+        timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (timer_fd_ < 0 || wake_fd_ < 0)
+      throw std::runtime_error(std::string("Failed to create the pacer: ") +
+                               strerror(errno));
+    thread_ = std::thread([this]() { run(); });
+  }
+  if (callbacks_.empty())
+    arm(true);
+  const uint64_t id = next_id_++;
+  callbacks_.emplace(id, std::move(cb));
+  return std::shared_ptr<void>(nullptr, [this, id](void*) { remove(id); });
+}
+
+void host_pacer::remove(uint64_t id) {
+  // Taking the lock waits for the tick being run
+  std::lock_guard<std::mutex> lock(lock_);
+  callbacks_.erase(id);
+  if (callbacks_.empty())
+    arm(false);
+}
+
+void host_pacer::arm(bool enable) {
+  itimerspec spec{};
+  if (enable) {
+    first_tick_ = clock::now() + period;
+    expirations_ = 0;
+    spec.it_value = to_timespec(first_tick_.time_since_epoch());
+    spec.it_interval = to_timespec(period);
+  }
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) < 0)
+    std::cerr << "Failed to arm the pacer: " << strerror(errno) << std::endl;
+}
+
+void host_pacer::run() {
+  trace::set_thread_name("host_pacer");
+  for (;;) {
+    pollfd fds[] = {{timer_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      std::cerr << "Host pacer failed: " << strerror(errno) << std::endl;
+      return;
+    }
+    if (fds[1].revents)
+      return;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    // Nothing to read if the timer has been disarmed or rearmed meanwhile
+    uint64_t expired = 0;
+    if (read(timer_fd_, &expired, sizeof(expired)) != sizeof(expired))
+      continue;
+    const auto woke = clock::now();
+    expirations_ += expired;
+    const auto tick = first_tick_ + period * (expirations_ - 1);
+
+    wakeups_.inc();
+    if (expired > 1)
+      missed_.inc(expired - 1);
+    const double lateness = std::chrono::duration<double>(woke - tick).count();
+    lateness_.observe(lateness);
+    // Interarrival jitter estimator of RFC 3550, applied to the lateness
+    jitter_estimate_ +=
+        (std::abs(lateness - last_lateness_) - jitter_estimate_) / 16;
+    last_lateness_ = lateness;
+    jitter_.set(jitter_estimate_);
+
+    trace::scope scope("pacing", "host tick");
+    for (auto& [id, cb] : callbacks_) {
+      // A failing player does not stop the ticks of the others
+      try {
+        cb(tick);
+      } catch (const std::exception& ex) {
+        std::cerr << "Host tick callback failed: " << ex.what() << std::endl;
+      }
+    }
+    tick_duration_.observe(clock::now() - woke);
+  }
+}
+
+}  // namespace dolbyio::comms::sample
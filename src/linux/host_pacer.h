@@ -0,0 +1,78 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/metrics.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Process wide media clock: a single thread woken every 10ms by a timerfd
+ * on CLOCK_MONOTONIC runs the tick callbacks of all of the bots of the
+ * process, instead of every bot sleeping on its own. The callbacks get the
+ * time of the tick, not the time of the wake up, and inject the frames due
+ * by then. Ticks which are missed because the thread was late are not
+ * replayed, the callbacks catch up from the next one.
+ *
+ * The lateness of the wake ups, its jitter and the time spent in the
+ * callbacks are exported in the metrics registry.
+ */
+class host_pacer {
+ public:
+  using clock = std::chrono::steady_clock;
+  using tick_cb = std::function<void(clock::time_point)>;
+  static constexpr std::chrono::milliseconds period{10};
+
+  static host_pacer& instance();
+
+  host_pacer();
+  ~host_pacer();
+
+  host_pacer(const host_pacer&) = delete;
+  host_pacer& operator=(const host_pacer&) = delete;
+
+  // Runs the callback on every tick until the returned token is dropped.
+  // Dropping the token waits for a running tick to complete, so it must not
+  // be dropped from a callback. The thread is started by the first
+  // callback, so that a process can fork before using it.
+  std::shared_ptr<void> add(tick_cb cb);
+
+ private:
+  void remove(uint64_t id);
+  void arm(bool enable);
+  void run();
+
+  metrics::histogram& lateness_;
+  metrics::histogram& tick_duration_;
+  metrics::gauge& jitter_;
+  metrics::counter& wakeups_;
+  metrics::counter& missed_;
+
+  std::mutex lock_{};
+  std::map<uint64_t, tick_cb> callbacks_{};
+  uint64_t next_id_{1};
+  clock::time_point first_tick_{};
+  uint64_t expirations_{0};
+  double last_lateness_{0};
+  double jitter_estimate_{0};
+  int timer_fd_{-1};
+  int wake_fd_{-1};
+  std::thread thread_{};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,133 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/metrics_server.h"
+#include "utils/metrics.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// A slow client must not stall the server for long
+constexpr int request_timeout_ms = 1000;
+
+std::string configured_path{};
+
+void write_all(int fd, const std::string& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t ret =
+        send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return;
+    written += ret;
+  }
+}
+
+}  // namespace
+
+void metrics_server::configure(const std::string& path) {
+  configured_path = path;
+}
+
+std::unique_ptr<metrics_server> metrics_server::start_configured() {
+  if (configured_path.empty())
+    return nullptr;
+  return std::make_unique<metrics_server>(configured_path);
+}
+
+metrics_server::metrics_server(const std::string& path) : path_(path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    throw std::runtime_error("Metrics socket path too long: " + path);
+  std::strcpy(addr.sun_path, path.c_str());
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  wake_fd_ = eventfd(0, EFD_CLOEXEC);
+  if (listen_fd_ < 0 || wake_fd_ < 0)
+    throw std::runtime_error(std::string("Failed to create socket: ") +
+                             strerror(errno));
+  unlink(path.c_str());  // Left over by a previous run
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(listen_fd_, 8) < 0) {
+    const int err = errno;
+    close(listen_fd_);
+    close(wake_fd_);
+    throw std::runtime_error("Failed to listen on " + path + ": " +
+                             strerror(err));
+  }
+  thread_ = std::thread([this]() { run(); });
+}
+
+metrics_server::~metrics_server() {
+  const uint64_t one = 1;
+  [[maybe_unused]] auto ret = write(wake_fd_, &one, sizeof(one));
+  thread_.join();
+  close(listen_fd_);
+  close(wake_fd_);
+  unlink(path_.c_str());
+}
+
+void metrics_server::run() {
+  for (;;) {
+    pollfd fds[] = {{listen_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      std::cerr << "Metrics server failed: " << strerror(errno) << std::endl;
+      return;
+    }
+    if (fds[1].revents)
+      return;
+    const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0)
+      continue;
+    serve(fd);
+    close(fd);
+  }
+}
+
+void metrics_server::serve(int fd) {
+  // Read the request header, its content does not matter
+  std::string request;
+  char buf[512];
+  while (request.find("\r\n\r\n") == std::string::npos &&
+         request.size() < 8192) {
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, request_timeout_ms) <= 0)
+      return;
+    const ssize_t len = recv(fd, buf, sizeof(buf), 0);
+    if (len <= 0)
+      return;
+    request.append(buf, len);
+  }
+
+  const auto body = metrics::registry::instance().render();
+  write_all(fd,
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Content-Length: " +
+                std::to_string(body.size()) + "\r\n\r\n" + body);
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,50 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Serves the metrics registry in the Prometheus text format over HTTP on a
+ * Unix socket, e.g.:
+ *
+ *   curl --unix-socket <path> http://localhost/metrics
+ *
+ * Every request gets the metrics, whatever its path.
+ */
+class metrics_server {
+ public:
+  // Socket path requested on the command line (--metrics-socket), shared by
+  // all of the bots of the process.
+  static void configure(const std::string& path);
+  // Starts the server on the configured socket, null if none is configured.
+  static std::unique_ptr<metrics_server> start_configured();
+
+  explicit metrics_server(const std::string& path);
+  ~metrics_server();
+
+  metrics_server(const metrics_server&) = delete;
+  metrics_server& operator=(const metrics_server&) = delete;
+
+ private:
+  void run();
+  void serve(int fd);
+
+  std::string path_;
+  int listen_fd_{-1};
+  int wake_fd_{-1};
+  std::thread thread_{};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,360 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/process_supervisor.h"
+#include "linux/zygote.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+constexpr std::chrono::seconds max_backoff{30};
+
+// Self pipe waking up the supervisor loop from the signal handler
+int wake_pipe[2] = {-1, -1};
+volatile sig_atomic_t stop_requested = 0;
+
+void signal_handler(int sig) {
+  if (sig != SIGCHLD)
+    stop_requested = 1;
+  const int saved_errno = errno;
+  const char byte = 0;
+  [[maybe_unused]] auto ret = write(wake_pipe[1], &byte, 1);
+  errno = saved_errno;
+}
+
+void drain(int fd) {
+  char buf[64];
+  while (read(fd, buf, sizeof(buf)) > 0) {
+  }
+}
+
+std::string describe_status(int status) {
+  if (WIFEXITED(status))
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+  if (WIFSIGNALED(status))
+    return std::string("killed by signal ") + strsignal(WTERMSIG(status));
+  return "stopped";
+}
+
+}  // namespace
+
+void process_supervisor::notify_ready() {
+  const char* env = getenv(ready_fd_env);
+  if (!env)
+    return;
+  const int fd = atoi(env);
+  const char byte = 1;
+  [[maybe_unused]] auto ret = write(fd, &byte, 1);
+  close(fd);
+  unsetenv(ready_fd_env);
+}
+
+process_supervisor::process_supervisor(const config& cfg) : config_(cfg) {
+  if (wake_pipe[0] >= 0)
+    throw std::runtime_error("Only one process supervisor may exist");
+  if (pipe2(wake_pipe, O_CLOEXEC | O_NONBLOCK) < 0)
+    throw std::runtime_error(std::string("Failed to create pipe: ") +
+                             strerror(errno));
+
+  struct sigaction action {};
+  action.sa_handler = signal_handler;
+  action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  sigemptyset(&action.sa_mask);
+  for (int sig : {SIGCHLD, SIGINT, SIGTERM})
+    sigaction(sig, &action, nullptr);
+}
+
+process_supervisor::~process_supervisor() {
+  stop_all();
+  for (int sig : {SIGCHLD, SIGINT, SIGTERM})
+    signal(sig, SIG_DFL);
+  close(wake_pipe[0]);
+  close(wake_pipe[1]);
+  wake_pipe[0] = wake_pipe[1] = -1;
+}
+
+void process_supervisor::add(process_spec spec) {
+  children_.push_back(child{std::move(spec)});
+}
+
+void process_supervisor::run() {
+  std::cerr << "Launching " << children_.size() << " process(es), "
+            << config_.max_parallel_starts << " at a time" << std::endl;
+  while (!stop_requested) {
+    reap();
+    start_pending();
+    if (all_done())
+      return;
+    wait_for_events();
+  }
+  std::cerr << "Stopping all processes" << std::endl;
+  stop_all();
+}
+
+void process_supervisor::launch(child& proc) {
+  std::error_code ec;
+  std::filesystem::create_directories(proc.spec.log_dir, ec);
+
+  if (!config_.zygote_socket.empty()) {
+    const std::vector<std::string> args{proc.spec.argv.begin() + 1,
+                                        proc.spec.argv.end()};
+    const auto conn = zygote::spawn(config_.zygote_socket, args);
+    fcntl(conn.fd, F_SETFL, O_NONBLOCK);
+    started(proc, conn.pid, conn.fd);
+    return;
+  }
+
+  int ready[2];
+  if (pipe2(ready, O_CLOEXEC) < 0)
+    throw std::runtime_error(std::string("Failed to create pipe: ") +
+                             strerror(errno));
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    close(ready[0]);
+    close(ready[1]);
+    throw std::runtime_error(std::string("Failed to fork: ") +
+                             strerror(errno));
+  }
+  if (pid == 0) {
+    // Own process group, so that a Ctrl-C in the terminal only reaches the
+    // supervisor which then stops the processes in order.
+    setpgid(0, 0);
+    const int ready_fd = dup(ready[1]);  // Without O_CLOEXEC
+    setenv(ready_fd_env, std::to_string(ready_fd).c_str(), 1);
+    const auto output = proc.spec.log_dir + "/output.log";
+    const int out = open(output.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (out >= 0) {
+      dup2(out, STDOUT_FILENO);
+      dup2(out, STDERR_FILENO);
+      close(out);
+    }
+    std::vector<char*> argv;
+    for (const auto& arg : proc.spec.argv)
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+
+  close(ready[1]);
+  fcntl(ready[0], F_SETFL, O_NONBLOCK);
+  started(proc, pid, ready[0]);
+}
+
+void process_supervisor::started(child& proc, pid_t pid, int channel) {
+  proc.pid = pid;
+  proc.channel = channel;
+  proc.current = state::starting;
+  proc.started = clock::now();
+  proc.deadline = proc.started + config_.start_timeout;
+  ++starting_;
+}
+
+void process_supervisor::reap() {
+  int status = 0;
+  pid_t pid;
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    auto it = std::find_if(children_.begin(), children_.end(),
+                           [pid](const child& c) { return c.pid == pid; });
+    if (it != children_.end())
+      on_exit(*it, status);
+  }
+}
+
+void process_supervisor::on_exit(child& proc, int status) {
+  if (proc.current == state::starting)
+    --starting_;
+  close_channel(proc);
+  proc.pid = -1;
+
+  if (stopping_ || (WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+    std::cerr << proc.spec.name << " has " << describe_status(status)
+              << std::endl;
+    proc.current = state::exited;
+    return;
+  }
+
+  const auto now = clock::now();
+  if (now - proc.started > config_.stable_after)
+    proc.restarts = 0;
+  if (proc.restarts >= config_.max_restarts) {
+    std::cerr << proc.spec.name << " has " << describe_status(status)
+              << ", giving up after " << proc.restarts << " restart(s)"
+              << std::endl;
+    proc.current = state::failed;
+    return;
+  }
+  const auto backoff = std::min<std::chrono::seconds>(
+      std::chrono::seconds(1 << std::min(proc.restarts, 5)), max_backoff);
+  ++proc.restarts;
+  std::cerr << proc.spec.name << " has " << describe_status(status)
+            << ", restarting in " << backoff.count() << "s" << std::endl;
+  proc.current = state::backoff;
+  proc.deadline = now + backoff;
+}
+
+void process_supervisor::mark_running(child& proc, const char* why) {
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      clock::now() - proc.started);
+  std::cerr << proc.spec.name << " (pid " << proc.pid << ") " << why
+            << " after " << elapsed.count() << "ms" << std::endl;
+  // The zygote connection also reports the exit of the process
+  if (config_.zygote_socket.empty())
+    close_channel(proc);
+  proc.current = state::running;
+  --starting_;
+}
+
+void process_supervisor::close_channel(child& proc) {
+  if (proc.channel >= 0)
+    close(proc.channel);
+  proc.channel = -1;
+}
+
+void process_supervisor::start_pending() {
+  const auto now = clock::now();
+  for (auto& proc : children_) {
+    if (starting_ >= config_.max_parallel_starts)
+      return;
+    const bool due = proc.current == state::pending ||
+                     (proc.current == state::backoff && proc.deadline <= now);
+    if (!due)
+      continue;
+    try {
+      launch(proc);
+    } catch (const std::exception& ex) {
+      std::cerr << "Failed to launch " << proc.spec.name << ": " << ex.what()
+                << std::endl;
+      proc.current = state::failed;
+    }
+  }
+}
+
+bool process_supervisor::all_done() const {
+  return std::all_of(children_.begin(), children_.end(), [](const child& c) {
+    return c.current == state::exited || c.current == state::failed;
+  });
+}
+
+int process_supervisor::poll_timeout_ms() const {
+  auto next = clock::time_point::max();
+  for (const auto& proc : children_)
+    if (proc.current == state::starting || proc.current == state::backoff)
+      next = std::min(next, proc.deadline);
+  if (next == clock::time_point::max())
+    return -1;
+  const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+      next - clock::now());
+  return static_cast<int>(std::max<int64_t>(wait.count(), 0)) + 1;
+}
+
+void process_supervisor::wait_for_events() {
+  poll_channels(poll_timeout_ms());
+
+  // Do not hold the start slot forever, slow joins are not fatal
+  const auto now = clock::now();
+  for (auto& proc : children_)
+    if (proc.current == state::starting && proc.deadline <= now)
+      mark_running(proc, "did not report being ready");
+}
+
+void process_supervisor::poll_channels(int timeout_ms) {
+  std::vector<pollfd> fds{{wake_pipe[0], POLLIN, 0}};
+  for (const auto& proc : children_)
+    if (proc.channel >= 0)
+      fds.push_back({proc.channel, POLLIN, 0});
+
+  if (poll(fds.data(), fds.size(), timeout_ms) < 0 && errno != EINTR)
+    throw std::runtime_error(std::string("poll failed: ") + strerror(errno));
+  drain(wake_pipe[0]);
+
+  for (auto& proc : children_) {
+    auto fd = std::find_if(fds.begin() + 1, fds.end(), [&](const pollfd& p) {
+      return p.fd == proc.channel;
+    });
+    if (fd != fds.end() && fd->revents)
+      read_channel(proc);
+  }
+}
+
+void process_supervisor::read_channel(child& proc) {
+  char msg[64];
+  ssize_t len = 0;
+  while (proc.channel >= 0 &&
+         (len = read(proc.channel, msg, sizeof(msg))) > 0) {
+    if (len == 1 && msg[0] == 1) {
+      if (proc.current == state::starting)
+        mark_running(proc, "is ready");
+    } else if (auto status = zygote::parse_exit_message(msg, len)) {
+      on_exit(proc, *status);
+    }
+  }
+  if (proc.channel < 0 || (len < 0 && errno == EAGAIN))
+    return;
+  if (config_.zygote_socket.empty()) {
+    // The ready pipe was closed without reporting, the process is exiting
+    // and will be reaped
+    close_channel(proc);
+  } else {
+    std::cerr << "Lost the zygote connection of " << proc.spec.name
+              << std::endl;
+    on_exit(proc, W_EXITCODE(EXIT_FAILURE, 0));
+  }
+}
+
+void process_supervisor::stop_all() {
+  stopping_ = true;
+  for (auto& proc : children_)
+    if (proc.pid > 0)
+      kill(proc.pid, SIGTERM);
+
+  const auto deadline = clock::now() + config_.stop_timeout;
+  auto alive = [this]() {
+    return std::any_of(children_.begin(), children_.end(),
+                       [](const child& c) { return c.pid > 0; });
+  };
+  while (alive()) {
+    reap();
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - clock::now());
+    if (left.count() <= 0)
+      break;
+    poll_channels(std::min<int64_t>(left.count(), 100));
+  }
+
+  for (auto& proc : children_) {
+    if (proc.pid <= 0)
+      continue;
+    std::cerr << proc.spec.name << " did not stop in time, killing it"
+              << std::endl;
+    kill(proc.pid, SIGKILL);
+    if (config_.zygote_socket.empty())
+      waitpid(proc.pid, nullptr, 0);
+    close_channel(proc);
+    proc.pid = -1;
+    proc.current = state::exited;
+  }
+}
+
+}  // namespace dolbyio::comms::sample
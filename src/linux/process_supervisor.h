@@ -0,0 +1,106 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace dolbyio::comms::sample {
+
+struct process_spec {
+  std::string name{};
+  std::vector<std::string> argv{};
+  std::string log_dir{};  // Receives the stdout and stderr of the process
+};
+
+/**
+ * Launches and supervises the injection processes of the orchestrator. The
+ * processes are started with bounded parallelism: a process occupies a start
+ * slot until it reports being ready (see notify_ready()), exits or times out.
+ * The PIDs are only tracked in memory. Processes which crash, or exit with a
+ * failure, are restarted with an exponential backoff, while processes which
+ * exit cleanly (the conference has ended) are not.
+ *
+ * When a zygote is used, the PIDs, readiness and exit statuses are reported
+ * on the zygote connections instead.
+ *
+ * The supervisor handles SIGCHLD, SIGINT and SIGTERM, so only one instance may
+ * exist in a process.
+ */
+class process_supervisor {
+ public:
+  // Environment variable holding the descriptor a supervised process writes
+  // to once it is ready.
+  static constexpr char ready_fd_env[] = "CPP_INJECTION_READY_FD";
+
+  // Called by the supervised process once it has started, no-op when the
+  // process is not supervised.
+  static void notify_ready();
+
+  struct config {
+    size_t max_parallel_starts{8};
+    std::chrono::seconds start_timeout{60};
+    std::chrono::seconds stop_timeout{10};
+    int max_restarts{5};
+    // A process running for longer than this is considered healthy again,
+    // which resets its restart count and backoff.
+    std::chrono::seconds stable_after{60};
+    // Spawn the processes through the zygote listening on this socket
+    // instead of executing the binary.
+    std::string zygote_socket{};
+  };
+
+  explicit process_supervisor(const config& cfg);
+  ~process_supervisor();
+
+  void add(process_spec spec);
+
+  // Run until every process has exited for good, or until SIGINT/SIGTERM
+  // is received, in which case all of the processes are stopped.
+  void run();
+
+ private:
+  using clock = std::chrono::steady_clock;
+  enum class state { pending, starting, running, backoff, exited, failed };
+
+  struct child {
+    process_spec spec;
+    state current{state::pending};
+    pid_t pid{-1};
+    int channel{-1};  // Ready pipe, or zygote connection
+    int restarts{0};
+    clock::time_point started{};
+    clock::time_point deadline{};  // Start timeout or end of the backoff
+  };
+
+  void launch(child& proc);
+  void started(child& proc, pid_t pid, int channel);
+  void reap();
+  void on_exit(child& proc, int status);
+  void mark_running(child& proc, const char* why);
+  void close_channel(child& proc);
+  void start_pending();
+  bool all_done() const;
+  int poll_timeout_ms() const;
+  void wait_for_events();
+  void poll_channels(int timeout_ms);
+  void read_channel(child& proc);
+  void stop_all();
+
+  config config_;
+  std::vector<child> children_{};
+  size_t starting_{0};
+  bool stopping_{false};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,339 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/shared_asset_store.h"
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+constexpr uint32_t segment_magic = 0x4a4e4943;  // "CINJ"
+constexpr uint32_t segment_version = 2;
+constexpr size_t header_size = 64;
+constexpr std::chrono::milliseconds poll_interval{10};
+constexpr char store_lock_name[] = "/cpp-injection-assets.lock";
+
+enum segment_state : uint32_t { decoding = 0, ready = 1, failed = 2 };
+
+// Lives at the start of every segment, the samples follow at header_size.
+struct segment_header {
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint32_t> state;
+  int32_t sample_rate;
+  int32_t channels;
+  uint64_t samples_per_channel;
+};
+static_assert(sizeof(segment_header) <= header_size);
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+class stale_segment : public std::exception {};
+
+// Serializes the creation and the removal of the segments across the
+// processes, so that a process never removes the segment another one has
+// just created in place of a stale one.
+class store_lock {
+ public:
+  store_lock() : fd_(shm_open(store_lock_name, O_RDONLY | O_CREAT, 0644)) {
+    if (fd_ >= 0)
+      flock(fd_, LOCK_EX);
+  }
+  ~store_lock() {
+    if (fd_ >= 0)
+      close(fd_);
+  }
+
+  store_lock(const store_lock&) = delete;
+  store_lock& operator=(const store_lock&) = delete;
+
+ private:
+  int fd_;
+};
+
+std::string segment_name(const std::string& path, int sample_rate) {
+  struct stat st {};
+  if (stat(path.c_str(), &st) < 0)
+    throw std::runtime_error("Cannot stat " + path + ": " + strerror(errno));
+  char resolved[PATH_MAX];
+  const std::string canonical =
+      realpath(path.c_str(), resolved) ? resolved : path;
+
+  std::ostringstream key;
+  key << canonical << '|' << st.st_size << '|' << st.st_mtim.tv_sec << '.'
+      << st.st_mtim.tv_nsec << '|' << sample_rate << '|' << segment_version;
+
+  // FNV-1a, the key only has to be unique not secret
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : key.str()) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  std::ostringstream name;
+  name << shared_asset_prefix << std::hex << hash;
+  return name.str();
+}
+
+void* map_segment(int fd, size_t len, int prot) {
+  void* addr = mmap(nullptr, len, prot, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED)
+    throw std::runtime_error(std::string("Failed to map shared asset: ") +
+                             strerror(errno));
+  return addr;
+}
+
+// Whether the name still refers to the segment open as fd. To be called
+// with the store locked.
+bool is_current(const std::string& name, int fd) {
+  const int current = shm_open(name.c_str(), O_RDONLY, 0);
+  if (current < 0)
+    return false;
+  struct stat open_st {}, current_st {};
+  const bool same = fstat(fd, &open_st) == 0 &&
+                    fstat(current, &current_st) == 0 &&
+                    open_st.st_dev == current_st.st_dev &&
+                    open_st.st_ino == current_st.st_ino;
+  close(current);
+  return same;
+}
+
+void remove_segment(const std::string& name, int fd) {
+  store_lock lock;
+  if (is_current(name, fd))
+    shm_unlink(name.c_str());
+}
+
+// Every process mapping a segment holds a shared lock on it, so the last
+// one to unmap it is the only one to get it exclusively, and removes it.
+void release_segment(const std::string& name,
+                     int fd,
+                     const void* addr,
+                     size_t len) {
+  munmap(const_cast<void*>(addr), len);
+  {
+    store_lock lock;
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0 && is_current(name, fd))
+      shm_unlink(name.c_str());
+  }
+  close(fd);
+}
+
+// Removes the segments no process holds a lock on, left by the processes
+// which exited without unmapping them.
+void remove_unused_segments() {
+  const std::string prefix = shared_asset_prefix + 1;
+  std::error_code ec;
+  store_lock lock;
+  for (const auto& entry :
+       std::filesystem::directory_iterator("/dev/shm", ec)) {
+    const auto file = entry.path().filename().string();
+    if (file.compare(0, prefix.size(), prefix) != 0)
+      continue;
+    const std::string name = "/" + file;
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+      continue;
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0)
+      shm_unlink(name.c_str());
+    close(fd);
+  }
+}
+
+std::shared_ptr<const pcm_buffer> make_mapped_buffer(
+    const std::string& name,
+    int fd,
+    const std::string& path,
+    const void* addr,
+    size_t len,
+    const segment_header& header) {
+  auto buffer = std::make_shared<pcm_buffer>();
+  buffer->source = path;
+  buffer->sample_rate = header.sample_rate;
+  buffer->channels = header.channels;
+  buffer->samples_per_channel = header.samples_per_channel;
+  buffer->data = reinterpret_cast<const int16_t*>(
+      static_cast<const uint8_t*>(addr) + header_size);
+  buffer->storage = std::shared_ptr<const void>(
+      addr, [name, fd, len](const void* p) {
+        release_segment(name, fd, p, len);
+      });
+  return buffer;
+}
+
+}  // namespace
+
+shared_asset_store::shared_asset_store(decoder&& decode,
+                                       std::chrono::milliseconds wait_timeout)
+    : decode_(std::move(decode)), wait_timeout_(wait_timeout) {}
+
+std::shared_ptr<const pcm_buffer> shared_asset_store::load_audio(
+    const std::string& path,
+    int sample_rate) {
+  const auto name = segment_name(path, sample_rate);
+  remove_unused_segments();
+
+  // Second attempt happens only when a stale segment has been removed.
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    int fd = -1;
+    bool created = false;
+    {
+      store_lock lock;
+      fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+      if (fd >= 0) {
+        // Held until the asset is ready, its release by a dying producer
+        // tells the waiting processes that the segment is stale.
+        flock(fd, LOCK_EX);
+        created = true;
+      } else if (errno == EEXIST) {
+        fd = shm_open(name.c_str(), O_RDONLY, 0);
+      }
+    }
+    if (fd < 0)
+      break;
+    if (created)
+      return publish(name, fd, path, sample_rate);
+    try {
+      return attach(name, fd, path);
+    } catch (const stale_segment&) {
+    } catch (const std::exception& ex) {
+      std::cerr << "Shared asset " << path << " unavailable: " << ex.what()
+                << std::endl;
+      break;
+    }
+  }
+
+  std::cerr << "Decoding " << path << " without sharing it" << std::endl;
+  return decode_(path, sample_rate);
+}
+
+std::shared_ptr<const pcm_buffer> shared_asset_store::publish(
+    const std::string& name,
+    int fd,
+    const std::string& path,
+    int sample_rate) {
+  // Claim the segment with just the header first, the processes waiting for
+  // the asset read its state once the producer releases its lock.
+  if (ftruncate(fd, header_size) < 0) {
+    remove_segment(name, fd);
+    close(fd);
+    throw std::runtime_error("Failed to size shared asset " + name);
+  }
+  void* header_addr = map_segment(fd, header_size, PROT_READ | PROT_WRITE);
+  auto* header = new (header_addr) segment_header{};
+  header->magic = segment_magic;
+  header->version = segment_version;
+
+  std::shared_ptr<const pcm_buffer> decoded;
+  size_t total = 0;
+  try {
+    decoded = decode_(path, sample_rate);
+    total = header_size + decoded->size() * sizeof(int16_t);
+    if (ftruncate(fd, total) < 0)
+      throw std::runtime_error("Failed to size shared asset " + name);
+  } catch (...) {
+    header->state.store(failed, std::memory_order_release);
+    munmap(header_addr, header_size);
+    remove_segment(name, fd);
+    close(fd);
+    throw;
+  }
+  munmap(header_addr, header_size);
+
+  void* addr = nullptr;
+  try {
+    addr = map_segment(fd, total, PROT_READ | PROT_WRITE);
+  } catch (...) {
+    // Left decoding, stale for the other processes once the lock is gone
+    close(fd);
+    throw;
+  }
+  header = static_cast<segment_header*>(addr);
+  header->sample_rate = decoded->sample_rate;
+  header->channels = decoded->channels;
+  header->samples_per_channel = decoded->samples_per_channel;
+  std::memcpy(static_cast<uint8_t*>(addr) + header_size, decoded->data,
+              decoded->size() * sizeof(int16_t));
+  header->state.store(ready, std::memory_order_release);
+
+  // The heap copy is dropped, from now on this process reads the segment like
+  // every other one does.
+  flock(fd, LOCK_SH);
+  mprotect(addr, total, PROT_READ);
+  return make_mapped_buffer(name, fd, path, addr, total, *header);
+}
+
+std::shared_ptr<const pcm_buffer> shared_asset_store::attach(
+    const std::string& name,
+    int fd,
+    const std::string& path) {
+  const auto deadline = std::chrono::steady_clock::now() + wait_timeout_;
+  // The producer holds the segment exclusively until the asset is ready or
+  // it failed, or until it died.
+  while (flock(fd, LOCK_SH | LOCK_NB) < 0) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      close(fd);
+      throw std::runtime_error("Timed out waiting for " + name);
+    }
+    std::this_thread::sleep_for(poll_interval);
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= header_size) {
+    void* addr = nullptr;
+    try {
+      addr = map_segment(fd, header_size, PROT_READ);
+    } catch (...) {
+      close(fd);
+      throw;
+    }
+    const auto* header = static_cast<const segment_header*>(addr);
+    const auto state = header->state.load(std::memory_order_acquire);
+    const bool compatible = header->magic == segment_magic &&
+                            header->version == segment_version;
+    const size_t total = header_size + header->samples_per_channel *
+                                           header->channels * sizeof(int16_t);
+    munmap(addr, header_size);
+
+    if (state == ready) {
+      if (!compatible) {
+        close(fd);
+        throw std::runtime_error("Incompatible shared asset " + name);
+      }
+      try {
+        addr = map_segment(fd, total, PROT_READ);
+      } catch (...) {
+        close(fd);
+        throw;
+      }
+      return make_mapped_buffer(name, fd, path, addr, total,
+                                *static_cast<const segment_header*>(addr));
+    }
+  }
+  // Failed, or left by a producer which died before the asset was ready
+  remove_segment(name, fd);
+  close(fd);
+  throw stale_segment{};
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,65 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/pcm_buffer.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+constexpr char shared_asset_prefix[] = "/cpp-injection-asset-";
+
+/**
+ * Store of decoded assets shared between all of the injection processes of
+ * the host, backed by POSIX shared memory. The segments are keyed by the
+ * canonical path, size and modification time of the source file, together
+ * with the decoded format. The first process decodes into the segment, the
+ * following ones map it read-only and share the physical pages.
+ *
+ * The producer holds an exclusive flock on the segment until the asset is
+ * ready, and every process mapping it holds a shared one: a segment left
+ * decoding without its lock is stale, whatever the pid namespace of its
+ * producer, and the last process to unmap a segment removes it. The
+ * segments of the processes which exited without unmapping them are held by
+ * no one, and removed by the next load. Segments are created and removed
+ * under a lock file of the store.
+ */
+class shared_asset_store {
+ public:
+  using decoder = std::function<std::shared_ptr<const pcm_buffer>(
+      const std::string& path,
+      int sample_rate)>;
+
+  explicit shared_asset_store(
+      decoder&& decode,
+      std::chrono::milliseconds wait_timeout = std::chrono::seconds(60));
+
+  // Throws std::runtime_error if the audio can neither be mapped nor decoded.
+  std::shared_ptr<const pcm_buffer> load_audio(const std::string& path,
+                                               int sample_rate);
+
+ private:
+  std::shared_ptr<const pcm_buffer> publish(const std::string& name,
+                                            int fd,
+                                            const std::string& path,
+                                            int sample_rate);
+  std::shared_ptr<const pcm_buffer> attach(const std::string& name,
+                                           int fd,
+                                           const std::string& path);
+
+  decoder decode_;
+  std::chrono::milliseconds wait_timeout_;
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,162 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/start_barrier.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Between the last arrival and the epoch, for the processes to notice the
+// epoch and get their players ready to start on it.
+constexpr std::chrono::milliseconds start_lead{100};
+constexpr std::chrono::milliseconds poll_interval{1};
+
+std::string segment_name(const std::string& name) {
+  std::string segment = start_barrier_prefix + name;
+  for (size_t i = 1; i < segment.size(); ++i)
+    if (segment[i] == '/')
+      segment[i] = '_';
+  return segment;
+}
+
+}  // namespace
+
+// Zero filled by the first process opening the segment.
+struct start_barrier::shared_state {
+  std::atomic<uint32_t> arrived;
+  // Processes which got the epoch, the last of them removes the segment
+  std::atomic<uint32_t> departed;
+  // Monotonic clock, in nanoseconds, and 0 until agreed
+  std::atomic<int64_t> epoch;
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(std::atomic<int64_t>::is_always_lock_free);
+
+std::unique_ptr<start_barrier> start_barrier::take_switch(
+    std::vector<std::string>& args) {
+  for (auto it = args.begin(); it != args.end(); ++it) {
+    if (*it != "-sync-start" && *it != "--sync-start")
+      continue;
+    if (std::next(it) == args.end())
+      throw std::runtime_error("No value provided for option: " + *it);
+    const std::string value = *std::next(it);
+    const auto colon = value.rfind(':');
+    unsigned long processes = 0;
+    try {
+      if (colon != std::string::npos && colon > 0)
+        processes = std::stoul(value.substr(colon + 1));
+    } catch (const std::exception&) {
+    }
+    if (processes == 0)
+      throw std::runtime_error("Invalid value for option " + *it + ": " +
+                               value + ", expected <name>:<processes>");
+    args.erase(it, it + 2);
+    return std::make_unique<start_barrier>(value.substr(0, colon),
+                                           static_cast<unsigned>(processes));
+  }
+  return nullptr;
+}
+
+void start_barrier::remove(const std::string& name) {
+  shm_unlink(segment_name(name).c_str());
+}
+
+start_barrier::start_barrier(const std::string& name,
+                             unsigned processes,
+                             std::chrono::milliseconds wait_timeout)
+    : name_(segment_name(name)),
+      processes_(processes),
+      wait_timeout_(wait_timeout) {
+  const int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    throw std::runtime_error("Failed to open the start barrier " + name_ +
+                             ": " + strerror(errno));
+  // Sized by every process, which leaves the state of a sized one as is
+  void* addr = MAP_FAILED;
+  if (ftruncate(fd, sizeof(shared_state)) == 0)
+    addr = mmap(nullptr, sizeof(shared_state), PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+  const int err = errno;
+  close(fd);
+  if (addr == MAP_FAILED)
+    throw std::runtime_error("Failed to map the start barrier " + name_ +
+                             ": " + strerror(err));
+  state_ = static_cast<shared_state*>(addr);
+}
+
+start_barrier::~start_barrier() {
+  if (!arrived_)
+    arrive();
+  munmap(state_, sizeof(shared_state));
+}
+
+void start_barrier::arrive() {
+  if (arrived_)
+    return;
+  state_->arrived.fetch_add(1);
+  arrived_ = true;
+  deadline_ = clock::now() + wait_timeout_;
+}
+
+std::optional<start_barrier::clock::time_point> start_barrier::poll() {
+  arrive();
+  const auto epoch = agree();
+  if (epoch && !departed_) {
+    departed_ = true;
+    if (state_->departed.fetch_add(1) + 1 == processes_)
+      shm_unlink(name_.c_str());
+  }
+  return epoch;
+}
+
+std::optional<start_barrier::clock::time_point> start_barrier::agree() {
+  if (const int64_t epoch = state_->epoch.load())
+    return clock::time_point(std::chrono::nanoseconds(epoch));
+
+  const auto now = clock::now();
+  const uint32_t arrived = state_->arrived.load();
+  if (arrived < processes_ && now < deadline_)
+    return std::nullopt;
+  // The first process to notice sets the epoch for all of them
+  int64_t expected = 0;
+  const auto epoch = now + start_lead;
+  if (!state_->epoch.compare_exchange_strong(
+          expected, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        epoch.time_since_epoch())
+                        .count()))
+    return clock::time_point(std::chrono::nanoseconds(expected));
+  if (arrived < processes_)
+    std::cerr << "Only " << arrived << " of " << processes_
+              << " processes at the start barrier, starting anyway"
+              << std::endl;
+  return epoch;
+}
+
+start_barrier::clock::time_point start_barrier::wait() {
+  for (;;) {
+    if (auto epoch = poll())
+      return *epoch;
+    std::this_thread::sleep_for(poll_interval);
+  }
+}
+
+}  // namespace dolbyio::comms::sample
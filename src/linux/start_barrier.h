@@ -0,0 +1,81 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+constexpr char start_barrier_prefix[] = "/cpp-injection-start-";
+
+/**
+ * Start barrier of the injection processes of a conversation, backed by a
+ * POSIX shared memory segment named after the conversation. Every process
+ * arrives once its bots have joined, and they all get the same epoch on the
+ * monotonic clock, shared by the processes of the host: a moment shortly
+ * after the last of them arrived, or after the first of them gave up
+ * waiting. A process arriving after the epoch was agreed, e.g. restarted
+ * after a crash, gets it as well while the segment is there.
+ *
+ * The last of the processes to get the epoch removes the segment. It
+ * outlives the processes when some of them never arrived, so its name is to
+ * be unique to the run. The orchestrator removes the segments of its run
+ * when it stops, otherwise: rm /dev/shm/cpp-injection-start-*
+ */
+class start_barrier {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  // Removes the -sync-start switch, "<name>:<processes>", and its value from
+  // the arguments, and opens its barrier.
+  static std::unique_ptr<start_barrier> take_switch(
+      std::vector<std::string>& args);
+  // Removes the segment of the barrier, which may still be mapped.
+  static void remove(const std::string& name);
+
+  start_barrier(const std::string& name,
+                unsigned processes,
+                std::chrono::milliseconds wait_timeout = std::chrono::seconds(
+                    60));
+  // Arrives if arrive() has not been called, so that a process failing to
+  // join does not hold back the others.
+  ~start_barrier();
+
+  start_barrier(const start_barrier&) = delete;
+  start_barrier& operator=(const start_barrier&) = delete;
+
+  // Arrives at the barrier, once, the wait timeout running from now on.
+  void arrive();
+  // Does not block: the epoch, once agreed, or agrees on it when every
+  // process has arrived or the wait timeout has passed. To be called again,
+  // e.g. from a timer, until it returns the epoch.
+  std::optional<clock::time_point> poll();
+  // Arrives at the barrier, and blocks until the epoch has been agreed.
+  clock::time_point wait();
+
+ private:
+  struct shared_state;
+
+  std::optional<clock::time_point> agree();
+
+  std::string name_;
+  unsigned processes_;
+  std::chrono::milliseconds wait_timeout_;
+  shared_state* state_{nullptr};
+  bool arrived_{false};
+  bool departed_{false};
+  clock::time_point deadline_{};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,256 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/zygote.h"
+#include "linux/process_supervisor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Large enough for the command line of a bot, requests are single messages
+constexpr size_t max_request_size = 64 * 1024;
+// Clients send their request right after connecting, one which does not
+// holds back the other spawns for this long at most
+constexpr timeval request_timeout{1, 0};
+
+int wake_pipe[2] = {-1, -1};
+volatile sig_atomic_t stop_requested = 0;
+
+void signal_handler(int sig) {
+  if (sig != SIGCHLD)
+    stop_requested = 1;
+  const int saved_errno = errno;
+  const char byte = 0;
+  [[maybe_unused]] auto ret = write(wake_pipe[1], &byte, 1);
+  errno = saved_errno;
+}
+
+sockaddr_un socket_address(const std::string& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    throw std::runtime_error("Socket path too long: " + path);
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return addr;
+}
+
+void send_message(int fd, const std::string& msg) {
+  [[maybe_unused]] auto ret = send(fd, msg.data(), msg.size(), MSG_NOSIGNAL);
+}
+
+std::runtime_error system_error(const std::string& what) {
+  return std::runtime_error(what + ": " + strerror(errno));
+}
+
+}  // namespace
+
+std::optional<std::string> zygote::take_zygote_switch(
+    std::vector<std::string>& args) {
+  for (auto it = args.begin(); it != args.end(); ++it) {
+    if (*it != "--zygote" && *it != "-zygote")
+      continue;
+    if (std::next(it) == args.end())
+      throw std::runtime_error("No value provided for option: " + *it);
+    std::string path = *std::next(it);
+    args.erase(it, it + 2);
+    return path;
+  }
+  return std::nullopt;
+}
+
+zygote::connection zygote::spawn(const std::string& socket_path,
+                                 const std::vector<std::string>& args) {
+  const auto addr = socket_address(socket_path);
+  connection conn{};
+  conn.fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (conn.fd < 0)
+    throw system_error("Failed to create socket");
+  try {
+    if (connect(conn.fd, reinterpret_cast<const sockaddr*>(&addr),
+                sizeof(addr)) < 0)
+      throw system_error("Failed to connect to the zygote " + socket_path);
+
+    std::string request;
+    for (const auto& arg : args) {
+      request += arg;
+      request.push_back('\0');
+    }
+    if (send(conn.fd, request.data(), request.size(), MSG_NOSIGNAL) < 0)
+      throw system_error("Failed to send the spawn request");
+
+    timeval timeout{10, 0};
+    setsockopt(conn.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char reply[64] = {};
+    const auto len = recv(conn.fd, reply, sizeof(reply) - 1, 0);
+    if (len <= 0 || std::strncmp(reply, "pid ", 4) != 0)
+      throw std::runtime_error("The zygote failed to spawn the bot");
+    conn.pid = std::atoi(reply + 4);
+    timeout = {0, 0};
+    setsockopt(conn.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  } catch (...) {
+    close(conn.fd);
+    throw;
+  }
+  return conn;
+}
+
+std::optional<int> zygote::parse_exit_message(const char* msg, size_t len) {
+  const std::string str{msg, len};
+  if (str.rfind("exit ", 0) != 0)
+    return std::nullopt;
+  return std::atoi(str.c_str() + 5);
+}
+
+zygote::zygote(const std::string& socket_path, bot_main&& main)
+    : socket_path_(socket_path), main_(std::move(main)) {
+  if (pipe2(wake_pipe, O_CLOEXEC | O_NONBLOCK) < 0)
+    throw system_error("Failed to create pipe");
+
+  const auto addr = socket_address(socket_path_);
+  listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0)
+    throw system_error("Failed to create socket");
+  unlink(socket_path_.c_str());
+  // The bots carry the access token of the operator, only the operator may
+  // connect. No thread runs yet, the umask is changed for this process only.
+  const mode_t mask = umask(0177);
+  const int bound = bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr),
+                         sizeof(addr));
+  umask(mask);
+  if (bound < 0 || listen(listen_fd_, SOMAXCONN) < 0)
+    throw system_error("Failed to listen on " + socket_path_);
+
+  struct sigaction action {};
+  action.sa_handler = signal_handler;
+  action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  sigemptyset(&action.sa_mask);
+  for (int sig : {SIGCHLD, SIGINT, SIGTERM})
+    sigaction(sig, &action, nullptr);
+}
+
+zygote::~zygote() {
+  for (int sig : {SIGCHLD, SIGINT, SIGTERM})
+    signal(sig, SIG_DFL);
+  // The bots keep on running, only the connections are closed
+  for (const auto& bot : bots_)
+    close(bot.conn);
+  close(listen_fd_);
+  unlink(socket_path_.c_str());
+  close(wake_pipe[0]);
+  close(wake_pipe[1]);
+  wake_pipe[0] = wake_pipe[1] = -1;
+}
+
+void zygote::run() {
+  std::cerr << "Zygote ready on " << socket_path_ << std::endl;
+  while (!stop_requested) {
+    pollfd fds[2] = {{wake_pipe[0], POLLIN, 0}, {listen_fd_, POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0 && errno != EINTR)
+      throw system_error("poll failed");
+    char buf[64];
+    while (read(wake_pipe[0], buf, sizeof(buf)) > 0) {
+    }
+    reap();
+    if (fds[1].revents & POLLIN)
+      accept_request();
+  }
+  std::cerr << "Zygote stopped, " << bots_.size() << " bot(s) still running"
+            << std::endl;
+}
+
+void zygote::accept_request() {
+  // Not close on exec: the bot reports being ready on this connection
+  const int conn = accept(listen_fd_, nullptr, nullptr);
+  if (conn < 0)
+    return;
+  ucred peer{};
+  socklen_t peer_len = sizeof(peer);
+  if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &peer, &peer_len) < 0 ||
+      (peer.uid != getuid() && peer.uid != 0)) {
+    std::cerr << "Refused a spawn request of uid " << peer.uid << std::endl;
+    close(conn);
+    return;
+  }
+  setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &request_timeout,
+             sizeof(request_timeout));
+
+  std::vector<char> request(max_request_size);
+  const auto len = recv(conn, request.data(), request.size(), 0);
+  if (len <= 0) {
+    close(conn);
+    return;
+  }
+  std::vector<std::string> args;
+  for (auto it = request.begin(); it < request.begin() + len;) {
+    auto end = std::find(it, request.begin() + len, '\0');
+    args.emplace_back(it, end);
+    it = end + 1;
+  }
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    std::cerr << "Failed to fork a bot: " << strerror(errno) << std::endl;
+    close(conn);
+    return;
+  }
+  if (pid == 0)
+    run_bot(conn, args);
+
+  send_message(conn, "pid " + std::to_string(pid));
+  bots_.push_back({pid, conn});
+}
+
+void zygote::reap() {
+  int status = 0;
+  pid_t pid;
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    auto bot =
+        std::find_if(bots_.begin(), bots_.end(),
+                     [pid](const bot_process& b) { return b.pid == pid; });
+    if (bot == bots_.end())
+      continue;
+    send_message(bot->conn, "exit " + std::to_string(status));
+    close(bot->conn);
+    bots_.erase(bot);
+  }
+}
+
+void zygote::run_bot(int conn, const std::vector<std::string>& args) {
+  // Drop everything belonging to the zygote
+  for (int sig : {SIGCHLD, SIGINT, SIGTERM})
+    signal(sig, SIG_DFL);
+  close(listen_fd_);
+  close(wake_pipe[0]);
+  close(wake_pipe[1]);
+  for (const auto& bot : bots_)
+    close(bot.conn);
+  setsid();
+
+  setenv(process_supervisor::ready_fd_env, std::to_string(conn).c_str(), 1);
+  exit(main_(args));
+}
+
+}  // namespace dolbyio::comms::sample
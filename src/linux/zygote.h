@@ -0,0 +1,80 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Prefork launcher of injection processes. The zygote process has the SDK,
+ * the multimedia streaming addon and ffmpeg loaded and initialized, and it
+ * forks a new bot process for every request received on its local socket,
+ * so starting a bot only costs a copy-on-write fork.
+ *
+ * The protocol uses a SOCK_SEQPACKET unix socket, one connection per bot:
+ *   client -> zygote: the command line switches of the bot, NUL separated
+ *   zygote -> client: "pid <pid>" once the bot is forked
+ *   bot    -> client: a single 0x01 byte once the bot has joined
+ *   zygote -> client: "exit <wait status>" when the bot has exited
+ *
+ * Nothing which starts threads may run in the zygote before forking.
+ */
+class zygote {
+ public:
+  using bot_main = std::function<int(const std::vector<std::string>& args)>;
+
+  struct connection {
+    int fd{-1};
+    pid_t pid{-1};
+  };
+
+  // Removes the --zygote switch and its value (the socket path) from the
+  // arguments.
+  static std::optional<std::string> take_zygote_switch(
+      std::vector<std::string>& args);
+
+  // Client side: request a new bot, returns the connection on which the
+  // ready and exit messages are received. Throws std::runtime_error.
+  static connection spawn(const std::string& socket_path,
+                          const std::vector<std::string>& args);
+
+  // Parses an exit message, returns the wait status.
+  static std::optional<int> parse_exit_message(const char* msg, size_t len);
+
+  zygote(const std::string& socket_path, bot_main&& main);
+  ~zygote();
+
+  // Serve requests until SIGINT or SIGTERM is received. The forked bots run
+  // the bot main and exit with its return value.
+  void run();
+
+ private:
+  void accept_request();
+  void reap();
+  [[noreturn]] void run_bot(int conn, const std::vector<std::string>& args);
+
+  struct bot_process {
+    pid_t pid;
+    int conn;
+  };
+
+  std::string socket_path_;
+  bot_main main_;
+  int listen_fd_{-1};
+  std::vector<bot_process> bots_{};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -7,11 +7,11 @@
  *                Copyright (C) 2022 - 2023 by Dolby Laboratories.
  ***************************************************************************/
 
-#include "wrappers/mediaio.h"
-#include "wrappers/sdk.h"
+#include "wrappers/bot_host.h"
 
-#include "utils/async_accumulator.h"
-#include "utils/commands_handler.h"
+#include "media/ffmpeg_decoder.h"
+#include "utils/conversation.h"
+#include "utils/trace.h"
 
 #include <memory>
 #include <vector>
@@ -19,145 +19,176 @@
 using namespace dolbyio::comms::sample;
 
 #if defined(__linux__)
+#include "linux/control_server.h"
 #include "linux/daemonize.h"
+#include "linux/event_loop.h"
+#include "linux/file_watcher.h"
+#include "linux/metrics_server.h"
+#include "linux/process_supervisor.h"
+#include "linux/start_barrier.h"
+#include "linux/zygote.h"
 
 #include <execinfo.h>
-#include <signal.h>
-
-// Global pointer for linux daemonization
-std::shared_ptr<daemonize> daemonize_ptr{nullptr};
-
-void signal_handler(int sig) {
-  if (sig == SIGTERM && daemonize_ptr)
-    daemonize_ptr->unblock_indefinte_wait();
-}
 #endif
 
-int main(int argc, char** argv) {
-  // Declare the SDK pointer first so it outlives
-  std::unique_ptr<dolbyio::comms::sdk> sdk{};
-  commands_handler command_handler{};
+// Runs the bots configured by the command line switches until stopped.
+int run_bots(std::vector<std::string> args, [[maybe_unused]] bool forked) {
+#if defined(__linux__)
+  // Created once daemonized, and destroyed after the bots so that the SDK
+  // threads can post to it until they are gone.
+  std::unique_ptr<event_loop> loop{};
+  std::unique_ptr<daemonize> daemonized{};
+#endif
+  // Either a single bot configured by the command line or every bot of a
+  // conversation, all of them driven from this main thread.
+  bot_host host{};
 
-  // Setup exit method which is signal handler or interactive command
-  // depending on the platform
+  // Setup exit method which is a signal received by the event loop or an
+  // interactive command depending on the platform. The signals are blocked
+  // before the SDK threads are started, so that they inherit the mask.
 #if defined(__linux__)
-  signal(SIGTERM, signal_handler);
+  event_loop::block_signals();
 #else
   volatile bool quit = false;
-  command_handler.add_interactive_command("q", "exit",
-                                          [&quit]() { quit = true; });
+  host.add_interactive_command("q", "exit", [&quit]() { quit = true; });
 #endif
   try {
-    // Create the SDK/MediaIO wrappers, they are uneeded after this scope
-    auto sdk_wrap = std::make_shared<sdk_wrapper>();
-    auto media_io_wrap =
-        std::make_shared<media_io_wrapper>(sdk_wrap->get_params());
-
-    // Register the wrappers with command handler and parse the args
-    command_handler.add_interactor(sdk_wrap);
-    command_handler.add_interactor(media_io_wrap);
-    command_handler.parse_command_line(argc, argv);
+    auto conversation_path = bot_host::take_conversation_switch(args);
+#if defined(__linux__)
+    // The bots of a conversation start together, those of every process of
+    // the conversation when it has more than one
+    auto barrier = start_barrier::take_switch(args);
+    if (barrier || conversation_path)
+      host.synchronize_start();
+#endif
+    if (conversation_path)
+      host.add_conversation(conversation::load(*conversation_path), args);
+    else
+      host.add_bot(args);
 
 #if defined(__linux__)
     try {
-      daemonize_ptr =
-          std::make_unique<daemonize>(sdk_wrap->get_params().log_dir);
+      auto mode = forked ? daemon::mode::forked : daemon::mode::detach;
+      if (host.get_params().foreground)
+        mode = daemon::mode::foreground;
+      daemonized =
+          std::make_unique<daemonize>(host.get_params().log_dir, mode);
     } catch (daemon::failure_exception& ex) {
       exit(EXIT_FAILURE);
     } catch (daemon::parent_process_exception& ex) {
       exit(EXIT_SUCCESS);
     }
+    loop = std::make_unique<event_loop>();
+#endif
+
+    // The trace file is written from here on, after the process has been
+    // daemonized
+    trace::start();
+    trace::set_thread_name("main");
+#if defined(__linux__)
+    auto metrics = metrics_server::start_configured();
 #endif
 
     // Apple the desired log settings
     dolbyio::comms::sdk::log_settings log_settings;
-    log_settings.log_directory = sdk_wrap->get_params().log_dir;
-    log_settings.sdk_log_level = sdk_wrap->get_params().sdk_log_level;
-    log_settings.media_log_level = sdk_wrap->get_params().me_log_level;
+    log_settings.log_directory = host.get_params().log_dir;
+    log_settings.sdk_log_level = host.get_params().sdk_log_level;
+    log_settings.media_log_level = host.get_params().me_log_level;
     dolbyio::comms::sdk::set_log_settings(std::move(log_settings));
 
-    // Create the SDK passing in the token and a refresh token callback
-    sdk = dolbyio::comms::sdk::create(
-        sdk_wrap->get_params().access_token,
-        [](std::unique_ptr<dolbyio::comms::refresh_token>&&) {
-          // This sample currently does not provide any token fetching mechanism
-          // It is the responsibilty of the application to provide a lambda here
-          // which can fetch a token when it is invoked by the SDK and then
-          // provide this token to the dolbio::comms::refresh_token interface.
+    // Create an SDK instance per bot, open the sessions and join the
+    // conference. This blocks until every bot has completed its join.
+    host.create_sdks();
+    host.join_all();
+#if defined(__linux__)
+    process_supervisor::notify_ready();
+    // The interactive commands, with no stdin once daemonized
+    auto control = control_server::start(
+        *loop, host.get_params().log_dir,
+        [&host](const std::string& bot, const std::string& command,
+                const std::string& arg) {
+          return host.handle_interactive_command(command, arg, bot);
         });
-
-    // Set the SDK instance on the wrappers
-    command_handler.set_sdk(sdk.get());
-    {
-      // Using promise/future to make the thread wait till this entire
-      // asynchronous chain is completed. But like in general you could do
-      // without just async it all.
-      auto promise = std::make_shared<std::promise<void>>();
-      auto future = promise->get_future();
-      media_io_wrap->initialize_injection()
-          .then([sdk_wrap]() { return sdk_wrap->open_session(); })
-          .then([sdk_wrap]() {
-            return sdk_wrap->create_and_or_join_conference();
-          })
-          .then([sdk_wrap]() -> dolbyio::comms::async_result<void> {
-            // The following operations can happen concurrently, but their
-            // combined result must be waited for before start capture.
-            async_result_accumulator accumulator;
-            accumulator += sdk_wrap->apply_spatial_audio_configuration();
-            accumulator += sdk_wrap->set_audio_processing();
-            return std::move(accumulator);
-          })
-          .then([sdk_wrap, media_io_wrap, promise]() {
-            auto media = sdk_wrap->get_params().conf;
-            media_io_wrap->set_initial_capture(media.join_with_audio(),
-                                               media.join_with_video());
-            promise->set_value();
-          })
-          .on_error(
-              [promise](auto&& ex) { promise->set_exception(std::move(ex)); });
-      future.get();
+    // The changes of the conversation definition are applied to the bots,
+    // and the completions of their joins and leaves on the loop thread
+    host.set_poster([loop{loop.get()}](std::function<void()> cb) {
+      loop->post(std::move(cb));
+    });
+    std::unique_ptr<file_watcher> reload{};
+    if (auto file = host.conversation_file()) {
+      try {
+        reload = std::make_unique<file_watcher>(
+            *loop, *file, [&host]() { host.reload_conversation(); });
+      } catch (const std::exception& ex) {
+        std::cerr << ex.what() << ", no reload of " << *file << std::endl;
+      }
     }
+    // The end of the conference is noticed on an SDK thread, which stops
+    // the loop like a termination signal would.
+    host.on_conference_ended([loop{loop.get()}]() { loop->stop(); });
+    // The timeline of the conversation starts once the bots have joined,
+    // those of all of its processes when synchronized: the loop polls the
+    // barrier on the ticks of the timeline until the epoch is agreed.
+    if (barrier)
+      barrier->arrive();
+    else
+      host.start_conversation(std::chrono::steady_clock::now());
+    auto timeline =
+        loop->add_timer(bot_host::timeline_tick, [&host, &barrier]() {
+          if (barrier) {
+            auto epoch = barrier->poll();
+            if (!epoch)
+              return;
+            host.start_conversation(*epoch);
+            barrier.reset();
+          }
+          host.advance_timeline(std::chrono::steady_clock::now());
+        });
+#endif
 
     // Run blocking loop
 #if defined(__linux__)
-    // If the conference has ended then we should unblock the loop.
-    // Not ideal because you could techinically race here with signal
-    // handler, but for our purposes it should be ok.
-    std::weak_ptr<daemonize> weak_daemoize_ptr{daemonize_ptr};
-    sdk->conference()
-        .add_event_handler(
-            [weak_daemoize_ptr](
-                const dolbyio::comms::conference_status_updated& status) {
-              if (status.is_ended() && !weak_daemoize_ptr.expired()) {
-                weak_daemoize_ptr.lock()->unblock_indefinte_wait();
-              }
-            })
-        .on_error([](auto&&) {});
-    daemonize_ptr->wait_indefinitely();
-    daemonize_ptr.reset();
+    loop->run();
+    timeline.reset();
+    reload.reset();
+    control.reset();
+    daemonized.reset();
 #else
     while (!quit) {
-      command_handler.print_interactive_options();
+      host.print_interactive_options();
       std::string command;
       std::cin >> command;
-      command_handler.handle_interactive_command(command);
+      host.handle_typed_command(command);
     }
 #endif
-    {
-      // Using promise/future to make the thread wait till this entire
-      // asynchronous chain is completed. But like in general you could do
-      // without just async it all.
-      auto promise = std::make_shared<std::promise<void>>();
-      auto future = promise->get_future();
-      sdk_wrap->leave_conference()
-          .then([sdk_wrap]() { return sdk_wrap->close_session(); })
-          .then([promise]() { promise->set_value(); })
-          .on_error(
-              [promise](auto&& ex) { promise->set_exception(std::move(ex)); });
-      future.get();
-    }
+    host.leave_all();
   } catch (const std::exception& ex) {
     std::cout << "Something went wrong: " << ex.what() << std::endl;
+    trace::stop();
+    return EXIT_FAILURE;
   }
+  trace::stop();
   return 0;
 }
+
+int main(int argc, char** argv) {
+  std::vector<std::string> args(argv + 1, argv + argc);
+#if defined(__linux__)
+  // In zygote mode the bots are forked from this process on request, with
+  // everything already loaded.
+  try {
+    if (auto socket_path = zygote::take_zygote_switch(args)) {
+      preload_ffmpeg();
+      zygote launcher{*socket_path, [](const std::vector<std::string>& args) {
+                        return run_bots(args, true);
+                      }};
+      launcher.run();
+      return 0;
+    }
+  } catch (const std::exception& ex) {
+    std::cout << "Something went wrong: " << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+#endif
+  return run_bots(std::move(args), false);
+}
@@ -0,0 +1,156 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/audio_decoder.h"
+#include "media/ffmpeg_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+extern "C" {
+#include <libavutil/samplefmt.h>
+}
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Read a single sample of the given channel as float in the [-1, 1] range,
+// whichever the sample format the decoder produces.
+float sample_as_float(const AVFrame* frame, int channels, int ch, int idx) {
+  auto fmt = static_cast<AVSampleFormat>(frame->format);
+  const bool planar = av_sample_fmt_is_planar(fmt);
+  const uint8_t* plane = planar ? frame->extended_data[ch] : frame->data[0];
+  const int pos = planar ? idx : idx * channels + ch;
+  switch (av_get_packed_sample_fmt(fmt)) {
+    case AV_SAMPLE_FMT_U8:
+      return (plane[pos] - 128) / 128.0f;
+    case AV_SAMPLE_FMT_S16:
+      return reinterpret_cast<const int16_t*>(plane)[pos] / 32768.0f;
+    case AV_SAMPLE_FMT_S32:
+      return reinterpret_cast<const int32_t*>(plane)[pos] / 2147483648.0f;
+    case AV_SAMPLE_FMT_FLT:
+      return reinterpret_cast<const float*>(plane)[pos];
+    case AV_SAMPLE_FMT_DBL:
+      return static_cast<float>(reinterpret_cast<const double*>(plane)[pos]);
+    default:
+      throw std::runtime_error("Unsupported audio sample format");
+  }
+}
+
+// Append the samples of the frame as interleaved floats, folding the extra
+// channels into left/right alternately.
+void append_folded(const AVFrame* frame,
+                   int in_channels,
+                   int out_channels,
+                   std::vector<float>& out) {
+  for (int i = 0; i < frame->nb_samples; ++i) {
+    if (in_channels == out_channels) {
+      for (int ch = 0; ch < in_channels; ++ch)
+        out.push_back(sample_as_float(frame, in_channels, ch, i));
+      continue;
+    }
+    float mix[2] = {0.f, 0.f};
+    for (int ch = 0; ch < in_channels; ++ch)
+      mix[ch % 2] += sample_as_float(frame, in_channels, ch, i);
+    const float norm = 2.0f / in_channels;
+    out.push_back(mix[0] * norm);
+    out.push_back(mix[1] * norm);
+  }
+}
+
+int16_t to_s16(float s) {
+  return static_cast<int16_t>(
+      std::lround(std::clamp(s, -1.0f, 1.0f) * 32767.0f));
+}
+
+}  // namespace
+
+std::shared_ptr<const pcm_buffer> decode_audio_file(const std::string& path,
+                                                    int sample_rate) {
+  // A packet at a time, converted straight into the samples of the buffer:
+  // only the samples of a packet are ever held as floats.
+  audio_stream_decoder decoder{path, sample_rate};
+  std::vector<int16_t> samples;
+  samples.reserve(static_cast<size_t>(std::ceil(decoder.duration() *
+                                                sample_rate)) *
+                  decoder.channels());
+  while (decoder.decode(samples)) {
+  }
+  if (samples.empty())
+    throw std::runtime_error("No audio decoded from " + path);
+  samples.shrink_to_fit();
+  return pcm_buffer::from_samples(path, std::move(samples), sample_rate,
+                                  decoder.channels());
+}
+
+audio_stream_decoder::audio_stream_decoder(const std::string& path,
+                                           int sample_rate)
+    : decoder_(std::make_unique<ffmpeg_decoder>(path, AVMEDIA_TYPE_AUDIO)),
+      in_channels_(decoder_->channels()),
+      in_rate_(decoder_->codec()->sample_rate),
+      out_channels_(std::clamp(in_channels_, 1, 2)),
+      out_rate_(sample_rate) {
+  if (in_channels_ <= 0 || in_rate_ <= 0)
+    throw std::runtime_error("Invalid audio parameters in " + path);
+}
+
+audio_stream_decoder::~audio_stream_decoder() = default;
+
+double audio_stream_decoder::duration() const {
+  return decoder_->duration();
+}
+
+bool audio_stream_decoder::decode(std::vector<int16_t>& out) {
+  block_.clear();
+  const bool more = decoder_->decode_packet([&](const AVFrame* frame) {
+    append_folded(frame, in_channels_, out_channels_, block_);
+  });
+  resample_into(out);
+  // The samples after the last input sample hold it
+  const double step = static_cast<double>(in_rate_) / out_rate_;
+  for (; !more && !last_.empty() && position_ < 0; position_ += step) {
+    for (int ch = 0; ch < out_channels_; ++ch)
+      out.push_back(to_s16(last_[ch]));
+  }
+  return more;
+}
+
+void audio_stream_decoder::resample_into(std::vector<int16_t>& out) {
+  if (in_rate_ == out_rate_) {
+    std::transform(block_.begin(), block_.end(), std::back_inserter(out),
+                   to_s16);
+    return;
+  }
+  // Same linear interpolation as decode_audio_file(), carried over from one
+  // block to the next: position -1 is the last sample of the previous block.
+  const long in_len = static_cast<long>(block_.size()) / out_channels_;
+  if (in_len == 0)
+    return;
+  const double step = static_cast<double>(in_rate_) / out_rate_;
+  for (;;) {
+    const long idx = static_cast<long>(std::floor(position_));
+    if (idx + 1 >= in_len)
+      break;
+    const float frac = static_cast<float>(position_ - idx);
+    for (int ch = 0; ch < out_channels_; ++ch) {
+      const float a = idx < 0 ? last_[ch] : block_[idx * out_channels_ + ch];
+      const float b = block_[(idx + 1) * out_channels_ + ch];
+      out.push_back(to_s16(a + (b - a) * frac));
+    }
+    position_ += step;
+  }
+  position_ -= in_len;
+  last_.assign(block_.end() - out_channels_, block_.end());
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,73 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/pcm_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+// Sample rate of the audio frames handed to the injector.
+constexpr int injection_sample_rate = 48000;
+
+/**
+ * Decode the best audio stream of the media file in one go, converting it to
+ * interleaved 16 bit PCM at the requested sample rate. Sources with more than
+ * two channels are downmixed to stereo. The file is decoded a packet at a
+ * time by an audio_stream_decoder, into a buffer reserved for the duration of
+ * the stream. Throws std::runtime_error if the file cannot be opened or
+ * contains no decodable audio.
+ */
+std::shared_ptr<const pcm_buffer> decode_audio_file(
+    const std::string& path,
+    int sample_rate = injection_sample_rate);
+
+class ffmpeg_decoder;
+
+/**
+ * Decode the best audio stream of the media file progressively, a packet at
+ * a time, into the same format as decode_audio_file(). Memory does not grow
+ * with the length of the file. Throws std::runtime_error as
+ * decode_audio_file().
+ */
+class audio_stream_decoder {
+ public:
+  explicit audio_stream_decoder(const std::string& path,
+                                int sample_rate = injection_sample_rate);
+  ~audio_stream_decoder();
+
+  int channels() const { return out_channels_; }
+  // Of the audio stream in seconds, 0 when unknown.
+  double duration() const;
+
+  // Append the samples decoded from the next packet, returns false at the
+  // end of the stream.
+  bool decode(std::vector<int16_t>& out);
+
+ private:
+  void resample_into(std::vector<int16_t>& out);
+
+  std::unique_ptr<ffmpeg_decoder> decoder_;
+  int in_channels_;
+  int in_rate_;
+  int out_channels_;
+  int out_rate_;
+  std::vector<float> block_{};
+  // Last input sample of the previous block, interpolated from
+  std::vector<float> last_{};
+  // Input position of the next output sample, relative to the block
+  double position_{0};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,230 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/audio_mixdown.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MIX_X86 1
+#endif
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+constexpr int gain_shift = 12;
+// Two seconds of mix, the latency and the samples arriving ahead of time
+constexpr size_t ring_positions = 2 * audio_mixdown::sample_rate;
+
+void mix_scalar(int16_t* acc, const int16_t* in, size_t count, int gain) {
+  for (size_t i = 0; i < count; ++i) {
+    const int32_t scaled = std::clamp<int32_t>(
+        (static_cast<int32_t>(in[i]) * gain) >> gain_shift, INT16_MIN,
+        INT16_MAX);
+    acc[i] = static_cast<int16_t>(
+        std::clamp<int32_t>(acc[i] + scaled, INT16_MIN, INT16_MAX));
+  }
+}
+
+#if defined(MIX_X86)
+// The 32 bit products of the low and high halves are interleaved back in
+// order, then narrowed with saturation. Both unpack and pack work within
+// 128 bit lanes, so the order is kept with AVX2 too.
+__attribute__((target("sse2"))) void mix_sse2(int16_t* acc,
+                                              const int16_t* in,
+                                              size_t count,
+                                              int gain) {
+  const __m128i g = _mm_set1_epi16(static_cast<int16_t>(gain));
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    const __m128i lo = _mm_mullo_epi16(x, g);
+    const __m128i hi = _mm_mulhi_epi16(x, g);
+    const __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), gain_shift);
+    const __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), gain_shift);
+    auto* out = reinterpret_cast<__m128i*>(acc + i);
+    _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out),
+                                         _mm_packs_epi32(p0, p1)));
+  }
+  mix_scalar(acc + i, in + i, count - i, gain);
+}
+
+__attribute__((target("avx2"))) void mix_avx2(int16_t* acc,
+                                              const int16_t* in,
+                                              size_t count,
+                                              int gain) {
+  const __m256i g = _mm256_set1_epi16(static_cast<int16_t>(gain));
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    const __m256i lo = _mm256_mullo_epi16(x, g);
+    const __m256i hi = _mm256_mulhi_epi16(x, g);
+    const __m256i p0 =
+        _mm256_srai_epi32(_mm256_unpacklo_epi16(lo, hi), gain_shift);
+    const __m256i p1 =
+        _mm256_srai_epi32(_mm256_unpackhi_epi16(lo, hi), gain_shift);
+    auto* out = reinterpret_cast<__m256i*>(acc + i);
+    _mm256_storeu_si256(out, _mm256_adds_epi16(_mm256_loadu_si256(out),
+                                               _mm256_packs_epi32(p0, p1)));
+  }
+  mix_sse2(acc + i, in + i, count - i, gain);
+}
+#endif
+
+struct kernel {
+  void (*mix)(int16_t*, const int16_t*, size_t, int);
+  const char* name;
+};
+
+kernel select_kernel() {
+#if defined(MIX_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return {mix_avx2, "avx2"};
+  if (__builtin_cpu_supports("sse2"))
+    return {mix_sse2, "sse2"};
+#endif
+  return {mix_scalar, "scalar"};
+}
+
+const kernel& selected_kernel() {
+  static const kernel selected = select_kernel();
+  return selected;
+}
+
+}  // namespace
+
+int mix_gain_from_db(int db) {
+  const double gain = std::pow(10.0, db / 20.0) * mix_unity_gain;
+  return static_cast<int>(std::clamp(std::lround(gain), 0l, 32767l));
+}
+
+void mix_saturating(int16_t* acc, const int16_t* in, size_t count, int gain) {
+  selected_kernel().mix(acc, in, count, gain);
+}
+
+const char* mix_kernel_name() {
+  return selected_kernel().name;
+}
+
+audio_mixdown::audio_mixdown(std::shared_ptr<batched_writer::file> output,
+                             int default_gain_db,
+                             const std::map<std::string, int>& gains_db)
+    : output_(std::move(output)),
+      default_gain_(mix_gain_from_db(default_gain_db)),
+      ring_(ring_positions * channels, 0) {
+  for (const auto& [id, db] : gains_db)
+    gains_[id] = mix_gain_from_db(db);
+  std::cerr << "Mixing the received audio down with the " << mix_kernel_name()
+            << " mixer" << std::endl;
+}
+
+int64_t audio_mixdown::now_position() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - epoch_)
+             .count() *
+         sample_rate / 1000000;
+}
+
+void audio_mixdown::add(const std::string& stream_id,
+                        const int16_t* data,
+                        size_t samples,
+                        int rate,
+                        size_t stream_channels) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (rate != sample_rate || stream_channels < 1 || stream_channels > 2) {
+    if (!warned_rate_)
+      std::cerr << "Only " << sample_rate << "Hz mono or stereo audio is "
+                << "mixed, skipping " << rate << "Hz " << stream_channels
+                << " channel(s)" << std::endl;
+    warned_rate_ = true;
+    return;
+  }
+  // The timeline starts with the first samples
+  if (epoch_ == std::chrono::steady_clock::time_point{})
+    epoch_ = std::chrono::steady_clock::now();
+
+  const int64_t now = now_position();
+  auto [it, added] = streams_.try_emplace(stream_id);
+  stream& st = it->second;
+  if (added) {
+    auto gain = gains_.find(stream_id);
+    st.gain = gain != gains_.end() ? gain->second : default_gain_;
+  }
+  const int64_t max_drift = latency.count() * sample_rate / 1000;
+  if (!st.next || std::abs(*st.next - now) > max_drift)
+    st.next = now;
+
+  // Mono is mixed into both channels
+  const int16_t* frames = data;
+  if (stream_channels == 1) {
+    upmixed_.resize(samples * channels);
+    for (size_t i = 0; i < samples; ++i)
+      upmixed_[2 * i] = upmixed_[2 * i + 1] = data[i];
+    frames = upmixed_.data();
+  }
+
+  int64_t position = *st.next;
+  st.next = position + static_cast<int64_t>(samples);
+  // Too late for the part already written, and the ring only spans so far
+  // ahead of it.
+  if (position < written_) {
+    const auto late = std::min<int64_t>(written_ - position, samples);
+    frames += late * channels;
+    samples -= late;
+    position += late;
+  }
+  const int64_t end = position + static_cast<int64_t>(samples);
+  if (end > written_ + static_cast<int64_t>(ring_positions))
+    write_until(end - static_cast<int64_t>(ring_positions));
+
+  while (samples > 0) {
+    const size_t offset = position % ring_positions;
+    const size_t len = std::min(samples, ring_positions - offset);
+    mix_saturating(&ring_[offset * channels], frames, len * channels,
+                   st.gain);
+    frames += len * channels;
+    samples -= len;
+    position += len;
+  }
+
+  write_until(now - max_drift);
+}
+
+void audio_mixdown::flush() {
+  std::lock_guard<std::mutex> lock(lock_);
+  int64_t end = written_;
+  for (const auto& [id, st] : streams_)
+    if (st.next)
+      end = std::max(end, *st.next);
+  write_until(end);
+  streams_.clear();
+}
+
+void audio_mixdown::write_until(int64_t position) {
+  while (written_ < position) {
+    const size_t offset = written_ % ring_positions;
+    const size_t len = static_cast<size_t>(
+        std::min<int64_t>(position - written_, ring_positions - offset));
+    int16_t* mixed = &ring_[offset * channels];
+    const size_t size = len * channels * sizeof(int16_t);
+    if (output_->begin_record(size))
+      output_->append(mixed, size);
+    std::fill_n(mixed, len * channels, 0);
+    written_ += len;
+  }
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,87 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/batched_writer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+// Gains are in Q12 fixed point: 4096 is unity, up to just below 8 (+18dB).
+constexpr int mix_unity_gain = 4096;
+int mix_gain_from_db(int db);
+
+// acc[i] = saturate(acc[i] + saturate(in[i] * gain / 4096)), on the widest
+// vector unit of the CPU (AVX2, SSE2 or scalar), picked once at run time.
+void mix_saturating(int16_t* acc, const int16_t* in, size_t count, int gain);
+const char* mix_kernel_name();
+
+/**
+ * Mixes the audio of all of the remote participants into a single 48kHz
+ * stereo track, written by the batched_writer.
+ *
+ * The mix is a window of the timeline of the recording. A stream is placed
+ * on it by the arrival time of its first samples, then its samples follow
+ * each other exactly, unless it drifts away from the arrival times by more
+ * than the latency of the mix, in which case it is placed again. The mix is
+ * written once it is older than its latency, so samples arriving later than
+ * that are dropped.
+ */
+class audio_mixdown {
+ public:
+  static constexpr int sample_rate = 48000;
+  static constexpr size_t channels = 2;
+  static constexpr std::chrono::milliseconds latency{200};
+
+  audio_mixdown(std::shared_ptr<batched_writer::file> output,
+                int default_gain_db,
+                const std::map<std::string, int>& gains_db);
+
+  // Samples per channel, interleaved.
+  void add(const std::string& stream_id,
+           const int16_t* data,
+           size_t samples,
+           int rate,
+           size_t stream_channels);
+  // Writes the whole mix, e.g. once the sinks are detached.
+  void flush();
+
+ private:
+  struct stream {
+    int gain;
+    std::optional<int64_t> next;  // Position of the next samples
+  };
+
+  int64_t now_position() const;
+  void write_until(int64_t position);
+
+  std::shared_ptr<batched_writer::file> output_;
+  const int default_gain_;
+  std::map<std::string, int> gains_;
+
+  std::mutex lock_{};
+  std::chrono::steady_clock::time_point epoch_{};
+  std::map<std::string, stream> streams_{};
+  // Ring of the mix not yet written, starting at position written_
+  std::vector<int16_t> ring_;
+  int64_t written_{0};
+  std::vector<int16_t> upmixed_{};
+  bool warned_rate_{false};
+};
+
+}  // namespace dolbyio::comms::sample
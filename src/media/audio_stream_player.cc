@@ -0,0 +1,380 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/audio_stream_player.h"
+#include "media/frame_pool.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Same catch up limit as the pcm_player.
+constexpr std::chrono::milliseconds max_lag{100};
+
+// The frame is handed over to the injector, it keeps a copy of the samples
+// so that the slot goes back to the decoder right away. Its memory comes
+// from the frame pool.
+class stream_frame : public dolbyio::comms::audio_frame, public pooled_frame {
+ public:
+  stream_frame(const int16_t* data, int channels) : channels_(channels) {
+    std::copy_n(data, audio_stream_player::samples_per_frame * channels,
+                samples_.begin());
+  }
+
+  const int16_t* data() const override { return samples_.data(); }
+  int sample_rate() const override { return injection_sample_rate; }
+  int channels() const override { return channels_; }
+  int samples() const override {
+    return static_cast<int>(audio_stream_player::samples_per_frame);
+  }
+
+ private:
+  std::array<int16_t,
+             audio_stream_player::samples_per_frame *
+                 audio_stream_player::max_channels>
+      samples_;
+  int channels_;
+};
+
+}  // namespace
+
+audio_stream_player::audio_stream_player(
+    plugin::injector& injector,
+    bool loop,
+    finished_cb&& on_finished,
+    std::shared_ptr<metrics::injection_metrics> metrics,
+    bool external_clock)
+    : injector_(injector),
+      loop_(loop),
+      on_finished_(std::move(on_finished)),
+      metrics_(std::move(metrics)) {
+  // A decoded packet and the frame in progress, usually. It grows with the
+  // longest packet, then its capacity is reused.
+  pending_.reserve(8 * samples_per_frame * max_channels);
+  decode_thread_ = std::thread([this]() { decode(); });
+  if (!external_clock)
+    thread_ = std::thread([this]() { run(); });
+}
+
+audio_stream_player::~audio_stream_player() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    quit_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+  {
+    std::lock_guard<std::mutex> lock(decode_lock_);
+    decode_quit_ = true;
+  }
+  decode_cond_.notify_all();
+  decode_thread_.join();
+}
+
+void audio_stream_player::play(std::vector<std::string> playlist) {
+  {
+    std::lock_guard<std::mutex> lock(decode_lock_);
+    playlist_ = std::move(playlist);
+    restart(0, std::chrono::milliseconds{0});
+  }
+  decode_cond_.notify_all();
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    finished_ = false;
+  }
+  cond_.notify_all();
+}
+
+void audio_stream_player::add_to_playlist(const std::string& file) {
+  {
+    std::lock_guard<std::mutex> lock(decode_lock_);
+    playlist_.push_back(file);
+  }
+  decode_cond_.notify_all();
+}
+
+void audio_stream_player::set_capture(bool enabled) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    // Starting the capture again after the playlist has finished restarts it
+    if (enabled && finished_) {
+      finished_ = false;
+      std::lock_guard<std::mutex> decode_lock(decode_lock_);
+      restart(0, std::chrono::milliseconds{0});
+      decode_cond_.notify_all();
+    }
+    capture_ = enabled;
+  }
+  cond_.notify_all();
+}
+
+bool audio_stream_player::pause() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (paused_)
+    return false;
+  paused_ = true;
+  return true;
+}
+
+bool audio_stream_player::resume() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!paused_)
+      return false;
+    paused_ = false;
+  }
+  cond_.notify_all();
+  return true;
+}
+
+bool audio_stream_player::seek(std::chrono::milliseconds position) {
+  {
+    std::lock_guard<std::mutex> lock(decode_lock_);
+    if (playlist_.empty() || position.count() < 0)
+      return false;
+    // Within the file being decoded, which is at most the length of the ring
+    // ahead of the injection.
+    restart(current_ > 0 ? current_ - 1 : 0, position);
+  }
+  decode_cond_.notify_all();
+  return true;
+}
+
+void audio_stream_player::restart(size_t file,
+                                  std::chrono::milliseconds position) {
+  current_ = file;
+  start_position_ = position;
+  restart_ = true;
+  ended_ = false;
+  // The frames already queued are dropped by the injection from now on
+  generation_.fetch_add(1, std::memory_order_release);
+}
+
+void audio_stream_player::decode() {
+  trace::set_thread_name("audio_stream_decoder");
+  std::unique_lock<std::mutex> lock(decode_lock_);
+  while (!decode_quit_) {
+    if (restart_) {
+      restart_ = false;
+      decoder_.reset();
+      pending_.clear();
+      pending_offset_ = 0;
+      skip_samples_ = static_cast<size_t>(start_position_.count()) *
+                      injection_sample_rate / 1000;
+    }
+    if (ended_ || playlist_.empty()) {
+      decode_cond_.wait(lock, [this]() {
+        return decode_quit_ || restart_ || (!ended_ && !playlist_.empty());
+      });
+      continue;
+    }
+
+    // The injection drains a frame every 10ms, and notifies when it drops
+    // the frames of a previous generation or reaches the low watermark. The
+    // timeout covers a notification sent just before waiting.
+    const size_t queued = ring_.size();
+    if (queued > low_watermark) {
+      decode_cond_.wait_for(lock, frame_duration * (queued - low_watermark),
+                            [this]() {
+                              return decode_quit_ || restart_ ||
+                                     ring_.size() <= low_watermark;
+                            });
+      continue;
+    }
+
+    const uint64_t generation = generation_.load(std::memory_order_relaxed);
+    lock.unlock();
+    bool more = false;
+    {
+      trace::scope scope("decode", "audio decode ahead");
+      more = fill(generation);
+    }
+    lock.lock();
+    if (!more && generation == generation_.load(std::memory_order_relaxed))
+      ended_ = true;
+  }
+}
+
+bool audio_stream_player::fill(uint64_t generation) {
+  while (frame_slot* slot = ring_.write_slot()) {
+    if (generation != generation_.load(std::memory_order_relaxed))
+      return true;  // Restarted meanwhile
+    const bool more = next_samples();
+    slot->generation = generation;
+    slot->last = !more;
+    slot->channels = channels_;
+    if (more) {
+      const size_t len = samples_per_frame * channels_;
+      std::copy_n(pending_.begin() + pending_offset_, len,
+                  slot->samples.begin());
+      pending_offset_ += len;
+    } else {
+      slot->samples.fill(0);
+    }
+    ring_.push();
+    if (!more)
+      return false;
+  }
+  return true;
+}
+
+bool audio_stream_player::next_samples() {
+  for (;;) {
+    if (!decoder_ && !open_next())
+      break;
+    if (pending_offset_ == pending_.size())
+      channels_ = decoder_->channels();
+    // The frame in progress is completed with silence when the next file
+    // has another channel count.
+    if (decoder_->channels() != channels_)
+      break;
+
+    const size_t frame_len = samples_per_frame * channels_;
+    while (pending_.size() - pending_offset_ < frame_len) {
+      // Less than a frame left to move, once per packet
+      pending_.erase(pending_.begin(), pending_.begin() + pending_offset_);
+      pending_offset_ = 0;
+      const bool more = decoder_->decode(pending_);
+      if (skip_samples_ > 0) {
+        const size_t skipped =
+            std::min(skip_samples_ * channels_, pending_.size());
+        pending_offset_ = skipped;
+        skip_samples_ -= skipped / channels_;
+      }
+      if (!more)
+        break;
+    }
+    if (pending_.size() - pending_offset_ >= frame_len)
+      return true;
+    // End of the file, its tail starts the frame of the next one
+    decoder_.reset();
+    skip_samples_ = 0;
+  }
+
+  if (pending_offset_ == pending_.size())
+    return false;
+  pending_.erase(pending_.begin(), pending_.begin() + pending_offset_);
+  pending_offset_ = 0;
+  pending_.resize(samples_per_frame * channels_, 0);
+  return true;
+}
+
+bool audio_stream_player::open_next() {
+  // Give up after trying every file once, when none of them can be decoded
+  for (size_t attempt = 0;; ++attempt) {
+    std::string file;
+    {
+      std::lock_guard<std::mutex> lock(decode_lock_);
+      if (attempt > playlist_.size())
+        return false;
+      if (current_ >= playlist_.size()) {
+        if (!loop_ || playlist_.empty())
+          return false;
+        current_ = 0;
+      }
+      file = playlist_[current_++];
+    }
+    try {
+      decoder_ = std::make_unique<audio_stream_decoder>(file);
+      return true;
+    } catch (const std::exception& ex) {
+      std::cerr << ex.what() << ", skipping it" << std::endl;
+    }
+  }
+}
+
+void audio_stream_player::tick(std::chrono::steady_clock::time_point now) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!playing()) {
+    idle_ = true;
+    return;
+  }
+  if (idle_) {
+    next_tick_ = now;
+    idle_ = false;
+  }
+  check_lag(now);
+  while (playing() && next_tick_ <= now) {
+    inject_next(lock);
+    next_tick_ += frame_duration;
+  }
+}
+
+void audio_stream_player::run() {
+  trace::set_thread_name("audio_stream_player");
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!quit_) {
+    if (!playing()) {
+      cond_.wait(lock, [this]() { return quit_ || playing(); });
+      next_tick_ = std::chrono::steady_clock::now();
+      continue;
+    }
+
+    inject_next(lock);
+    next_tick_ += frame_duration;
+    check_lag(std::chrono::steady_clock::now());
+    cond_.wait_until(lock, next_tick_, [this]() { return quit_; });
+  }
+}
+
+bool audio_stream_player::playing() const {
+  return capture_ && !paused_ && !finished_;
+}
+
+void audio_stream_player::inject_next(std::unique_lock<std::mutex>& lock) {
+  // The ring is only consumed under the lock, by a single thread at a time
+  const uint64_t generation = generation_.load(std::memory_order_acquire);
+  frame_slot* slot = ring_.front();
+  bool dropped = false;
+  while (slot && slot->generation != generation) {
+    ring_.pop();
+    slot = ring_.front();
+    dropped = true;
+  }
+  if (dropped)
+    decode_cond_.notify_one();
+  if (metrics_)
+    metrics_->audio.queued.set(static_cast<double>(ring_.size()));
+  if (!slot) {
+    if (metrics_)
+      metrics_->audio.underruns.inc();
+    trace::instant("pacing", "audio underrun");
+    return;
+  }
+
+  auto frame = std::make_unique<stream_frame>(slot->samples.data(),
+                                              slot->channels);
+  const bool last = slot->last;
+  ring_.pop();
+  if (ring_.size() == low_watermark)
+    decode_cond_.notify_one();
+  if (last)
+    finished_ = true;
+  lock.unlock();
+  injector_.inject_audio_frame(std::move(frame));
+  if (last && on_finished_)
+    on_finished_();
+  lock.lock();
+}
+
+void audio_stream_player::check_lag(std::chrono::steady_clock::time_point now) {
+  const auto late = now - next_tick_;
+  if (late > frame_duration)
+    trace::instant("pacing", "audio stall",
+                   "\"late_us\": " + std::to_string(trace::to_us(late)));
+  if (late > max_lag)
+    next_tick_ = now;
+}
+
+}  // namespace dolbyio::comms::sample
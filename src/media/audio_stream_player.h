@@ -0,0 +1,139 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/audio_decoder.h"
+#include "utils/metrics.h"
+#include "utils/spsc_ring.h"
+
+#include <dolbyio/comms/multimedia_streaming/injector.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Plays a playlist of media files into the injector in real time, decoding
+ * their audio on a thread of its own a little ahead of the injection.
+ *
+ * The decoder thread and the injecting thread share a ring of 10ms frames
+ * only. The decoder fills it up to its capacity (the high watermark), then
+ * sleeps until the injection has drained it down to the low watermark, so
+ * that a decoding burst never delays the injection and the memory held per
+ * bot is bounded by the ring, whatever the length of the files. A frame due
+ * while the ring is empty is skipped and counted as an underrun.
+ *
+ * As the pcm_player, the frames are paced by a thread of the player or by
+ * the caller of tick().
+ */
+class audio_stream_player {
+ public:
+  using finished_cb = std::function<void()>;
+  static constexpr std::chrono::milliseconds frame_duration{10};
+  static constexpr size_t ring_frames = 50;
+  static constexpr size_t low_watermark = 20;
+  static constexpr size_t max_channels = 2;
+  static constexpr size_t samples_per_frame =
+      injection_sample_rate * frame_duration.count() / 1000;
+
+  audio_stream_player(plugin::injector& injector,
+                      bool loop,
+                      finished_cb&& on_finished,
+                      std::shared_ptr<metrics::injection_metrics> metrics,
+                      bool external_clock = false);
+  ~audio_stream_player();
+
+  void play(std::vector<std::string> playlist);
+  void add_to_playlist(const std::string& file);
+
+  void set_capture(bool enabled);
+  bool pause();
+  bool resume();
+  // Drops the whole ring: the frames due until the decoder has reopened the
+  // file and decoded the first frames at the position are underruns.
+  bool seek(std::chrono::milliseconds position);
+
+  // With an external clock, injects the frames due at the given time.
+  void tick(std::chrono::steady_clock::time_point now);
+
+ private:
+  struct frame_slot {
+    std::array<int16_t, samples_per_frame * max_channels> samples;
+    int channels;
+    // Frames of a previous generation were decoded before a play() or
+    // seek(), the injection drops them.
+    uint64_t generation;
+    // Last frame of the playlist when not looping
+    bool last;
+  };
+
+  // Decoder thread
+  void decode();
+  bool fill(uint64_t generation);
+  bool next_samples();
+  bool open_next();
+  void restart(size_t file, std::chrono::milliseconds position);
+
+  // Injection
+  void run();
+  bool playing() const;
+  void inject_next(std::unique_lock<std::mutex>& lock);
+  void check_lag(std::chrono::steady_clock::time_point now);
+
+  plugin::injector& injector_;
+  const bool loop_;
+  finished_cb on_finished_;
+  std::shared_ptr<metrics::injection_metrics> metrics_;
+
+  spsc_ring<frame_slot> ring_{ring_frames};
+  std::atomic<uint64_t> generation_{0};
+
+  // Decoder state, the playlist and requests under decode_lock_, the rest
+  // owned by the decoder thread.
+  std::mutex decode_lock_{};
+  std::condition_variable decode_cond_{};
+  std::vector<std::string> playlist_{};
+  size_t current_{0};  // Next file to decode
+  std::chrono::milliseconds start_position_{0};
+  bool restart_{false};
+  bool ended_{false};
+  bool decode_quit_{false};
+  std::unique_ptr<audio_stream_decoder> decoder_{};
+  // Decoded samples not yet in a frame, of channels_ channels, from
+  // pending_offset_ on. The consumed samples are compacted away before
+  // decoding the next packet.
+  std::vector<int16_t> pending_{};
+  size_t pending_offset_{0};
+  int channels_{1};
+  size_t skip_samples_{0};
+  std::thread decode_thread_{};
+
+  // Injection state
+  std::mutex lock_{};
+  std::condition_variable cond_{};
+  bool capture_{false};
+  bool paused_{false};
+  bool finished_{false};
+  bool quit_{false};
+  bool idle_{true};
+  std::chrono::steady_clock::time_point next_tick_{};
+  std::thread thread_{};
+};
+
+}  // namespace dolbyio::comms::sample
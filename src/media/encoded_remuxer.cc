@@ -0,0 +1,253 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/encoded_remuxer.h"
+#include "media/ffmpeg_decoder.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+constexpr int io_buffer_size = 64 * 1024;
+constexpr AVRational microseconds{1, 1000000};
+
+// SPS and PPS of an Annex B key frame, with their start codes. The muxers
+// convert them into the decoder configuration of the container.
+std::vector<uint8_t> h264_parameter_sets(const uint8_t* data, size_t size) {
+  std::vector<uint8_t> out;
+  size_t pos = 0;
+  auto next_start = [&](size_t from) {
+    for (size_t i = from; i + 3 <= size; ++i)
+      if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+        return i;
+    return size;
+  };
+  pos = next_start(0);
+  while (pos < size) {
+    const size_t nal = pos + 3;
+    size_t end = next_start(nal);
+    const size_t next = end;
+    // A four byte start code leaves a zero at the end of the previous unit
+    while (end > nal && data[end - 1] == 0)
+      --end;
+    const int type = nal < size ? data[nal] & 0x1f : 0;
+    if (type == 7 || type == 8) {
+      static const uint8_t start_code[] = {0, 0, 0, 1};
+      out.insert(out.end(), start_code, start_code + 4);
+      out.insert(out.end(), data + nal, data + end);
+    }
+    pos = next;
+  }
+  return out;
+}
+
+}  // namespace
+
+encoded_remuxer::encoded_remuxer(std::shared_ptr<batched_writer::file> media,
+                                 std::shared_ptr<batched_writer::file> index,
+                                 container format,
+                                 AVCodecID codec)
+    : media_(std::move(media)),
+      index_(std::move(index)),
+      format_(format),
+      codec_(codec) {
+  if (codec_ != AV_CODEC_ID_H264 && codec_ != AV_CODEC_ID_VP8)
+    throw std::runtime_error("Only H264 and VP8 can be remuxed");
+  if (codec_ == AV_CODEC_ID_VP8 && format_ == container::mp4)
+    throw std::runtime_error("VP8 cannot be stored in MP4");
+}
+
+encoded_remuxer::~encoded_remuxer() {
+  finish();
+}
+
+void encoded_remuxer::open(const encoded_video_frame& key_frame) {
+  const char* name = format_ == container::mp4 ? "mp4" : "matroska";
+  int ret = avformat_alloc_output_context2(&muxer_, nullptr, name, nullptr);
+  if (ret < 0)
+    throw std::runtime_error("Failed to create the " + std::string(name) +
+                             " muxer: " + av_error_string(ret));
+
+  // The muxer only ever appends, there is no seeking back to patch sizes
+  auto* buffer = static_cast<unsigned char*>(av_malloc(io_buffer_size));
+  io_ = avio_alloc_context(buffer, io_buffer_size, 1, this, nullptr,
+                           &write_packet, nullptr);
+  if (!buffer || !io_) {
+    av_free(buffer);
+    throw std::bad_alloc();
+  }
+  io_->seekable = 0;
+  io_->write_data_type = &write_data;
+  muxer_->pb = io_;
+
+  AVStream* stream = avformat_new_stream(muxer_, nullptr);
+  if (!stream)
+    throw std::bad_alloc();
+  stream->time_base = microseconds;
+  AVCodecParameters* par = stream->codecpar;
+  par->codec_type = AVMEDIA_TYPE_VIDEO;
+  par->codec_id = codec_;
+  par->width = key_frame.width();
+  par->height = key_frame.height();
+  if (codec_ == AV_CODEC_ID_H264) {
+    const auto sets = h264_parameter_sets(key_frame.data(), key_frame.size());
+    par->extradata = static_cast<uint8_t*>(
+        av_mallocz(sets.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+    if (!par->extradata)
+      throw std::bad_alloc();
+    std::memcpy(par->extradata, sets.data(), sets.size());
+    par->extradata_size = static_cast<int>(sets.size());
+  }
+
+  AVDictionary* options = nullptr;
+  if (format_ == container::mp4)
+    av_dict_set(&options, "movflags",
+                "frag_keyframe+empty_moov+default_base_moof", 0);
+  else
+    av_dict_set(&options, "live", "1", 0);
+  ret = avformat_write_header(muxer_, &options);
+  av_dict_free(&options);
+  if (ret < 0)
+    throw std::runtime_error("Failed to write the " + std::string(name) +
+                             " header: " + av_error_string(ret));
+  avio_flush(io_);
+  media_->set_header(std::move(header_));
+
+  packet_ = av_packet_alloc();
+  if (!packet_)
+    throw std::bad_alloc();
+}
+
+void encoded_remuxer::add_frame(const encoded_video_frame& frame,
+                                int64_t time_us) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (failed_ || finished_)
+    return;
+  try {
+    if (!muxer_) {
+      if (!frame.is_keyframe())
+        return;
+      open(frame);
+    }
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << ", not recording the track" << std::endl;
+    release();
+    failed_ = true;
+    return;
+  }
+
+  AVStream* stream = muxer_->streams[0];
+  int64_t pts = av_rescale_q(time_us, microseconds, stream->time_base);
+  if (last_pts_ != AV_NOPTS_VALUE && pts <= last_pts_)
+    pts = last_pts_ + 1;
+  last_pts_ = pts;
+
+  // The muxer copies the packet, which only references the frame
+  packet_->data = const_cast<uint8_t*>(frame.data());
+  packet_->size = static_cast<int>(frame.size());
+  packet_->pts = pts;
+  packet_->dts = pts;
+  packet_->stream_index = 0;
+  packet_->flags = frame.is_keyframe() ? AV_PKT_FLAG_KEY : 0;
+  const int ret = av_write_frame(muxer_, packet_);
+  packet_->data = nullptr;
+  packet_->size = 0;
+  if (ret < 0) {
+    std::cerr << "Failed to remux a frame: " << av_error_string(ret)
+              << std::endl;
+    return;
+  }
+  // A fragment is complete when the muxer writes it out
+  avio_flush(io_);
+  end_record();
+}
+
+void encoded_remuxer::finish() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (finished_)
+    return;
+  finished_ = true;
+  if (muxer_) {
+    av_write_trailer(muxer_);
+    avio_flush(io_);
+    end_record();
+  }
+  release();
+}
+
+void encoded_remuxer::release() {
+  av_packet_free(&packet_);
+  if (io_) {
+    av_freep(&io_->buffer);
+    avio_context_free(&io_);
+  }
+  if (muxer_) {
+    muxer_->pb = nullptr;
+    avformat_free_context(muxer_);
+    muxer_ = nullptr;
+  }
+}
+
+int encoded_remuxer::write_packet(void* opaque, avio_buffer data, int size) {
+  return write_data(opaque, data, size, AVIO_DATA_MARKER_UNKNOWN,
+                    AV_NOPTS_VALUE);
+}
+
+int encoded_remuxer::write_data(void* opaque,
+                                avio_buffer data,
+                                int size,
+                                AVIODataMarkerType type,
+                                int64_t time) {
+  auto* self = static_cast<encoded_remuxer*>(opaque);
+  switch (type) {
+    case AVIO_DATA_MARKER_HEADER:
+      self->header_.insert(self->header_.end(), data, data + size);
+      return size;
+    case AVIO_DATA_MARKER_SYNC_POINT:
+    case AVIO_DATA_MARKER_BOUNDARY_POINT:
+      // Start of a fragment, the time is in AV_TIME_BASE units
+      self->end_record();
+      self->record_sync_ = type == AVIO_DATA_MARKER_SYNC_POINT;
+      self->record_time_us_ = time;
+      break;
+    default:
+      break;
+  }
+  self->record_.insert(self->record_.end(), data, data + size);
+  return size;
+}
+
+void encoded_remuxer::end_record() {
+  if (record_.empty())
+    return;
+  if (media_->begin_record(record_.size(), record_sync_)) {
+    media_->append(record_.data(), record_.size());
+    if (record_sync_ && record_time_us_ != AV_NOPTS_VALUE) {
+      // The fragment goes to the writer thread ahead of its index entry
+      media_->commit();
+      const std::string entry = std::to_string(media_->segment()) + " " +
+                                std::to_string(media_->record_offset()) +
+                                " " + std::to_string(record_time_us_ / 1000) +
+                                "\n";
+      if (index_->begin_record(entry.size())) {
+        index_->append(entry.data(), entry.size());
+        index_->commit();
+      }
+    }
+  }
+  record_.clear();
+  record_sync_ = false;
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,102 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/batched_writer.h"
+
+#include <dolbyio/comms/media_engine/media_engine.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Remuxes the encoded frames of a received video track, as they come, into
+ * a fragmented MP4 or a live Matroska file, with no decoding.
+ *
+ * The muxer writes into memory: the container header becomes the header of
+ * the segments of the file, and every fragment (MP4) or cluster (Matroska),
+ * which starts on a key frame, a record which may start a new segment. The
+ * bytes are written to disk by the batched_writer.
+ *
+ * Once a fragment has been handed to the writer, a line is appended to the
+ * index file: "<segment> <offset> <time_ms>", the byte offset of the
+ * fragment in the segment and its time since the start of the track. The
+ * index only references fragments written before it, so a reader can seek
+ * in a file which is still being recorded.
+ */
+class encoded_remuxer {
+ public:
+  enum class container { matroska, mp4 };
+
+  // Throws std::runtime_error if the codec cannot be stored in the
+  // container.
+  encoded_remuxer(std::shared_ptr<batched_writer::file> media,
+                  std::shared_ptr<batched_writer::file> index,
+                  container format,
+                  AVCodecID codec);
+  ~encoded_remuxer();
+
+  encoded_remuxer(const encoded_remuxer&) = delete;
+  encoded_remuxer& operator=(const encoded_remuxer&) = delete;
+
+  // Frames are dropped until the first key frame, which opens the muxer.
+  // Called from the media thread of the SDK, concurrently with finish().
+  void add_frame(const encoded_video_frame& frame, int64_t time_us);
+  // Writes the last fragment and the trailer, the frames added afterwards
+  // are dropped.
+  void finish();
+
+ private:
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+  using avio_buffer = const uint8_t*;
+#else
+  using avio_buffer = uint8_t*;
+#endif
+  static int write_data(void* opaque,
+                        avio_buffer data,
+                        int size,
+                        AVIODataMarkerType type,
+                        int64_t time);
+  static int write_packet(void* opaque, avio_buffer data, int size);
+
+  void open(const encoded_video_frame& key_frame);
+  void end_record();
+  void release();
+
+  std::shared_ptr<batched_writer::file> media_;
+  std::shared_ptr<batched_writer::file> index_;
+  const container format_;
+  const AVCodecID codec_;
+
+  // Serializes the frames and finish()
+  std::mutex lock_{};
+  bool finished_{false};
+  AVFormatContext* muxer_{nullptr};
+  AVIOContext* io_{nullptr};
+  AVPacket* packet_{nullptr};
+  int64_t last_pts_{AV_NOPTS_VALUE};
+  bool failed_{false};
+
+  // Bytes written by the muxer since the last marker
+  std::vector<uint8_t> header_{};
+  std::vector<uint8_t> record_{};
+  bool record_sync_{false};
+  int64_t record_time_us_{0};
+};
+
+}  // namespace dolbyio::comms::sample
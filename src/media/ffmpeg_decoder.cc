@@ -0,0 +1,162 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/ffmpeg_decoder.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Drop the references of the packet and of the frame on leaving the scope,
+// including when the frame callback throws.
+struct packet_unref {
+  AVPacket* packet;
+  ~packet_unref() { av_packet_unref(packet); }
+};
+
+struct frame_unref {
+  AVFrame* frame;
+  ~frame_unref() { av_frame_unref(frame); }
+};
+
+}  // namespace
+
+std::string av_error_string(int err) {
+  char buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+  av_strerror(err, buf, sizeof(buf));
+  return buf;
+}
+
+void preload_ffmpeg() {
+  void* opaque = nullptr;
+  while (av_demuxer_iterate(&opaque)) {
+  }
+  opaque = nullptr;
+  while (av_codec_iterate(&opaque)) {
+  }
+}
+
+ffmpeg_decoder::ffmpeg_decoder(const std::string& path, AVMediaType type)
+    : decode_time_(metrics::registry::instance().get_histogram(
+          "decode_frame_seconds",
+          "Time spent decoding a frame of the injected media.",
+          {{"media", type == AVMEDIA_TYPE_AUDIO ? "audio" : "video"}})) {
+  try {
+    int ret = avformat_open_input(&format_, path.c_str(), nullptr, nullptr);
+    if (ret < 0)
+      throw std::runtime_error("Failed to open " + path + ": " +
+                               av_error_string(ret));
+    ret = avformat_find_stream_info(format_, nullptr);
+    if (ret < 0)
+      throw std::runtime_error("Failed to read stream info of " + path);
+
+    const AVCodec* codec = nullptr;
+    stream_ = av_find_best_stream(format_, type, -1, -1, &codec, 0);
+    if (stream_ < 0 || !codec)
+      throw std::runtime_error("No decodable stream of the requested type in " +
+                               path);
+
+    codec_ = avcodec_alloc_context3(codec);
+    if (!codec_ || avcodec_parameters_to_context(
+                       codec_, format_->streams[stream_]->codecpar) < 0)
+      throw std::runtime_error("Failed to setup decoder for " + path);
+    ret = avcodec_open2(codec_, codec, nullptr);
+    if (ret < 0)
+      throw std::runtime_error("Failed to open decoder for " + path + ": " +
+                               av_error_string(ret));
+    packet_ = av_packet_alloc();
+    frame_ = av_frame_alloc();
+    if (!packet_ || !frame_)
+      throw std::runtime_error("Out of memory decoding " + path);
+  } catch (...) {
+    release();
+    throw;
+  }
+}
+
+ffmpeg_decoder::~ffmpeg_decoder() {
+  release();
+}
+
+void ffmpeg_decoder::release() {
+  av_frame_free(&frame_);
+  av_packet_free(&packet_);
+  avcodec_free_context(&codec_);
+  avformat_close_input(&format_);
+}
+
+bool ffmpeg_decoder::has_stream(const std::string& path, AVMediaType type) {
+  AVFormatContext* format = nullptr;
+  if (avformat_open_input(&format, path.c_str(), nullptr, nullptr) < 0)
+    return false;
+  bool found = avformat_find_stream_info(format, nullptr) >= 0 &&
+               av_find_best_stream(format, type, -1, -1, nullptr, 0) >= 0;
+  avformat_close_input(&format);
+  return found;
+}
+
+AVRational ffmpeg_decoder::time_base() const {
+  return format_->streams[stream_]->time_base;
+}
+
+double ffmpeg_decoder::duration() const {
+  const AVStream* stream = format_->streams[stream_];
+  if (stream->duration != AV_NOPTS_VALUE && stream->duration > 0)
+    return stream->duration * av_q2d(stream->time_base);
+  if (format_->duration != AV_NOPTS_VALUE && format_->duration > 0)
+    return static_cast<double>(format_->duration) / AV_TIME_BASE;
+  return 0;
+}
+
+int ffmpeg_decoder::channels() const {
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 24, 100)
+  return codec_->ch_layout.nb_channels;
+#else
+  return codec_->channels;
+#endif
+}
+
+void ffmpeg_decoder::decode_all(const frame_callback& on_frame) {
+  while (decode_packet(on_frame)) {
+  }
+}
+
+bool ffmpeg_decoder::decode_packet(const frame_callback& on_frame) {
+  if (drained_)
+    return false;
+  while (av_read_frame(format_, packet_) >= 0) {
+    packet_unref unref{packet_};
+    if (packet_->stream_index != stream_)
+      continue;
+    send_and_receive(packet_, on_frame);
+    return true;
+  }
+  // Flush the decoder
+  send_and_receive(nullptr, on_frame);
+  drained_ = true;
+  return false;
+}
+
+void ffmpeg_decoder::send_and_receive(const AVPacket* packet,
+                                      const frame_callback& on_frame) {
+  auto start = std::chrono::steady_clock::now();
+  if (avcodec_send_packet(codec_, packet) < 0)
+    return;  // Skip corrupted packets, decoding continues with the next one
+  while (avcodec_receive_frame(codec_, frame_) >= 0) {
+    frame_unref unref{frame_};
+    decode_time_.observe(std::chrono::steady_clock::now() - start);
+    on_frame(frame_);
+    start = std::chrono::steady_clock::now();
+  }
+}
+
+}  // namespace dolbyio::comms::sample
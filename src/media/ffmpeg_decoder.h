@@ -0,0 +1,76 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/metrics.h"
+
+#include <functional>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace dolbyio::comms::sample {
+
+std::string av_error_string(int err);
+
+// Walk the demuxer and codec tables, which pulls them into memory. Used by
+// the zygote to do it once for all of the bots it forks.
+void preload_ffmpeg();
+
+/**
+ * Demuxer and decoder of the best stream of the given media type in a file.
+ * Used for decoding the whole stream in one go, which is what the decode once
+ * cache and the offline asset preparation do.
+ */
+class ffmpeg_decoder {
+ public:
+  using frame_callback = std::function<void(const AVFrame*)>;
+
+  // Throws std::runtime_error if the file cannot be opened or has no
+  // decodable stream of the type.
+  ffmpeg_decoder(const std::string& path, AVMediaType type);
+  ~ffmpeg_decoder();
+
+  ffmpeg_decoder(const ffmpeg_decoder&) = delete;
+  ffmpeg_decoder& operator=(const ffmpeg_decoder&) = delete;
+
+  // Check without throwing if the file has a stream of the given type.
+  static bool has_stream(const std::string& path, AVMediaType type);
+
+  const AVCodecContext* codec() const { return codec_; }
+  AVRational time_base() const;
+  int channels() const;
+  // Duration of the stream, or of the file when the stream does not tell,
+  // in seconds. 0 when unknown.
+  double duration() const;
+
+  // Decode the whole stream, the callback is invoked for every frame.
+  void decode_all(const frame_callback& on_frame);
+  // Decode the next packet of the stream, the callback is invoked for the
+  // frames it completes. Returns false once the stream has been drained.
+  bool decode_packet(const frame_callback& on_frame);
+
+ private:
+  void release();
+  void send_and_receive(const AVPacket* packet, const frame_callback& cb);
+
+  AVFormatContext* format_{nullptr};
+  AVCodecContext* codec_{nullptr};
+  AVPacket* packet_{nullptr};
+  AVFrame* frame_{nullptr};
+  int stream_{-1};
+  bool drained_{false};
+  metrics::histogram& decode_time_;
+};
+
+}  // namespace dolbyio::comms::sample
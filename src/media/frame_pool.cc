@@ -0,0 +1,154 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/frame_pool.h"
+
+#include <algorithm>
+#include <new>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Trivially destructible, thus still readable by the destructors running
+// after that of the cache on an exiting thread
+thread_local bool cache_destroyed = false;
+
+}  // namespace
+
+frame_pool& frame_pool::instance() {
+  // Never destroyed: the SDK may still release frames while the process
+  // exits.
+  static frame_pool* pool = new frame_pool;
+  return *pool;
+}
+
+frame_pool::size_class::size_class(size_t size)
+    : hits(metrics::registry::instance().get_counter(
+          "frame_pool_hits_total",
+          "Frames allocated from the memory of a released frame.",
+          {{"size", std::to_string(size)}})),
+      misses(metrics::registry::instance().get_counter(
+          "frame_pool_misses_total",
+          "Frames allocated from the global allocator.",
+          {{"size", std::to_string(size)}})),
+      cached_bytes(metrics::registry::instance().get_gauge(
+          "frame_pool_cached_bytes",
+          "Memory of the released frames kept for reuse.",
+          {{"size", std::to_string(size)}})) {}
+
+frame_pool::size_class& frame_pool::get_class(size_t size) {
+  auto it = classes_.find(size);
+  if (it == classes_.end())
+    it = classes_.try_emplace(size, size).first;
+  return it->second;
+}
+
+struct frame_pool::thread_cache {
+  struct list {
+    size_t size;
+    size_class* cls;
+    std::vector<void*> blocks{};
+  };
+
+  // The blocks of an exiting thread go back to the shared lists
+  ~thread_cache() {
+    cache_destroyed = true;
+    for (auto& l : lists)
+      frame_pool::instance().give(*l.cls, l.size, l.blocks, l.blocks.size());
+  }
+
+  // A thread handles the frames of a few formats only
+  list& get(size_t size) {
+    for (auto& l : lists)
+      if (l.size == size)
+        return l;
+    auto& pool = frame_pool::instance();
+    size_class* cls = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(pool.lock_);
+      cls = &pool.get_class(size);
+    }
+    lists.push_back({size, cls});
+    lists.back().blocks.reserve(2 * batch);
+    return lists.back();
+  }
+
+  std::vector<list> lists{};
+};
+
+frame_pool::thread_cache* frame_pool::local_cache() {
+  if (cache_destroyed)
+    return nullptr;
+  thread_local thread_cache cache;
+  return &cache;
+}
+
+void frame_pool::take(size_class& cls,
+                      size_t size,
+                      std::vector<void*>& blocks,
+                      size_t count) {
+  std::lock_guard<std::mutex> lock(lock_);
+  const size_t moved = std::min(count, cls.free.size());
+  blocks.insert(blocks.end(), cls.free.end() - moved, cls.free.end());
+  cls.free.resize(cls.free.size() - moved);
+  cls.cached_bytes.set(static_cast<double>(cls.free.size() * size));
+}
+
+void frame_pool::give(size_class& cls,
+                      size_t size,
+                      std::vector<void*>& blocks,
+                      size_t count) {
+  auto first = blocks.end() - count;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    const size_t room = max_cached_bytes / size - cls.free.size();
+    const size_t kept = std::min(count, room);
+    cls.free.insert(cls.free.end(), first, first + kept);
+    cls.cached_bytes.set(static_cast<double>(cls.free.size() * size));
+    first += kept;
+  }
+  for (auto it = first; it != blocks.end(); ++it)
+    ::operator delete(*it);
+  blocks.resize(blocks.size() - count);
+}
+
+void* frame_pool::allocate(size_t size) {
+  auto* cache = local_cache();
+  if (!cache)
+    return ::operator new(size);
+  auto& l = cache->get(size);
+  if (l.blocks.empty())
+    take(*l.cls, size, l.blocks, batch);
+  if (l.blocks.empty()) {
+    l.cls->misses.inc();
+    return ::operator new(size);
+  }
+  void* block = l.blocks.back();
+  l.blocks.pop_back();
+  l.cls->hits.inc();
+  return block;
+}
+
+void frame_pool::deallocate(void* block, size_t size) {
+  if (!block)
+    return;
+  auto* cache = local_cache();
+  if (!cache) {
+    ::operator delete(block);
+    return;
+  }
+  auto& l = cache->get(size);
+  l.blocks.push_back(block);
+  if (l.blocks.size() >= 2 * batch)
+    give(*l.cls, size, l.blocks, batch);
+}
+
+}  // namespace dolbyio::comms::sample
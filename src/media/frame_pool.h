@@ -0,0 +1,129 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/metrics.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Process wide pool of the memory of the frames handed to the injector. The
+ * frames of a given format always have the same size, so the blocks are
+ * kept on a free list per size and recycled when the SDK deletes the frame,
+ * instead of going through the global allocator 100 times a second per bot.
+ *
+ * Blocks are taken from the free list when possible (a hit) or allocated
+ * (a miss). Every thread keeps its own free lists, of at most 2 * batch blocks
+ * per size, and moves the blocks to and from the shared free lists batch by
+ * batch: the frames are allocated by the player threads and released by the
+ * threads of the SDK, which then take the lock of the pool once every batch
+ * frames. At most max_cached_bytes per size are kept in the shared lists. The
+ * hits, misses and bytes cached in the shared lists are exported in the
+ * metrics registry.
+ */
+class frame_pool {
+ public:
+  static constexpr size_t max_cached_bytes = 4 * 1024 * 1024;
+  static constexpr size_t batch = 32;
+
+  static frame_pool& instance();
+
+  void* allocate(size_t size);
+  void deallocate(void* block, size_t size);
+
+ private:
+  struct size_class {
+    explicit size_class(size_t size);
+
+    std::vector<void*> free{};
+    metrics::counter& hits;
+    metrics::counter& misses;
+    metrics::gauge& cached_bytes;
+  };
+
+  struct thread_cache;
+
+  frame_pool() = default;
+  // Null once the thread is exiting and its cache has been destroyed
+  static thread_cache* local_cache();
+  size_class& get_class(size_t size);
+  // Moves up to count blocks from the shared list into those of the thread.
+  void take(size_class& cls,
+            size_t size,
+            std::vector<void*>& blocks,
+            size_t count);
+  // Moves the last count blocks of the thread into the shared list, and
+  // frees those which do not fit in it.
+  void give(size_class& cls,
+            size_t size,
+            std::vector<void*>& blocks,
+            size_t count);
+
+  std::mutex lock_{};
+  std::map<size_t, size_class> classes_{};
+};
+
+/**
+ * Base of the frame classes allocated from the frame_pool, e.g.:
+ *
+ *   class my_frame : public audio_frame, public pooled_frame { ... };
+ *   auto frame = std::make_unique<my_frame>(...);  // From the pool
+ *
+ * The frame goes back to the pool when deleted through its virtual
+ * destructor, whichever its static type.
+ */
+struct pooled_frame {
+  static void* operator new(size_t size) {
+    return frame_pool::instance().allocate(size);
+  }
+  static void operator delete(void* block, size_t size) {
+    frame_pool::instance().deallocate(block, size);
+  }
+};
+
+/**
+ * Samples allocated from the frame_pool, zeroed, for the frames which cannot
+ * reference the decoded audio.
+ */
+class pooled_samples {
+ public:
+  pooled_samples() = default;
+  explicit pooled_samples(size_t count)
+      : data_(static_cast<int16_t*>(
+            frame_pool::instance().allocate(count * sizeof(int16_t)))),
+        size_(count) {
+    std::fill_n(data_, size_, int16_t{0});
+  }
+  pooled_samples(pooled_samples&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+  pooled_samples& operator=(pooled_samples&&) = delete;
+  ~pooled_samples() {
+    frame_pool::instance().deallocate(data_, size_ * sizeof(int16_t));
+  }
+
+  int16_t* data() { return data_; }
+  const int16_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  int16_t* data_{nullptr};
+  size_t size_{0};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,220 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/inj_file.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+struct source_info {
+  int64_t mtime_ns;
+  uint64_t size;
+};
+
+source_info stat_source(const std::string& path) {
+  struct stat st {};
+  if (stat(path.c_str(), &st) < 0)
+    throw std::runtime_error("Cannot stat " + path + ": " + strerror(errno));
+  return {static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+              st.st_mtim.tv_nsec,
+          static_cast<uint64_t>(st.st_size)};
+}
+
+void copy_plane(uint8_t* dst,
+                const uint8_t* src,
+                int stride,
+                int width,
+                int height) {
+  for (int row = 0; row < height; ++row)
+    std::memcpy(dst + static_cast<size_t>(row) * width, src + row * stride,
+                width);
+}
+
+}  // namespace
+
+inj_writer::inj_writer(const std::string& path, const std::string& source)
+    : path_(path), tmp_path_(path + ".tmp." + std::to_string(getpid())) {
+  const auto info = stat_source(source);
+  header_.magic = inj::magic;
+  header_.version = inj::version;
+  header_.source_mtime_ns = info.mtime_ns;
+  header_.source_size = info.size;
+
+  file_ = fopen(tmp_path_.c_str(), "wb");
+  if (!file_)
+    throw std::runtime_error("Cannot create " + tmp_path_ + ": " +
+                             strerror(errno));
+  // Room for the header, it is written last
+  write(&header_, sizeof(header_));
+  pad_to_alignment();
+}
+
+inj_writer::~inj_writer() {
+  if (file_) {
+    fclose(file_);
+    unlink(tmp_path_.c_str());
+  }
+}
+
+void inj_writer::write_audio(const pcm_buffer& audio) {
+  if (header_.frame_size)
+    throw std::runtime_error("Audio must be written before the video");
+  header_.sample_rate = audio.sample_rate;
+  header_.channels = audio.channels;
+  header_.audio_offset = offset_;
+  header_.audio_samples_per_channel = audio.samples_per_channel;
+  write(audio.data, audio.size() * sizeof(int16_t));
+  pad_to_alignment();
+}
+
+void inj_writer::add_video_frame(const i420_picture& picture) {
+  if (!header_.frame_size) {
+    header_.width = picture.width;
+    header_.height = picture.height;
+    header_.frame_size = i420_size(picture.width, picture.height);
+    packed_.resize(header_.frame_size);
+  } else if (picture.width != header_.width ||
+             picture.height != header_.height) {
+    throw std::runtime_error("Resolution changes are not supported in " +
+                             path_);
+  }
+
+  const int chroma_width = (picture.width + 1) / 2;
+  const int chroma_height = (picture.height + 1) / 2;
+  uint8_t* y = packed_.data();
+  uint8_t* u = y + static_cast<size_t>(picture.width) * picture.height;
+  uint8_t* v = u + static_cast<size_t>(chroma_width) * chroma_height;
+  copy_plane(y, picture.y, picture.stride_y, picture.width, picture.height);
+  copy_plane(u, picture.u, picture.stride_u, chroma_width, chroma_height);
+  copy_plane(v, picture.v, picture.stride_v, chroma_width, chroma_height);
+
+  index_.push_back({offset_, picture.timestamp_us});
+  write(packed_.data(), packed_.size());
+}
+
+void inj_writer::finish() {
+  pad_to_alignment();
+  header_.index_offset = offset_;
+  header_.frame_count = index_.size();
+  if (!index_.empty()) {
+    const int64_t span =
+        index_.back().timestamp_us - index_.front().timestamp_us;
+    // The last frame is shown for as long as the average frame
+    const int64_t last_frame =
+        index_.size() > 1 ? span / static_cast<int64_t>(index_.size() - 1)
+                          : 33333;
+    header_.video_duration_us = span + last_frame;
+    write(index_.data(), index_.size() * sizeof(inj::frame_index_entry));
+  }
+
+  if (fseek(file_, 0, SEEK_SET) != 0 ||
+      fwrite(&header_, sizeof(header_), 1, file_) != 1 || fflush(file_) != 0)
+    throw std::runtime_error("Failed to write the header of " + tmp_path_);
+  fclose(file_);
+  file_ = nullptr;
+  if (rename(tmp_path_.c_str(), path_.c_str()) < 0) {
+    unlink(tmp_path_.c_str());
+    throw std::runtime_error("Failed to move " + tmp_path_ + " into place");
+  }
+}
+
+void inj_writer::write(const void* data, size_t len) {
+  if (len && fwrite(data, 1, len, file_) != len)
+    throw std::runtime_error("Failed to write " + tmp_path_ + ": " +
+                             strerror(errno));
+  offset_ += len;
+}
+
+void inj_writer::pad_to_alignment() {
+  static const uint8_t zeros[inj::alignment] = {};
+  const uint64_t rem = offset_ % inj::alignment;
+  if (rem)
+    write(zeros, inj::alignment - rem);
+}
+
+std::shared_ptr<const inj_file> inj_file::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT)
+      return nullptr;
+    throw std::runtime_error("Cannot open " + path + ": " + strerror(errno));
+  }
+  struct stat st {};
+  if (fstat(fd, &st) < 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(inj::file_header)) {
+    close(fd);
+    throw std::runtime_error("Invalid prepared asset " + path);
+  }
+  const size_t len = st.st_size;
+  void* addr = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    throw std::runtime_error("Cannot map " + path + ": " + strerror(errno));
+
+  std::shared_ptr<inj_file> file{new inj_file()};
+  file->path_ = path;
+  file->mapping_ = std::shared_ptr<const void>(
+      addr, [len](const void* p) { munmap(const_cast<void*>(p), len); });
+  file->base_ = static_cast<const uint8_t*>(addr);
+  file->header_ = reinterpret_cast<const inj::file_header*>(file->base_);
+
+  const auto& hdr = *file->header_;
+  if (hdr.magic != inj::magic || hdr.version != inj::version)
+    throw std::runtime_error("Not a prepared asset (or a stale version): " +
+                             path);
+  const uint64_t audio_end =
+      hdr.audio_offset +
+      hdr.audio_samples_per_channel * hdr.channels * sizeof(int16_t);
+  const uint64_t index_end =
+      hdr.index_offset + hdr.frame_count * sizeof(inj::frame_index_entry);
+  if (audio_end > len || (hdr.frame_count && index_end > len))
+    throw std::runtime_error("Truncated prepared asset " + path);
+  file->index_ = reinterpret_cast<const inj::frame_index_entry*>(
+      file->base_ + hdr.index_offset);
+  for (size_t i = 0; i < hdr.frame_count; ++i)
+    if (file->index_[i].offset + hdr.frame_size > len)
+      throw std::runtime_error("Truncated prepared asset " + path);
+  return file;
+}
+
+bool inj_file::prepared_from(const std::string& source) const {
+  struct stat st {};
+  if (stat(source.c_str(), &st) < 0)
+    return false;
+  const int64_t mtime_ns =
+      static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  return header_->source_mtime_ns == mtime_ns &&
+         header_->source_size == static_cast<uint64_t>(st.st_size);
+}
+
+std::shared_ptr<const pcm_buffer> inj_file::audio() const {
+  if (!header_->audio_samples_per_channel)
+    return nullptr;
+  auto buffer = std::make_shared<pcm_buffer>();
+  buffer->source = path_;
+  buffer->sample_rate = header_->sample_rate;
+  buffer->channels = header_->channels;
+  buffer->samples_per_channel = header_->audio_samples_per_channel;
+  buffer->data =
+      reinterpret_cast<const int16_t*>(base_ + header_->audio_offset);
+  buffer->storage = mapping_;
+  return buffer;
+}
+
+}  // namespace dolbyio::comms::sample
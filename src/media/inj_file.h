@@ -0,0 +1,133 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/pcm_buffer.h"
+#include "media/video_decoder.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Injection-ready prepared asset (.inj), written by cpp_injection_prepare
+ * next to the source media file. The file is meant to be memory mapped and
+ * used as is, with no decoding:
+ *
+ *   [header][audio: interleaved s16 PCM][video: packed I420 frames][index]
+ *
+ * Every section starts page aligned, the index holds the offset and the
+ * presentation timestamp of each video frame.
+ */
+namespace inj {
+constexpr char extension[] = ".inj";
+constexpr uint32_t magic = 0x314a4e49;  // "INJ1"
+constexpr uint32_t version = 1;
+constexpr uint64_t alignment = 4096;
+
+struct file_header {
+  uint32_t magic;
+  uint32_t version;
+  // Source file the asset was prepared from, to detect stale assets
+  int64_t source_mtime_ns;
+  uint64_t source_size;
+
+  int32_t sample_rate;
+  int32_t channels;
+  uint64_t audio_offset;
+  uint64_t audio_samples_per_channel;
+
+  int32_t width;
+  int32_t height;
+  uint64_t frame_size;
+  uint64_t frame_count;
+  uint64_t index_offset;
+  int64_t video_duration_us;
+};
+
+struct frame_index_entry {
+  uint64_t offset;
+  int64_t timestamp_us;
+};
+
+// Path of the prepared asset of the given media file.
+inline std::string prepared_path(const std::string& media) {
+  return media + extension;
+}
+}  // namespace inj
+
+/**
+ * Writes a prepared asset. The audio has to be written before the video
+ * frames, which are streamed to the file as they are decoded. The file is
+ * written under a temporary name and renamed into place by finish(), so a
+ * reader never sees a partial asset.
+ */
+class inj_writer {
+ public:
+  inj_writer(const std::string& path, const std::string& source);
+  ~inj_writer();
+
+  void write_audio(const pcm_buffer& audio);
+  void add_video_frame(const i420_picture& picture);
+  void finish();
+
+ private:
+  void write(const void* data, size_t len);
+  void pad_to_alignment();
+
+  std::string path_;
+  std::string tmp_path_;
+  FILE* file_{nullptr};
+  uint64_t offset_{0};
+  inj::file_header header_{};
+  std::vector<inj::frame_index_entry> index_{};
+  std::vector<uint8_t> packed_{};
+};
+
+/**
+ * Read-only memory mapping of a prepared asset.
+ */
+class inj_file {
+ public:
+  // Returns nullptr if the file does not exist, throws std::runtime_error if
+  // the file is not a valid prepared asset.
+  static std::shared_ptr<const inj_file> open(const std::string& path);
+
+  // Whether the asset was prepared from the current version of the source.
+  bool prepared_from(const std::string& source) const;
+
+  // Decoded audio, referencing the mapping. Null if the asset has no audio.
+  std::shared_ptr<const pcm_buffer> audio() const;
+
+  bool has_video() const { return header_->frame_count > 0; }
+  int width() const { return header_->width; }
+  int height() const { return header_->height; }
+  size_t frame_count() const { return header_->frame_count; }
+  int64_t video_duration_us() const { return header_->video_duration_us; }
+  const uint8_t* frame(size_t idx) const { return base_ + index_[idx].offset; }
+  int64_t frame_timestamp_us(size_t idx) const {
+    return index_[idx].timestamp_us;
+  }
+
+ private:
+  inj_file() = default;
+
+  std::string path_{};
+  std::shared_ptr<const void> mapping_{};
+  const uint8_t* base_{nullptr};
+  const inj::file_header* header_{nullptr};
+  const inj::frame_index_entry* index_{nullptr};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,106 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/instrumented_injector.h"
+#include "utils/trace.h"
+
+#include <cmath>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+template <typename Base>
+class instrumented_injector : public Base {
+ public:
+  instrumented_injector(
+      plugin::injector::media_injection_status_cb&& status_cb,
+      std::function<void()>&& on_first_frame,
+      std::shared_ptr<metrics::injection_metrics> metrics)
+      : Base(std::move(status_cb)),
+        probe_(std::move(on_first_frame), std::move(metrics)) {}
+
+  bool inject_audio_frame(std::unique_ptr<audio_frame>&& frame) override {
+    trace::scope scope("injector", "push audio frame");
+    probe_.frame_pushed();
+    const bool accepted = Base::inject_audio_frame(std::move(frame));
+    probe_.audio_pushed(accepted);
+    return accepted;
+  }
+
+  void inject_video_frame(const video_frame& frame) override {
+    trace::scope scope("injector", "push video frame");
+    probe_.frame_pushed();
+    Base::inject_video_frame(frame);
+    probe_.video_pushed();
+  }
+
+ private:
+  injection_probe probe_;
+};
+
+}  // namespace
+
+injection_probe::injection_probe(
+    std::function<void()>&& on_first_frame,
+    std::shared_ptr<metrics::injection_metrics> metrics)
+    : first_frame_cb_(std::move(on_first_frame)),
+      metrics_(std::move(metrics)) {}
+
+void injection_probe::frame_pushed() {
+  if (!first_frame_seen_.load(std::memory_order_relaxed) &&
+      !first_frame_seen_.exchange(true) && first_frame_cb_)
+    first_frame_cb_();
+}
+
+void injection_probe::audio_pushed(bool accepted) {
+  if (!metrics_)
+    return;
+  record_interval(audio_pacing_, metrics_->audio);
+  (accepted ? metrics_->audio.injected : metrics_->audio.dropped).inc();
+}
+
+void injection_probe::video_pushed() {
+  if (!metrics_)
+    return;
+  record_interval(video_pacing_, metrics_->video);
+  metrics_->video.injected.inc();
+}
+
+void injection_probe::record_interval(pacing& state,
+                                      metrics::injection_metrics::media& m) {
+  const auto now = std::chrono::steady_clock::now();
+  if (state.last_push != std::chrono::steady_clock::time_point{}) {
+    const double interval =
+        std::chrono::duration<double>(now - state.last_push).count();
+    m.push_interval.observe(interval);
+    // Interarrival jitter estimator of RFC 3550, applied to the intervals
+    if (state.last_interval > 0) {
+      state.jitter +=
+          (std::abs(interval - state.last_interval) - state.jitter) / 16;
+      m.push_jitter.set(state.jitter);
+    }
+    state.last_interval = interval;
+  }
+  state.last_push = now;
+}
+
+std::shared_ptr<plugin::injector> make_instrumented_injector(
+    bool paced,
+    plugin::injector::media_injection_status_cb&& status_cb,
+    std::function<void()>&& on_first_frame,
+    std::shared_ptr<metrics::injection_metrics> metrics) {
+  if (paced)
+    return std::make_shared<instrumented_injector<plugin::injector_paced>>(
+        std::move(status_cb), std::move(on_first_frame), std::move(metrics));
+  return std::make_shared<instrumented_injector<plugin::injector>>(
+      std::move(status_cb), std::move(on_first_frame), std::move(metrics));
+}
+
+}  // namespace dolbyio::comms::sample
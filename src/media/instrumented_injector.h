@@ -0,0 +1,66 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/metrics.h"
+
+#include <dolbyio/comms/multimedia_streaming/injector.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Observes the frames pushed into an injector: invokes the first frame
+ * callback once and records the frame metrics. The intervals are those of the
+ * pushes, which the SDK paced injector queues: they show the pacing of the
+ * frames only when the caller paces them (host pacer).
+ */
+class injection_probe {
+ public:
+  injection_probe(std::function<void()>&& on_first_frame,
+                  std::shared_ptr<metrics::injection_metrics> metrics);
+
+  void frame_pushed();
+  void audio_pushed(bool accepted);
+  void video_pushed();
+
+ private:
+  // Each media is pushed from a single thread
+  struct pacing {
+    std::chrono::steady_clock::time_point last_push{};
+    double last_interval{0};
+    double jitter{0};
+  };
+
+  void record_interval(pacing& state, metrics::injection_metrics::media& m);
+
+  std::function<void()> first_frame_cb_;
+  std::shared_ptr<metrics::injection_metrics> metrics_;
+  std::atomic<bool> first_frame_seen_{false};
+  pacing audio_pacing_{};
+  pacing video_pacing_{};
+};
+
+/**
+ * Creates the injector handed to the SDK, observed by an injection_probe.
+ * It is the SDK paced injector, or the unpaced injector passing the frames
+ * on as they come when they are already paced by the caller (host pacer).
+ */
+std::shared_ptr<plugin::injector> make_instrumented_injector(
+    bool paced,
+    plugin::injector::media_injection_status_cb&& status_cb,
+    std::function<void()>&& on_first_frame,
+    std::shared_ptr<metrics::injection_metrics> metrics);
+
+}  // namespace dolbyio::comms::sample
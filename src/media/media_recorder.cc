@@ -0,0 +1,258 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/media_recorder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Stream and track IDs end up in the file names.
+std::string file_safe(std::string id) {
+  std::replace_if(
+      id.begin(), id.end(),
+      [](unsigned char c) { return !std::isalnum(c) && c != '-'; }, '_');
+  return id;
+}
+
+void put_le(uint8_t* out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i)
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+std::vector<uint8_t> ivf_header(int width, int height) {
+  std::vector<uint8_t> header(32, 0);
+  std::copy_n("DKIF", 4, header.begin());
+  put_le(&header[6], 32, 2);  // Header size
+  std::copy_n("VP80", 4, header.begin() + 8);
+  put_le(&header[12], width, 2);
+  put_le(&header[14], height, 2);
+  put_le(&header[16], 1000, 4);  // Time base of 1ms
+  put_le(&header[20], 1, 4);
+  return header;
+}
+
+}  // namespace
+
+media_recorder::media_recorder(const std::string& output_dir,
+                               const std::string& bot_name,
+                               video_config video,
+                               audio_config audio,
+                               container encoded_container,
+                               const mixdown_config& mixdown,
+                               batched_writer::rotation rotation)
+    : output_dir_(bot_name.empty() ? output_dir
+                                   : output_dir + "/" + file_safe(bot_name)),
+      video_(video),
+      audio_(audio),
+      container_(encoded_container),
+      separate_audio_(mixdown.mix != mixdown_config::mode::only),
+      rotation_(rotation) {
+  std::error_code ec;
+  std::filesystem::create_directories(output_dir_, ec);
+  if (ec)
+    std::cerr << "Failed to create " << output_dir_ << ": " << ec.message()
+              << std::endl;
+  if (audio_ == audio_config::AAC)
+    std::cerr << "Recording AAC is not supported, recording the audio as PCM"
+              << std::endl;
+  if (audio_ != audio_config::NONE &&
+      mixdown.mix != mixdown_config::mode::off)
+    mixdown_ = std::make_unique<audio_mixdown>(
+        get_file("audio_mix_" + std::to_string(audio_mixdown::sample_rate) +
+                     "hz_" + std::to_string(audio_mixdown::channels) + "ch",
+                 "pcm", rotation_),
+        mixdown.gain_db, mixdown.gains_db);
+}
+
+media_recorder::~media_recorder() {
+  close();
+}
+
+void media_recorder::close() {
+  if (mixdown_)
+    mixdown_->flush();
+  std::lock_guard<std::mutex> lock(lock_);
+  // The trailers of the remuxed tracks go before the end of their files
+  for (auto& [id, track] : tracks_)
+    if (track.remuxer)
+      track.remuxer->finish();
+  for (auto& [name, file] : files_)
+    file->close();
+  files_.clear();
+  tracks_.clear();
+}
+
+std::shared_ptr<batched_writer::file> media_recorder::get_file(
+    const std::string& name,
+    const char* extension,
+    const batched_writer::rotation& rotation) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto& file = files_[name + "." + extension];
+  if (!file)
+    file = batched_writer::instance().open(output_dir_ + "/" + name,
+                                           extension, rotation);
+  return file;
+}
+
+void media_recorder::handle_audio(const std::string& stream_id,
+                                  const int16_t* data,
+                                  size_t n_data,
+                                  int sample_rate,
+                                  size_t channels) {
+  if (mixdown_)
+    mixdown_->add(stream_id, data, n_data, sample_rate, channels);
+  if (!separate_audio_)
+    return;
+  auto file = get_file("audio_" + file_safe(stream_id) + "_" +
+                           std::to_string(sample_rate) + "hz_" +
+                           std::to_string(channels) + "ch",
+                       "pcm", rotation_);
+  const size_t size = n_data * channels * sizeof(int16_t);
+  if (file->begin_record(size))
+    file->append(data, size);
+}
+
+void media_recorder::handle_frame(const std::string& stream_id,
+                                  const std::string& track_id,
+                                  std::unique_ptr<video_frame> frame) {
+  auto* i420 = frame ? frame->get_i420_frame() : nullptr;
+  if (!i420)
+    return;
+  const int width = frame->width();
+  const int height = frame->height();
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  auto file = get_file("video_" + file_safe(stream_id) + "_" +
+                           file_safe(track_id) + "_" + std::to_string(width) +
+                           "x" + std::to_string(height),
+                       "yuv", rotation_);
+  const size_t size = static_cast<size_t>(width) * height +
+                      2 * static_cast<size_t>(chroma_width) * chroma_height;
+  if (!file->begin_record(size))
+    return;
+  // Tightly packed rows, whatever the strides of the decoded picture
+  for (int row = 0; row < height; ++row)
+    file->append(i420->get_y() + row * i420->stride_y(), width);
+  for (int row = 0; row < chroma_height; ++row)
+    file->append(i420->get_u() + row * i420->stride_u(), chroma_width);
+  for (int row = 0; row < chroma_height; ++row)
+    file->append(i420->get_v() + row * i420->stride_v(), chroma_width);
+}
+
+void media_recorder::handle_frame_encoded(
+    const std::string& track_id,
+    std::unique_ptr<encoded_video_frame> frame) {
+  if (!frame)
+    return;
+  std::shared_ptr<batched_writer::file> file;
+  std::shared_ptr<encoded_remuxer> remuxer;
+  bool ivf = false;
+  std::chrono::steady_clock::time_point start;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = tracks_.find(track_id);
+    if (it == tracks_.end())
+      return;  // Not configured
+    auto& track = it->second;
+    // The IVF header of the segments follows the resolution of the stream
+    if (track.ivf && frame->is_keyframe() &&
+        (frame->width() != track.width || frame->height() != track.height)) {
+      track.width = frame->width();
+      track.height = frame->height();
+      track.file->set_header(ivf_header(track.width, track.height));
+    }
+    file = track.file;
+    remuxer = track.remuxer;
+    ivf = track.ivf;
+    start = track.start;
+  }
+
+  if (remuxer) {
+    remuxer->add_frame(*frame,
+                       std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count());
+    return;
+  }
+
+  const size_t size = frame->size() + (ivf ? 12 : 0);
+  if (!file->begin_record(size, frame->is_keyframe()))
+    return;
+  if (ivf) {
+    uint8_t header[12];
+    put_le(header, frame->size(), 4);
+    put_le(header + 4,
+           std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start)
+               .count(),
+           8);
+    file->append(header, sizeof(header));
+  }
+  file->append(frame->data(), frame->size());
+}
+
+media_recorder::decoder_config media_recorder::output_decoder_config() {
+  return video_ == video_config::ENCODED ? decoder_config::full_decoding
+                                         : decoder_config::optimized_decoding;
+}
+
+bool media_recorder::configure_encoded_sink(const std::string& codec,
+                                            const std::string& track_id) {
+  std::string lower = codec;
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  const bool vp8 = lower == "vp8";
+  if (!vp8 && lower != "h264") {
+    std::cerr << "Cannot record video encoded in " << codec << std::endl;
+    return false;
+  }
+  const std::string name = "video_" + file_safe(track_id);
+  encoded_track track{nullptr, nullptr, false, 0, 0,
+                      std::chrono::steady_clock::now()};
+
+  auto format = container_;
+  if (format == container::mp4 && vp8) {
+    std::cerr << "VP8 cannot be stored in MP4, remuxing track " << track_id
+              << " into Matroska" << std::endl;
+    format = container::matroska;
+  }
+  if (format != container::raw) {
+    // A single index per track, covering all of its segments
+    batched_writer::rotation no_rotation{UINT64_MAX, std::chrono::hours{8760}};
+    track.file = get_file(name, format == container::mp4 ? "mp4" : "mkv",
+                          rotation_);
+    track.remuxer = std::make_shared<encoded_remuxer>(
+        track.file, get_file(name, "idx", no_rotation),
+        format == container::mp4 ? encoded_remuxer::container::mp4
+                                 : encoded_remuxer::container::matroska,
+        vp8 ? AV_CODEC_ID_VP8 : AV_CODEC_ID_H264);
+  } else {
+    track.file = get_file(name, vp8 ? "ivf" : "h264", rotation_);
+    track.ivf = vp8;
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  // A track configured again continues in a new segment
+  auto it = tracks_.find(track_id);
+  if (it != tracks_.end()) {
+    if (it->second.remuxer)
+      it->second.remuxer->finish();
+    it->second.file->close();
+  }
+  tracks_[track_id] = std::move(track);
+  return true;
+}
+
+}  // namespace dolbyio::comms::sample
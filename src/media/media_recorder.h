@@ -0,0 +1,125 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "linux/batched_writer.h"
+#include "media/audio_mixdown.h"
+#include "media/encoded_remuxer.h"
+
+#include <dolbyio/comms/media_engine/media_engine.h>
+#include <dolbyio/comms/multimedia_streaming/recorder.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Records the media received by the bot into a directory of its own, named
+ * after the bot in the output directory, one file per remote stream, written
+ * by the batched_writer off the media threads:
+ *
+ *   audio_<stream>_<rate>hz_<channels>ch.NNNN.pcm  interleaved 16 bit PCM
+ *   audio_mix_48000hz_2ch.NNNN.pcm                 mixdown of all streams
+ *   video_<stream>_<track>_<w>x<h>.NNNN.yuv        I420 frames
+ *   video_<track>.NNNN.mkv|mp4                     encoded video, remuxed
+ *   video_<track>.NNNN.idx                         index of the remuxed video
+ *   video_<track>.NNNN.ivf                         raw encoded VP8 in IVF
+ *   video_<track>.NNNN.h264                        raw encoded H264, Annex B
+ *
+ * The encoded video is remuxed into one Matroska or fragmented MP4 file per
+ * track, or stored raw. Its segments start on a key frame. AAC is not
+ * supported, the audio is recorded as PCM instead.
+ */
+class media_recorder : public dolbyio::comms::audio_sink,
+                       public dolbyio::comms::video_sink,
+                       public dolbyio::comms::video_sink_encoded {
+ public:
+  using video_config = plugin::recorder::video_recording_config;
+  using audio_config = plugin::recorder::audio_recording_config;
+  enum class container { raw, matroska, mp4 };
+  struct mixdown_config {
+    enum class mode { off, alongside, only };
+    mode mix{mode::off};
+    int gain_db{0};
+    // Gains of the streams with their own
+    std::map<std::string, int> gains_db{};
+  };
+
+  media_recorder(const std::string& output_dir,
+                 const std::string& bot_name,
+                 video_config video,
+                 audio_config audio,
+                 container encoded_container,
+                 const mixdown_config& mixdown,
+                 batched_writer::rotation rotation);
+  ~media_recorder() override;
+
+  bool records_audio() const { return audio_ != audio_config::NONE; }
+  bool records_yuv() const { return video_ == video_config::YUV; }
+  bool records_encoded() const {
+    return video_ == video_config::ENCODED ||
+           video_ == video_config::ENCODED_OPTIMIZED;
+  }
+
+  // Writes what is left of the recordings, once the sinks are detached.
+  void close();
+
+  // audio_sink interface
+  void handle_audio(const std::string& stream_id,
+                    const int16_t* data,
+                    size_t n_data,
+                    int sample_rate,
+                    size_t channels) override;
+
+  // video_sink interface
+  void handle_frame(const std::string& stream_id,
+                    const std::string& track_id,
+                    std::unique_ptr<video_frame> frame) override;
+
+  // video_sink_encoded interface
+  void handle_frame_encoded(
+      const std::string& track_id,
+      std::unique_ptr<encoded_video_frame> frame) override;
+  decoder_config output_decoder_config() override;
+  bool configure_encoded_sink(const std::string& codec,
+                              const std::string& track_id) override;
+
+ private:
+  struct encoded_track {
+    std::shared_ptr<batched_writer::file> file;
+    std::shared_ptr<encoded_remuxer> remuxer;
+    bool ivf;
+    int width;
+    int height;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  std::shared_ptr<batched_writer::file> get_file(
+      const std::string& name,
+      const char* extension,
+      const batched_writer::rotation& rotation);
+
+  const std::string output_dir_;
+  const video_config video_;
+  const audio_config audio_;
+  const container container_;
+  const bool separate_audio_;
+  std::unique_ptr<audio_mixdown> mixdown_{};
+  const batched_writer::rotation rotation_;
+
+  std::mutex lock_{};
+  std::map<std::string, std::shared_ptr<batched_writer::file>> files_{};
+  std::map<std::string, encoded_track> tracks_{};
+};
+
+}  // namespace dolbyio::comms::sample
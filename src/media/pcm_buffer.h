@@ -0,0 +1,54 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Fully decoded audio of a media file: interleaved signed 16 bit PCM. The
+ * samples are immutable once decoded, the storage member keeps alive
+ * whatever memory holds them (heap allocation or a memory mapping).
+ */
+struct pcm_buffer {
+  std::string source{};
+  int sample_rate{};
+  int channels{};
+  size_t samples_per_channel{};
+  const int16_t* data{nullptr};
+  std::shared_ptr<const void> storage{};
+
+  size_t size() const { return samples_per_channel * channels; }
+  size_t duration_ms() const {
+    return sample_rate ? samples_per_channel * 1000 / sample_rate : 0;
+  }
+
+  static std::shared_ptr<const pcm_buffer> from_samples(
+      std::string source,
+      std::vector<int16_t>&& samples,
+      int sample_rate,
+      int channels) {
+    auto owned = std::make_shared<std::vector<int16_t>>(std::move(samples));
+    auto buffer = std::make_shared<pcm_buffer>();
+    buffer->source = std::move(source);
+    buffer->sample_rate = sample_rate;
+    buffer->channels = channels;
+    buffer->samples_per_channel = owned->size() / channels;
+    buffer->data = owned->data();
+    buffer->storage = std::move(owned);
+    return buffer;
+  }
+};
+
+}  // namespace dolbyio::comms::sample
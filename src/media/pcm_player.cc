@@ -0,0 +1,360 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/pcm_player.h"
+#include "media/frame_pool.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// If the player thread is stalled for longer than this, it does not try to
+// catch up by bursting the missed frames into the injector.
+constexpr std::chrono::milliseconds max_lag{100};
+
+class pcm_frame : public dolbyio::comms::audio_frame, public pooled_frame {
+ public:
+  // Frame referencing the decoded buffer, no copy
+  pcm_frame(std::shared_ptr<const pcm_buffer> buffer,
+            const int16_t* data,
+            int samples)
+      : buffer_(std::move(buffer)),
+        data_(data),
+        samples_(samples),
+        sample_rate_(buffer_->sample_rate),
+        channels_(buffer_->channels) {}
+
+  // Frame owning its samples, used when crossing buffer boundaries
+  pcm_frame(pooled_samples&& owned, int sample_rate, int channels)
+      : owned_(std::move(owned)),
+        data_(owned_.data()),
+        samples_(static_cast<int>(owned_.size()) / channels),
+        sample_rate_(sample_rate),
+        channels_(channels) {}
+
+  const int16_t* data() const override { return data_; }
+  int sample_rate() const override { return sample_rate_; }
+  int channels() const override { return channels_; }
+  int samples() const override { return samples_; }
+
+ private:
+  std::shared_ptr<const pcm_buffer> buffer_{};
+  pooled_samples owned_{};
+  const int16_t* data_;
+  int samples_;
+  int sample_rate_;
+  int channels_;
+};
+
+size_t samples_per_frame(const pcm_buffer& buffer) {
+  return buffer.sample_rate * pcm_player::frame_duration.count() / 1000;
+}
+
+std::chrono::nanoseconds duration_of(size_t samples, int sample_rate) {
+  return std::chrono::nanoseconds(static_cast<int64_t>(samples) * 1000000000 /
+                                  sample_rate);
+}
+
+}  // namespace
+
+pcm_player::pcm_player(plugin::injector& injector,
+                       bool loop,
+                       finished_cb&& on_finished,
+                       bool external_clock)
+    : injector_(injector), loop_(loop), on_finished_(std::move(on_finished)) {
+  if (!external_clock)
+    thread_ = std::thread([this]() { run(); });
+}
+
+pcm_player::~pcm_player() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    quit_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void pcm_player::play(std::shared_ptr<const pcm_buffer> buffer) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    playlist_.clear();
+    playlist_.push_back(std::move(buffer));
+    current_ = 0;
+    position_ = 0;
+    loops_ = 0;
+    finished_ = false;
+  }
+  cond_.notify_all();
+}
+
+void pcm_player::add_to_playlist(std::shared_ptr<const pcm_buffer> buffer) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    playlist_.push_back(std::move(buffer));
+  }
+  cond_.notify_all();
+}
+
+void pcm_player::set_capture(bool enabled) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    // Starting the capture again after the playlist has finished restarts it
+    if (enabled && finished_) {
+      finished_ = false;
+      current_ = 0;
+      position_ = 0;
+    }
+    capture_ = enabled;
+  }
+  cond_.notify_all();
+}
+
+bool pcm_player::pause() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (paused_ || playlist_.empty())
+    return false;
+  paused_ = true;
+  return true;
+}
+
+bool pcm_player::resume() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!paused_)
+      return false;
+    paused_ = false;
+  }
+  cond_.notify_all();
+  return true;
+}
+
+bool pcm_player::seek(std::chrono::milliseconds position) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (playlist_.empty() || position.count() < 0)
+    return false;
+  const auto& buffer = *playlist_[current_];
+  const size_t target = position.count() * buffer.sample_rate / 1000;
+  if (target >= buffer.samples_per_channel)
+    return false;
+  position_ = target;
+  if (origin_)
+    origin_ = (playing() ? next_tick_ : std::chrono::steady_clock::now()) -
+              media_time();
+  return true;
+}
+
+void pcm_player::set_timeline(std::chrono::steady_clock::time_point origin) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    origin_ = origin;
+    // Takes its place on the new timeline, right away or on the next tick
+    idle_ = true;
+    if (playing())
+      start_pacing(std::chrono::steady_clock::now());
+  }
+  cond_.notify_all();
+}
+
+void pcm_player::tick(std::chrono::steady_clock::time_point now) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!playing()) {
+    idle_ = true;
+    return;
+  }
+  if (idle_) {
+    start_pacing(now);
+    idle_ = false;
+  }
+  check_lag(now);
+  while (playing() && next_tick_ <= now) {
+    inject_next(lock);
+    next_tick_ += frame_duration;
+    keep_on_timeline();
+  }
+}
+
+void pcm_player::run() {
+  trace::set_thread_name("pcm_player");
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!quit_) {
+    if (!playing()) {
+      cond_.wait(lock, [this]() { return quit_ || playing(); });
+      start_pacing(std::chrono::steady_clock::now());
+      continue;
+    }
+    // The first frame on a timeline may be due later
+    if (std::chrono::steady_clock::now() < next_tick_) {
+      cond_.wait_until(lock, next_tick_, [this]() { return quit_; });
+      continue;
+    }
+
+    inject_next(lock);
+    next_tick_ += frame_duration;
+    keep_on_timeline();
+    check_lag(std::chrono::steady_clock::now());
+  }
+}
+
+bool pcm_player::playing() const {
+  return capture_ && !paused_ && !finished_ && !playlist_.empty();
+}
+
+void pcm_player::inject_next(std::unique_lock<std::mutex>& lock) {
+  auto frame = next_frame();
+  const bool ended = finished_;
+  lock.unlock();
+  injector_.inject_audio_frame(std::move(frame));
+  if (ended && on_finished_)
+    on_finished_();
+  lock.lock();
+}
+
+void pcm_player::check_lag(std::chrono::steady_clock::time_point now) {
+  const auto late = now - next_tick_;
+  if (late > frame_duration)
+    trace::instant("pacing", "audio stall",
+                   "\"late_us\": " + std::to_string(trace::to_us(late)));
+  if (late <= max_lag)
+    return;
+  // On a timeline the missed frames are skipped rather than delaying the
+  // rest of the media
+  if (origin_)
+    start_pacing(now);
+  else
+    next_tick_ = now;
+}
+
+void pcm_player::start_pacing(std::chrono::steady_clock::time_point now) {
+  if (!origin_) {
+    next_tick_ = now;
+    return;
+  }
+  // The first frame due from now on, and its samples
+  int64_t frames = 0;
+  if (now > *origin_)
+    frames = (now - *origin_ + frame_duration -
+              std::chrono::steady_clock::duration(1)) /
+             frame_duration;
+  next_tick_ = *origin_ + frames * frame_duration;
+  locate(next_tick_ - *origin_);
+}
+
+void pcm_player::keep_on_timeline() {
+  if (!origin_ || !playing())
+    return;
+  // The media injected drifts from the timeline by the frames padded with
+  // silence, or when the playlist changes
+  const auto drift = *origin_ + media_time() - next_tick_;
+  if (drift < frame_duration && drift > -frame_duration)
+    return;
+  trace::instant("pacing", "audio drift",
+                 "\"drift_us\": " + std::to_string(trace::to_us(drift)));
+  locate(next_tick_ - *origin_);
+}
+
+std::chrono::nanoseconds pcm_player::media_time() const {
+  auto offset = static_cast<int64_t>(loops_) * playlist_duration();
+  for (size_t i = 0; i < current_; ++i)
+    offset += duration_of(playlist_[i]->samples_per_channel,
+                          playlist_[i]->sample_rate);
+  return offset + duration_of(position_, playlist_[current_]->sample_rate);
+}
+
+std::chrono::nanoseconds pcm_player::playlist_duration() const {
+  std::chrono::nanoseconds duration{0};
+  for (const auto& buffer : playlist_)
+    duration += duration_of(buffer->samples_per_channel, buffer->sample_rate);
+  return duration;
+}
+
+void pcm_player::locate(std::chrono::nanoseconds offset) {
+  const auto duration = playlist_duration();
+  loops_ = 0;
+  if (duration.count() <= 0)
+    return;
+  if (offset >= duration) {
+    if (!loop_) {
+      // Past its end, the next frame ends the playlist
+      current_ = playlist_.size() - 1;
+      position_ = playlist_[current_]->samples_per_channel;
+      return;
+    }
+    loops_ = offset / duration;
+    offset %= duration;
+  }
+  for (current_ = 0; current_ + 1 < playlist_.size(); ++current_) {
+    const auto& buffer = *playlist_[current_];
+    const auto length =
+        duration_of(buffer.samples_per_channel, buffer.sample_rate);
+    if (offset < length)
+      break;
+    offset -= length;
+  }
+  const auto& buffer = *playlist_[current_];
+  position_ = std::min<size_t>(offset.count() * buffer.sample_rate / 1000000000,
+                               buffer.samples_per_channel);
+}
+
+std::unique_ptr<dolbyio::comms::audio_frame> pcm_player::next_frame() {
+  auto buffer = playlist_[current_];
+  const size_t frame_len = samples_per_frame(*buffer);
+  const size_t remaining = buffer->samples_per_channel - position_;
+
+  if (remaining >= frame_len) {
+    auto frame = std::make_unique<pcm_frame>(
+        buffer, buffer->data + position_ * buffer->channels,
+        static_cast<int>(frame_len));
+    position_ += frame_len;
+    if (position_ == buffer->samples_per_channel)
+      advance();
+    return frame;
+  }
+
+  // The frame crosses the end of the buffer: take the tail of this buffer and
+  // the head of the next one (itself when looping a single file). Silence
+  // pads the frame if the next buffer has a different format or the playlist
+  // has ended.
+  pooled_samples samples(frame_len * buffer->channels);
+  std::copy_n(buffer->data + position_ * buffer->channels,
+              remaining * buffer->channels, samples.data());
+  advance();
+  if (!finished_) {
+    const auto& next = *playlist_[current_];
+    if (next.sample_rate == buffer->sample_rate &&
+        next.channels == buffer->channels) {
+      const size_t head =
+          std::min(frame_len - remaining, next.samples_per_channel);
+      std::copy_n(next.data, head * next.channels,
+                  samples.data() + remaining * buffer->channels);
+      position_ = head;
+      if (position_ == next.samples_per_channel)
+        advance();
+    }
+  }
+  return std::make_unique<pcm_frame>(std::move(samples), buffer->sample_rate,
+                                     buffer->channels);
+}
+
+void pcm_player::advance() {
+  position_ = 0;
+  if (++current_ < playlist_.size())
+    return;
+  current_ = 0;
+  if (loop_)
+    ++loops_;
+  else
+    finished_ = true;
+}
+
+}  // namespace dolbyio::comms::sample
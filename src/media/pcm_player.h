@@ -0,0 +1,103 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/pcm_buffer.h"
+
+#include <dolbyio/comms/multimedia_streaming/injector.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Plays a playlist of already decoded PCM buffers into the injector in real
+ * time, 10ms audio frame at a time. The frames reference the decoded buffer
+ * directly, only the frame which crosses the end of a buffer is copied, so
+ * looping involves no decoding and no gap at the loop boundary.
+ *
+ * The frames are paced by the thread of the player, or with an external
+ * clock by the caller of tick(), which lets a single host thread pace the
+ * players of all of the bots.
+ *
+ * On a timeline, the playlist is played from the origin of the timeline on
+ * and never drifts from it: the player takes its place on the timeline when
+ * it starts playing and after a stall, and after every frame it compares
+ * the timestamp of the media it injects with the clock. Players sharing an
+ * origin are aligned to the sample, whatever their pauses and loops.
+ */
+class pcm_player {
+ public:
+  using finished_cb = std::function<void()>;
+  static constexpr std::chrono::milliseconds frame_duration{10};
+
+  pcm_player(plugin::injector& injector,
+             bool loop,
+             finished_cb&& on_finished,
+             bool external_clock = false);
+  ~pcm_player();
+
+  // With an external clock, injects the frames due at the given time.
+  void tick(std::chrono::steady_clock::time_point now);
+
+  void play(std::shared_ptr<const pcm_buffer> buffer);
+  void add_to_playlist(std::shared_ptr<const pcm_buffer> buffer);
+
+  void set_capture(bool enabled);
+  bool pause();
+  bool resume();
+  // On a timeline, the origin moves for the player to continue from there.
+  bool seek(std::chrono::milliseconds position);
+  // Plays the sample at offset t of the playlist, looped, at origin + t.
+  void set_timeline(std::chrono::steady_clock::time_point origin);
+
+ private:
+  void run();
+  bool playing() const;
+  void inject_next(std::unique_lock<std::mutex>& lock);
+  void check_lag(std::chrono::steady_clock::time_point now);
+  // Due time of the next frame, and its place on the timeline if any.
+  void start_pacing(std::chrono::steady_clock::time_point now);
+  void keep_on_timeline();
+  // Offset of the next sample, on the timeline.
+  std::chrono::nanoseconds media_time() const;
+  std::chrono::nanoseconds playlist_duration() const;
+  void locate(std::chrono::nanoseconds offset);
+  std::unique_ptr<dolbyio::comms::audio_frame> next_frame();
+  void advance();
+
+  plugin::injector& injector_;
+  const bool loop_;
+  finished_cb on_finished_;
+
+  std::mutex lock_{};
+  std::condition_variable cond_{};
+  std::vector<std::shared_ptr<const pcm_buffer>> playlist_{};
+  size_t current_{0};
+  size_t position_{0};  // In samples per channel
+  size_t loops_{0};     // Of the whole playlist
+  bool capture_{false};
+  bool paused_{false};
+  bool finished_{false};
+  bool quit_{false};
+  bool idle_{true};
+  std::chrono::steady_clock::time_point next_tick_{};
+  std::optional<std::chrono::steady_clock::time_point> origin_{};
+  std::thread thread_{};
+};
+
+}  // namespace dolbyio::comms::sample
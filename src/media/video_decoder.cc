@@ -0,0 +1,50 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/video_decoder.h"
+#include "media/ffmpeg_decoder.h"
+
+#include <stdexcept>
+
+namespace dolbyio::comms::sample {
+
+void decode_video_file(const std::string& path,
+                       const std::function<void(const i420_picture&)>& cb) {
+  ffmpeg_decoder decoder{path, AVMEDIA_TYPE_VIDEO};
+  const AVRational time_base = decoder.time_base();
+  const AVRational microseconds = {1, 1000000};
+  int64_t next_timestamp_us = 0;
+
+  decoder.decode_all([&](const AVFrame* frame) {
+    if (frame->format != AV_PIX_FMT_YUV420P &&
+        frame->format != AV_PIX_FMT_YUVJ420P)
+      throw std::runtime_error("Unsupported pixel format in " + path +
+                               ", only 4:2:0 planar video is supported");
+
+    i420_picture picture;
+    picture.width = frame->width;
+    picture.height = frame->height;
+    // Frames without timestamp are placed right after the previous one
+    picture.timestamp_us =
+        frame->best_effort_timestamp != AV_NOPTS_VALUE
+            ? av_rescale_q(frame->best_effort_timestamp, time_base,
+                           microseconds)
+            : next_timestamp_us;
+    picture.y = frame->data[0];
+    picture.u = frame->data[1];
+    picture.v = frame->data[2];
+    picture.stride_y = frame->linesize[0];
+    picture.stride_u = frame->linesize[1];
+    picture.stride_v = frame->linesize[2];
+    next_timestamp_us = picture.timestamp_us + 1;
+    cb(picture);
+  });
+}
+
+}  // namespace dolbyio::comms::sample
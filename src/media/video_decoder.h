@@ -0,0 +1,46 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+// A decoded picture in planar I420 layout, valid only during the callback.
+struct i420_picture {
+  int width{};
+  int height{};
+  int64_t timestamp_us{};
+  const uint8_t* y{nullptr};
+  const uint8_t* u{nullptr};
+  const uint8_t* v{nullptr};
+  int stride_y{};
+  int stride_u{};
+  int stride_v{};
+};
+
+// Size in bytes of a tightly packed I420 picture.
+inline size_t i420_size(int width, int height) {
+  const size_t chroma =
+      static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+  return static_cast<size_t>(width) * height + 2 * chroma;
+}
+
+/**
+ * Decode every picture of the best video stream of the file. Only decoders
+ * producing 4:2:0 planar output are supported, as no scaler is available;
+ * std::runtime_error is thrown otherwise.
+ */
+void decode_video_file(const std::string& path,
+                       const std::function<void(const i420_picture&)>& cb);
+
+}  // namespace dolbyio::comms::sample
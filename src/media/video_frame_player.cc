@@ -0,0 +1,222 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/video_frame_player.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Same catch up limit as for the audio, a stalled player skips ahead instead
+// of bursting the late frames.
+constexpr std::chrono::milliseconds max_lag{100};
+
+// I420 frame pointing into the mapping of the prepared asset.
+class mapped_frame : public dolbyio::comms::video_frame,
+                     public dolbyio::comms::video_frame_i420 {
+ public:
+  mapped_frame(const inj_file& asset, size_t idx, int64_t timestamp_us)
+      : width_(asset.width()),
+        height_(asset.height()),
+        timestamp_us_(timestamp_us),
+        y_(asset.frame(idx)),
+        u_(y_ + static_cast<size_t>(width_) * height_),
+        v_(u_ + static_cast<size_t>((width_ + 1) / 2) * ((height_ + 1) / 2)) {}
+
+  // video_frame interface
+  int width() const override { return width_; }
+  int height() const override { return height_; }
+  int64_t timestamp_us() const override { return timestamp_us_; }
+  dolbyio::comms::video_frame_i420* get_i420_frame() override { return this; }
+
+  // video_frame_i420 interface
+  const uint8_t* get_y() const override { return y_; }
+  const uint8_t* get_u() const override { return u_; }
+  const uint8_t* get_v() const override { return v_; }
+  int stride_y() const override { return width_; }
+  int stride_u() const override { return (width_ + 1) / 2; }
+  int stride_v() const override { return (width_ + 1) / 2; }
+
+ private:
+  int width_;
+  int height_;
+  int64_t timestamp_us_;
+  const uint8_t* y_;
+  const uint8_t* u_;
+  const uint8_t* v_;
+};
+
+}  // namespace
+
+video_frame_player::video_frame_player(plugin::injector& injector,
+                                       bool loop,
+                                       bool external_clock)
+    : injector_(injector), loop_(loop) {
+  if (!external_clock)
+    thread_ = std::thread([this]() { run(); });
+}
+
+video_frame_player::~video_frame_player() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    quit_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void video_frame_player::play(std::shared_ptr<const inj_file> asset) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    playlist_.clear();
+    playlist_.push_back(std::move(asset));
+    current_ = 0;
+    frame_ = 0;
+    finished_ = false;
+  }
+  cond_.notify_all();
+}
+
+void video_frame_player::add_to_playlist(
+    std::shared_ptr<const inj_file> asset) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    playlist_.push_back(std::move(asset));
+  }
+  cond_.notify_all();
+}
+
+void video_frame_player::set_capture(bool enabled) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (enabled && finished_) {
+      finished_ = false;
+      current_ = 0;
+      frame_ = 0;
+    }
+    capture_ = enabled;
+  }
+  cond_.notify_all();
+}
+
+bool video_frame_player::pause() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (paused_ || playlist_.empty())
+    return false;
+  paused_ = true;
+  return true;
+}
+
+bool video_frame_player::resume() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!paused_)
+      return false;
+    paused_ = false;
+  }
+  cond_.notify_all();
+  return true;
+}
+
+bool video_frame_player::seek(std::chrono::milliseconds position) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (playlist_.empty() || position.count() < 0)
+    return false;
+  const auto& asset = *playlist_[current_];
+  const int64_t target = asset.frame_timestamp_us(0) + position.count() * 1000;
+  for (size_t i = 0; i < asset.frame_count(); ++i) {
+    if (asset.frame_timestamp_us(i) >= target) {
+      frame_ = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void video_frame_player::tick(std::chrono::steady_clock::time_point now) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!playing()) {
+    idle_ = true;
+    return;
+  }
+  if (idle_) {
+    next_tick_ = now;
+    idle_ = false;
+  }
+  check_lag(now);
+  while (playing() && next_tick_ <= now)
+    inject_next(lock);
+}
+
+void video_frame_player::run() {
+  trace::set_thread_name("video_frame_player");
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!quit_) {
+    if (!playing()) {
+      cond_.wait(lock, [this]() { return quit_ || playing(); });
+      next_tick_ = std::chrono::steady_clock::now();
+      continue;
+    }
+
+    inject_next(lock);
+    check_lag(std::chrono::steady_clock::now());
+    cond_.wait_until(lock, next_tick_, [this]() { return quit_; });
+  }
+}
+
+bool video_frame_player::playing() const {
+  return capture_ && !paused_ && !finished_ && !playlist_.empty();
+}
+
+void video_frame_player::inject_next(std::unique_lock<std::mutex>& lock) {
+  // Hold a reference to the asset, the playlist may change while injecting
+  auto asset = playlist_[current_];
+  const auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch());
+  mapped_frame frame{*asset, frame_, timestamp.count()};
+  frame_duration_ = advance();
+  next_tick_ += frame_duration_;
+  lock.unlock();
+  injector_.inject_video_frame(frame);
+  lock.lock();
+}
+
+void video_frame_player::check_lag(std::chrono::steady_clock::time_point now) {
+  const auto late = now - next_tick_;
+  if (late > frame_duration_)
+    trace::instant("pacing", "video stall",
+                   "\"late_us\": " + std::to_string(trace::to_us(late)));
+  if (late > max_lag)
+    next_tick_ = now;
+}
+
+std::chrono::microseconds video_frame_player::advance() {
+  const auto& asset = *playlist_[current_];
+  const int64_t now_us = asset.frame_timestamp_us(frame_);
+  int64_t next_us = 0;
+  if (++frame_ < asset.frame_count()) {
+    next_us = asset.frame_timestamp_us(frame_);
+  } else {
+    // The last frame lasts until the end of the video
+    next_us = asset.frame_timestamp_us(0) + asset.video_duration_us();
+    frame_ = 0;
+    if (++current_ >= playlist_.size()) {
+      current_ = 0;
+      if (!loop_)
+        finished_ = true;
+    }
+  }
+  return std::chrono::microseconds(std::max<int64_t>(next_us - now_us, 0));
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,76 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "media/inj_file.h"
+
+#include <dolbyio/comms/multimedia_streaming/injector.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Plays the video frames of prepared assets into the injector, following the
+ * timestamps stored in the asset index. The frames are handed to the
+ * injector straight from the file mapping, no decoding nor conversion takes
+ * place. As for the pcm_player, the frames are paced by the thread of the
+ * player or by the caller of tick(), on a tick of its own.
+ */
+class video_frame_player {
+ public:
+  video_frame_player(plugin::injector& injector,
+                     bool loop,
+                     bool external_clock = false);
+  ~video_frame_player();
+
+  // With an external clock, injects the frames due at the given time. The
+  // frame times are rounded up to the ticks.
+  void tick(std::chrono::steady_clock::time_point now);
+
+  void play(std::shared_ptr<const inj_file> asset);
+  void add_to_playlist(std::shared_ptr<const inj_file> asset);
+
+  void set_capture(bool enabled);
+  bool pause();
+  bool resume();
+  bool seek(std::chrono::milliseconds position);
+
+ private:
+  void run();
+  bool playing() const;
+  void inject_next(std::unique_lock<std::mutex>& lock);
+  void check_lag(std::chrono::steady_clock::time_point now);
+  std::chrono::microseconds advance();
+
+  plugin::injector& injector_;
+  const bool loop_;
+
+  std::mutex lock_{};
+  std::condition_variable cond_{};
+  std::vector<std::shared_ptr<const inj_file>> playlist_{};
+  size_t current_{0};
+  size_t frame_{0};
+  bool capture_{false};
+  bool paused_{false};
+  bool finished_{false};
+  bool quit_{false};
+  bool idle_{true};
+  std::chrono::steady_clock::time_point next_tick_{};
+  std::chrono::microseconds frame_duration_{};
+  std::thread thread_{};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,196 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022 - 2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+// Native replacement of the demo.py process fan-out: reads the injection
+// input and the conversation definitions, launches the injection processes
+// with bounded parallelism and supervises them until stopped (SIGINT or
+// SIGTERM), restarting the processes which crash.
+
+#include "linux/process_supervisor.h"
+#include "linux/start_barrier.h"
+#include "utils/commands_handler.h"
+#include "utils/injection_input.h"
+#include "wrappers/command_line_params.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+#include <pwd.h>
+#include <unistd.h>
+
+using namespace dolbyio::comms::sample;
+
+namespace {
+
+struct orchestrator_params {
+  std::string input_file{"injection-input.json"};
+  std::string conversations_root{"conversations"};
+  std::string binary{};
+  std::string log_root{};
+  bool host{false};
+  process_supervisor::config supervisor{};
+  std::vector<std::string> extra_args{};  // Passed to every process
+};
+
+std::string default_binary() {
+  std::error_code ec;
+  auto self = std::filesystem::read_symlink("/proc/self/exe", ec);
+  if (ec)
+    return "src/cpp_injection_demo";
+  return (self.parent_path() / "cpp_injection_demo").string();
+}
+
+// Same log directory layout as demo.py
+std::string default_log_root() {
+  const passwd* pw = getpwuid(getuid());
+  const std::string user = pw ? pw->pw_name : "unknown";
+  return "/tmp/" + user + "/cpp-injection";
+}
+
+// The processes of a conversation start their bots together, at the start
+// barrier of the conversation named in start_barriers.
+std::vector<process_spec> collect_processes(
+    const orchestrator_params& params,
+    std::vector<std::string>& start_barriers) {
+  const auto input = injection_input::load(params.input_file);
+  const auto common = input.common_args();
+
+  std::vector<process_spec> processes;
+  for (const auto& conv :
+       input.select_conversations(params.conversations_root)) {
+    const auto conv_log_dir = params.log_root + "/" + conv.name;
+    const size_t first = processes.size();
+    if (params.host) {
+      process_spec spec{conv.name, {params.binary}, conv_log_dir};
+      spec.argv.insert(spec.argv.end(), {"--conversation", conv.folder});
+      processes.push_back(std::move(spec));
+    } else {
+      for (const auto& bot : conv.bots) {
+        process_spec spec{conv.name + "/" + bot.name,
+                          {params.binary},
+                          conv_log_dir + "/" + bot.name};
+        const auto args = bot.command_line_args(conv.folder);
+        spec.argv.insert(spec.argv.end(), args.begin(), args.end());
+        processes.push_back(std::move(spec));
+      }
+    }
+    // Unique to this run, the barrier outlives the processes
+    const auto barrier = conv.name + "-" + std::to_string(getpid());
+    const auto sync = barrier + ":" + std::to_string(processes.size() - first);
+    for (size_t i = first; i < processes.size(); ++i)
+      processes[i].argv.insert(processes[i].argv.end(), {"-sync-start", sync});
+    start_barriers.push_back(barrier);
+  }
+
+  for (auto& spec : processes) {
+    spec.argv.insert(spec.argv.end(), common.begin(), common.end());
+    spec.argv.insert(spec.argv.end(), {"-ld", spec.log_dir, "-foreground",
+                                       "-metrics-socket",
+                                       spec.log_dir + "/metrics.sock"});
+    spec.argv.insert(spec.argv.end(), params.extra_args.begin(),
+                     params.extra_args.end());
+  }
+  return processes;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  orchestrator_params params{};
+  params.binary = default_binary();
+  params.log_root = default_log_root();
+
+  commands_handler handler{};
+  handler.add_command_line_switch(
+      {"-i", "--input"},
+      "<file>\n\tInjection input file (default: injection-input.json).",
+      [&params](const std::string& arg) { params.input_file = arg; });
+  handler.add_command_line_switch(
+      {"-conversations", "--conversations"},
+      "<dir>\n\tFolder holding the conversations (default: conversations).",
+      [&params](const std::string& arg) { params.conversations_root = arg; });
+  handler.add_command_line_switch(
+      {"-b", "--binary"},
+      "<path>\n\tInjection binary (default: cpp_injection_demo next to this "
+      "binary).",
+      [&params](const std::string& arg) { params.binary = arg; });
+  handler.add_command_line_switch(
+      {"-ld", "--log_dir"},
+      "<dir>\n\tRoot of the log directories of the processes (default: "
+      "/tmp/<user>/cpp-injection).",
+      [&params](const std::string& arg) { params.log_root = arg; });
+  handler.add_command_line_switch(
+      {"-j", "--jobs"},
+      "<count>\n\tNumber of processes starting in parallel, a process is "
+      "starting until it has joined the conference (default: 8).",
+      [&params](const std::string& arg) {
+        params.supervisor.max_parallel_starts =
+            std::max(1, command_line::to_int(arg, "-j"));
+      });
+  handler.add_command_line_switch(
+      {"-start-timeout", "--start-timeout"},
+      "<seconds>\n\tTime a process may take to join before the next one is "
+      "started anyway (default: 60).",
+      [&params](const std::string& arg) {
+        params.supervisor.start_timeout =
+            std::chrono::seconds(command_line::to_int(arg, "-start-timeout"));
+      });
+  handler.add_command_line_switch(
+      {"-max-restarts", "--max-restarts"},
+      "<count>\n\tNumber of times a crashing process is restarted before "
+      "giving up on it (default: 5).",
+      [&params](const std::string& arg) {
+        params.supervisor.max_restarts =
+            command_line::to_int(arg, "-max-restarts");
+      });
+  handler.add_command_line_switch(
+      {"-zygote", "--zygote"},
+      "<socket>\n\tSpawn the processes through the zygote listening on the "
+      "socket (cpp_injection_demo --zygote <socket>) instead of starting "
+      "the binary.",
+      [&params](const std::string& arg) {
+        params.supervisor.zygote_socket = arg;
+      });
+  handler.add_command_line_switch(
+      {"-host", "--host"},
+      "\n\tRun all bots of a conversation inside of a single injection "
+      "process.",
+      [&params]() { params.host = true; });
+
+  try {
+    // Everything following "--" is passed to the injection processes as is
+    std::vector<std::string> args(argv + 1, argv + argc);
+    auto separator = std::find(args.begin(), args.end(), "--");
+    if (separator != args.end()) {
+      params.extra_args.assign(separator + 1, args.end());
+      args.erase(separator, args.end());
+    }
+    handler.parse_command_line(args);
+
+    std::vector<std::string> start_barriers;
+    auto processes = collect_processes(params, start_barriers);
+    if (processes.empty()) {
+      std::cerr << "No conversation to inject" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    process_supervisor supervisor{params.supervisor};
+    for (auto& spec : processes)
+      supervisor.add(std::move(spec));
+    supervisor.run();
+    for (const auto& name : start_barriers)
+      start_barrier::remove(name);
+  } catch (const std::exception& ex) {
+    std::cerr << "Something went wrong: " << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022 - 2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+// Offline preparation of the injected media: decodes the media referenced by
+// the conversation definitions once, ahead of time, into injection-ready
+// .inj files, which the injection bots started with -prepared memory map
+// instead of decoding the media themselves.
+
+#include "media/audio_decoder.h"
+#include "media/ffmpeg_decoder.h"
+#include "media/inj_file.h"
+#include "media/video_decoder.h"
+#include "utils/commands_handler.h"
+#include "utils/conversation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace dolbyio::comms::sample;
+
+namespace {
+
+struct prepare_params {
+  std::vector<std::string> conversations{};
+  std::vector<std::string> files{};
+  unsigned jobs{std::max(1u, std::thread::hardware_concurrency())};
+  bool force{false};
+};
+
+std::mutex log_lock{};
+
+bool up_to_date(const std::string& media) {
+  try {
+    auto asset = inj_file::open(inj::prepared_path(media));
+    return asset && asset->prepared_from(media);
+  } catch (const std::exception&) {
+    return false;  // Corrupted or older version, prepare it again
+  }
+}
+
+void prepare(const std::string& media) {
+  inj_writer writer{inj::prepared_path(media), media};
+  if (ffmpeg_decoder::has_stream(media, AVMEDIA_TYPE_AUDIO))
+    writer.write_audio(*decode_audio_file(media));
+  if (ffmpeg_decoder::has_stream(media, AVMEDIA_TYPE_VIDEO))
+    decode_video_file(media, [&writer](const i420_picture& picture) {
+      writer.add_video_frame(picture);
+    });
+  writer.finish();
+}
+
+// Media files referenced by all of the conversations, without duplicates.
+std::vector<std::string> collect_media(const prepare_params& params) {
+  std::set<std::string> media{params.files.begin(), params.files.end()};
+  for (const auto& root : params.conversations) {
+    std::vector<std::string> definitions;
+    if (std::filesystem::is_directory(root) &&
+        !std::filesystem::exists(std::filesystem::path(root) / "def.json")) {
+      for (const auto& entry : std::filesystem::directory_iterator(root))
+        if (std::filesystem::exists(entry.path() / "def.json"))
+          definitions.push_back(entry.path().string());
+    } else {
+      definitions.push_back(root);
+    }
+    for (const auto& path : definitions) {
+      auto conv = conversation::load(path);
+      for (const auto& bot : conv.bots)
+        media.insert(
+            (std::filesystem::path(conv.folder) / bot.media).string());
+    }
+  }
+  return {media.begin(), media.end()};
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  prepare_params params{};
+  commands_handler handler{};
+  handler.add_command_line_switch(
+      {"-c", "--conversations"},
+      "<path>\n\tConversation folder, def.json file or folder of "
+      "conversations whose media is prepared (default: conversations).",
+      [&params](const std::string& arg) {
+        params.conversations.push_back(arg);
+      });
+  handler.add_command_line_switch(
+      {"-f"}, "<file_name>\n\tAdditional media file to prepare.",
+      [&params](const std::string& arg) { params.files.push_back(arg); });
+  handler.add_command_line_switch(
+      {"-j", "--jobs"},
+      "<count>\n\tNumber of files prepared in parallel (default: number of "
+      "CPUs).",
+      [&params](const std::string& arg) {
+        params.jobs = std::max(1, std::stoi(arg));
+      });
+  handler.add_command_line_switch(
+      {"-force", "--force"},
+      "\n\tPrepare the media again even if the prepared asset is up to date.",
+      [&params]() { params.force = true; });
+
+  std::vector<std::string> media;
+  try {
+    handler.parse_command_line(argc, argv);
+    if (params.conversations.empty() && params.files.empty())
+      params.conversations.push_back("conversations");
+    media = collect_media(params);
+  } catch (const std::exception& ex) {
+    std::cerr << "Something went wrong: " << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> prepared{0};
+  std::atomic<size_t> failed{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < media.size(); i = next++) {
+      const auto& file = media[i];
+      if (!params.force && up_to_date(file))
+        continue;
+      try {
+        const auto start = std::chrono::steady_clock::now();
+        prepare(file);
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+        ++prepared;
+        std::lock_guard<std::mutex> lock(log_lock);
+        std::cerr << "Prepared " << file << " in " << elapsed.count() << "ms"
+                  << std::endl;
+      } catch (const std::exception& ex) {
+        ++failed;
+        std::lock_guard<std::mutex> lock(log_lock);
+        std::cerr << "Failed to prepare " << file << ": " << ex.what()
+                  << std::endl;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const size_t jobs = std::min<size_t>(params.jobs, media.size());
+  for (size_t i = 0; i < jobs; ++i)
+    workers.emplace_back(worker);
+  for (auto& thread : workers)
+    thread.join();
+
+  std::cerr << media.size() << " media files, " << prepared << " prepared, "
+            << media.size() - prepared - failed << " up to date, " << failed
+            << " failed" << std::endl;
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -8,6 +8,7 @@
  ***************************************************************************/
 
 #include "utils/async_accumulator.h"
+#include "utils/trace.h"
 
 namespace dolbyio::comms::sample {
 
@@ -33,18 +34,28 @@ class async_result_accumulator::acc {
   }
   void set_failure(std::exception_ptr&& err) {
     assert(solver_result_pair_.solver_);
-    error_ = std::move(err);
+    // Several operations may fail concurrently, report the first failure
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!error_)
+      error_ = std::move(err);
   }
   void rem_waiter() {
     assert(solver_result_pair_.solver_);
     assert(num_await > 0);
-    --num_await;
-    if (num_await == 0) {
-      if (error_)
-        solver_result_pair_.get_solver().fail(std::move(error_));
-      else
-        solver_result_pair_.get_solver().resolve();
+    // Only the last waiter may observe zero and settle the result
+    if (--num_await != 0)
+      return;
+    std::exception_ptr error;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      error = std::move(error_);
     }
+    trace::instant("async",
+                   error ? "accumulator failed" : "accumulator resolved");
+    if (error)
+      solver_result_pair_.get_solver().fail(std::move(error));
+    else
+      solver_result_pair_.get_solver().resolve();
   }
   async_result<void> get_result() { return solver_result_pair_.get_result(); }
 };
@@ -59,8 +70,12 @@ async_result_accumulator::~async_result_accumulator() = default;
 void async_result_accumulator::add(async_result<void>&& res) {
   acc_->add_waiter();
   std::move(res)
-      .then([acc{acc_}]() mutable { acc->rem_waiter(); })
+      .then([acc{acc_}]() mutable {
+        trace::instant("async", "async_result resolved");
+        acc->rem_waiter();
+      })
       .on_error([acc{acc_}](std::exception_ptr&& err) mutable {
+        trace::instant("async", "async_result failed");
         acc->set_failure(std::move(err));
         acc->rem_waiter();
       });
@@ -16,7 +16,9 @@ namespace dolbyio::comms::sample {
 /**
  * A helper class which allows queueing of operations that can be
  * executed without waiting for one another and then resolves an
- * async_result when all the operations have completed.
+ * async_result when all the operations have completed. It waits for all of
+ * the operations even if one fails, see when_all() in async_combinators.h
+ * for the fail-fast and typed variant.
  */
 class async_result_accumulator {
  public:
@@ -0,0 +1,227 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <dolbyio/comms/async_result.h>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Combinators of async_results which run concurrently, generalizing the
+ * async_result_accumulator to typed results:
+ *
+ *  when_all(a, b, ...)  resolves with the tuple of all of the results, or
+ *                       fails as soon as the first operation fails.
+ *  when_all(vector)     same for any number of operations of the same type.
+ *  when_any(a, b, ...)  resolves with the first successful result, the index
+ *                       of the variant telling which operation it came from.
+ *                       Fails once all of the operations have failed.
+ *
+ * The void results are std::monostate in the tuples and variants, combining
+ * only void results gives an async_result<void>. The operations are not
+ * cancelled once the combined result is settled, their outcome is dropped.
+ * No locks are taken, every operation writes its own slot and the last one
+ * to complete publishes them.
+ */
+
+namespace detail {
+
+template <typename T>
+using value_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template <typename... T>
+using all_result_t = std::conditional_t<(std::is_void_v<T> && ...),
+                                        void,
+                                        std::tuple<value_t<T>...>>;
+
+// Settles the combined result exactly once.
+template <typename R>
+class fan_in {
+ public:
+  explicit fan_in(size_t pending)
+      : pending_(pending), pair_(async_result<R>::make()) {}
+
+  async_result<R> result() { return pair_.get_result(); }
+
+  // True for the last of the pending operations to complete.
+  bool complete_one() {
+    return pending_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  template <typename... V>
+  void resolve(V&&... value) {
+    if (!settled_.exchange(true, std::memory_order_acq_rel))
+      pair_.get_solver().resolve(std::forward<V>(value)...);
+  }
+
+  void fail(std::exception_ptr&& err) {
+    if (!settled_.exchange(true, std::memory_order_acq_rel))
+      pair_.get_solver().fail(std::move(err));
+  }
+
+ private:
+  std::atomic<size_t> pending_;
+  std::atomic<bool> settled_{false};
+  async_result_with_solver<R> pair_;
+};
+
+// Invokes on_value with the result (std::monostate for void) or on_error.
+template <typename T, typename OnValue, typename OnError>
+void subscribe(async_result<T>&& res, OnValue on_value, OnError on_error) {
+  if constexpr (std::is_void_v<T>) {
+    std::move(res)
+        .then([on_value{std::move(on_value)}]() mutable {
+          on_value(std::monostate{});
+        })
+        .on_error(std::move(on_error));
+  } else {
+    std::move(res)
+        .then([on_value{std::move(on_value)}](T&& value) mutable {
+          on_value(std::move(value));
+        })
+        .on_error(std::move(on_error));
+  }
+}
+
+template <typename R, typename... T>
+struct all_state : fan_in<R> {
+  using fan_in<R>::fan_in;
+  std::tuple<std::optional<value_t<T>>...> values{};
+
+  void resolve_all() {
+    if constexpr (std::is_void_v<R>)
+      this->resolve();
+    else
+      this->resolve(std::apply(
+          [](auto&... value) { return R{std::move(*value)...}; }, values));
+  }
+};
+
+template <typename State, size_t... I, typename... T>
+void subscribe_all(const std::shared_ptr<State>& state,
+                   std::index_sequence<I...>,
+                   async_result<T>&&... results) {
+  (subscribe(
+       std::move(results),
+       [state](auto&& value) {
+         std::get<I>(state->values) = std::move(value);
+         if (state->complete_one())
+           state->resolve_all();
+       },
+       [state](std::exception_ptr&& err) { state->fail(std::move(err)); }),
+   ...);
+}
+
+template <typename R>
+struct any_state : fan_in<R> {
+  using fan_in<R>::fan_in;
+  std::atomic<bool> has_error{false};
+  std::exception_ptr first_error{};
+
+  void failed(std::exception_ptr&& err) {
+    if (!has_error.exchange(true, std::memory_order_acq_rel))
+      first_error = std::move(err);
+    // The first error is published by the decrement
+    if (this->complete_one())
+      this->fail(std::move(first_error));
+  }
+};
+
+template <typename State, size_t... I, typename... T>
+void subscribe_any(const std::shared_ptr<State>& state,
+                   std::index_sequence<I...>,
+                   async_result<T>&&... results) {
+  using R = std::variant<value_t<T>...>;
+  (subscribe(
+       std::move(results),
+       [state](auto&& value) {
+         state->resolve(R{std::in_place_index<I>, std::move(value)});
+       },
+       [state](std::exception_ptr&& err) { state->failed(std::move(err)); }),
+   ...);
+}
+
+}  // namespace detail
+
+template <typename... T>
+async_result<detail::all_result_t<T...>> when_all(
+    async_result<T>&&... results) {
+  static_assert(sizeof...(T) > 0, "Nothing to wait for");
+  using R = detail::all_result_t<T...>;
+  auto state = std::make_shared<detail::all_state<R, T...>>(sizeof...(T));
+  auto result = state->result();
+  detail::subscribe_all(state, std::index_sequence_for<T...>{},
+                        std::move(results)...);
+  return result;
+}
+
+template <typename T>
+async_result<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>>
+when_all(std::vector<async_result<T>>&& results) {
+  using R = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+  struct state : detail::fan_in<R> {
+    using detail::fan_in<R>::fan_in;
+    std::vector<std::optional<detail::value_t<T>>> values{};
+  };
+  auto st = std::make_shared<state>(results.size());
+  st->values.resize(results.size());
+  auto result = st->result();
+  if (results.empty()) {
+    if constexpr (std::is_void_v<T>)
+      st->resolve();
+    else
+      st->resolve(R{});
+    return result;
+  }
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    detail::subscribe(
+        std::move(results[i]),
+        [st, i](auto&& value) {
+          st->values[i] = std::move(value);
+          if (!st->complete_one())
+            return;
+          if constexpr (std::is_void_v<T>) {
+            st->resolve();
+          } else {
+            R all;
+            all.reserve(st->values.size());
+            for (auto& v : st->values)
+              all.push_back(std::move(*v));
+            st->resolve(std::move(all));
+          }
+        },
+        [st](std::exception_ptr&& err) { st->fail(std::move(err)); });
+  }
+  return result;
+}
+
+template <typename... T>
+async_result<std::variant<detail::value_t<T>...>> when_any(
+    async_result<T>&&... results) {
+  static_assert(sizeof...(T) > 0, "Nothing to wait for");
+  using R = std::variant<detail::value_t<T>...>;
+  auto state = std::make_shared<detail::any_state<R>>(sizeof...(T));
+  auto result = state->result();
+  detail::subscribe_any(state, std::index_sequence_for<T...>{},
+                        std::move(results)...);
+  return result;
+}
+
+}  // namespace dolbyio::comms::sample
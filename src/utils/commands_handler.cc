@@ -34,6 +34,14 @@ void commands_handler::add_interactor(std::shared_ptr<interactor> obj) {
 void commands_handler::add_interactive_command(const command& command,
                                                const description& description,
                                                action action) {
+  add_interactive_command(
+      command, description,
+      [a = std::move(action)](const command_arg&) { a(); });
+}
+
+void commands_handler::add_interactive_command(const command& command,
+                                               const description& description,
+                                               action_with_arg action) {
   if (enabled_)
     throw std::runtime_error("SDK is already set");
 
@@ -46,6 +54,19 @@ void commands_handler::add_interactive_command(const command& command,
     res->second.push_back(std::make_pair(description, std::move(action)));
 }
 
+void commands_handler::set_argument_prompt(const command& command,
+                                           const std::string& prompt) {
+  argument_prompts_[command] = prompt;
+}
+
+std::optional<std::string> commands_handler::argument_prompt(
+    const command& command) const {
+  auto it = argument_prompts_.find(command);
+  if (it == argument_prompts_.end())
+    return std::nullopt;
+  return it->second;
+}
+
 void commands_handler::add_command_line_switch(const commands& commands,
                                                const description& description,
                                                action action) {
@@ -111,23 +132,28 @@ void commands_handler::print_interactive_options() const {
     std::cerr << "    " << option << std::endl;
 }
 
-void commands_handler::handle_interactive_command(const command& command) {
+std::optional<std::string> commands_handler::handle_interactive_command(
+    const command& command,
+    const command_arg& arg) {
   if (!enabled_)
-    return;  // no commands when SDK is not set
+    return "Not connected";  // no commands when SDK is not set
 
   auto it = interactive_actions_.find(command);
   if (it == interactive_actions_.end()) {
     std::cerr << "Unknown command: " << command << std::endl;
-    return;
+    return "Unknown command: " + command;
   }
+  std::optional<std::string> error;
   for (const auto& iter : it->second) {
     try {
-      iter.second();
+      iter.second(arg);
     } catch (const std::exception& ex) {
       std::cerr << "Command: " << command << " Failed: " << ex.what()
                 << std::endl;
+      error = ex.what();
     }
   }
+  return error;
 }
 
 void commands_handler::handle_command_line_option(const command& option,
@@ -145,15 +171,20 @@ void commands_handler::set_sdk(sdk* sdk) {
 }
 
 void commands_handler::parse_command_line(int argc, char** argv) {
+  parse_command_line(std::vector<std::string>(argv + 1, argv + argc));
+}
+
+void commands_handler::parse_command_line(
+    const std::vector<std::string>& args) {
   if (enabled_)
     throw std::runtime_error("SDK is already set");
 
-  for (int i = 1; i < argc; ++i) {
-    const command cmd = argv[i];
+  for (size_t i = 0; i < args.size(); ++i) {
+    const command& cmd = args[i];
     auto& sw = find_switch(cmd);
-    if (sw.has_argument_ && ++i == argc)
+    if (sw.has_argument_ && ++i == args.size())
       show_help_and_throw("No value provided for option: " + cmd);
-    sw.handle(argv[i]);
+    sw.handle(sw.has_argument_ ? args[i] : command_arg{});
   }
 
   verify_all_mandatory_switches_set();
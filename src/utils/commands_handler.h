@@ -16,6 +16,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 
@@ -45,6 +46,13 @@ class commands_handler {
   void add_interactor(std::shared_ptr<interactor> obj);
 
   void add_interactive_command(const command&, const description&, action);
+  // The argument is the rest of the command line, empty when there is none.
+  void add_interactive_command(const command&,
+                               const description&,
+                               action_with_arg);
+  // Prompt for the argument of a command typed without one on stdin.
+  void set_argument_prompt(const command&, const std::string& prompt);
+  std::optional<std::string> argument_prompt(const command&) const;
   enum class mandatory { no, yes };
   void add_command_line_switch(const commands&, const description&, action);
   void add_command_line_switch(const commands&,
@@ -54,11 +62,15 @@ class commands_handler {
 
   void print_interactive_options() const;
 
-  void handle_interactive_command(const command&);
+  // Returns the error of an unknown command or of a failed action.
+  std::optional<std::string> handle_interactive_command(
+      const command&,
+      const command_arg& = {});
   void handle_command_line_option(const command&, const command_arg&);
 
   void set_sdk(dolbyio::comms::sdk* sdk);
   void parse_command_line(int argc, char** argv);
+  void parse_command_line(const std::vector<std::string>& args);
 
  private:
   struct command_line_switch {
@@ -93,8 +105,9 @@ class commands_handler {
   bool enabled_ = false;
   std::vector<std::shared_ptr<interactor>> interactors_{};
 
-  using description_and_action = std::pair<description, action>;
+  using description_and_action = std::pair<description, action_with_arg>;
   std::map<command, std::vector<description_and_action>> interactive_actions_{};
+  std::map<command, std::string> argument_prompts_{};
 
   std::map<command, command_line_switch> command_line_switches_;
   std::map<alias, command> aliases_;  // and aliases to switches (for handling)
@@ -0,0 +1,199 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/conversation.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+constexpr char definition_file_name[] = "def.json";
+
+std::string base64_encode(const std::string& in) {
+  static const char table[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  out.reserve(((in.size() + 2) / 3) * 4);
+  size_t i = 0;
+  for (; i + 2 < in.size(); i += 3) {
+    unsigned n = (static_cast<unsigned char>(in[i]) << 16) |
+                 (static_cast<unsigned char>(in[i + 1]) << 8) |
+                 static_cast<unsigned char>(in[i + 2]);
+    out.push_back(table[(n >> 18) & 0x3F]);
+    out.push_back(table[(n >> 12) & 0x3F]);
+    out.push_back(table[(n >> 6) & 0x3F]);
+    out.push_back(table[n & 0x3F]);
+  }
+  if (i < in.size()) {
+    unsigned n = static_cast<unsigned char>(in[i]) << 16;
+    if (i + 1 < in.size())
+      n |= static_cast<unsigned char>(in[i + 1]) << 8;
+    out.push_back(table[(n >> 18) & 0x3F]);
+    out.push_back(table[(n >> 12) & 0x3F]);
+    out.push_back(i + 1 < in.size() ? table[(n >> 6) & 0x3F] : '=');
+    out.push_back('=');
+  }
+  return out;
+}
+
+std::string random_index() {
+  static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+  std::random_device device;
+  std::mt19937 gen(device());
+  std::uniform_int_distribution<size_t> dist(0, sizeof(chars) - 2);
+  std::string idx;
+  for (int i = 0; i < 4; ++i)
+    idx.push_back(chars[dist(gen)]);
+  return idx;
+}
+}  // namespace
+
+std::string format_number(double value) {
+  std::ostringstream oss;
+  oss << value;
+  return oss.str();
+}
+
+bot_definition bot_definition::from_json(const json_value& entry) {
+  bot_definition bot;
+  bot.name = entry["name"].as_string();
+  bot.media = entry["media"].as_string();
+  bot.x = entry["x"].as_number();
+  bot.y = entry["y"].as_number();
+  bot.z = entry["z"].as_number();
+  bot.r = entry["r"].as_number();
+  bot.t1 = entry.string_or("t1", "");
+  bot.t2 = entry.string_or("t2", "");
+  if (const auto* start = entry.find("start"))
+    bot.start = start->as_number();
+  if (const auto* stop = entry.find("stop"))
+    bot.stop = stop->as_number();
+  if (bot.start && bot.stop && *bot.stop <= *bot.start)
+    throw std::runtime_error("The stop of " + bot.name +
+                             " is not after its start");
+  if (const auto* path = entry.find("path")) {
+    const auto* loop = entry.find("path_loop");
+    try {
+      bot.path = trajectory::from_json(*path, bot.placement(),
+                                       loop && loop->as_bool());
+    } catch (const std::exception& ex) {
+      throw std::runtime_error("Invalid path of " + bot.name + ": " +
+                               ex.what());
+    }
+  }
+  return bot;
+}
+
+std::string bot_definition::external_id() const {
+  std::ostringstream ext;
+  ext << "{\"init-pos\": {\"x\": " << format_number(x)
+      << ", \"y\": " << format_number(y) << ", \"z\": " << format_number(z)
+      << ", \"r\": " << format_number(r) << "}, \"t1\": " << json_quote(t1)
+      << ", \"t2\": " << json_quote(t2)
+      << ", \"idx\": " << json_quote(random_index()) << "}";
+  return base64_encode(ext.str());
+}
+
+bool bot_definition::audio_only() const {
+  for (const char* ext : {".aac", ".wav", ".m4a"})
+    if (media.find(ext) != std::string::npos)
+      return true;
+  return false;
+}
+
+std::vector<std::string> bot_definition::command_line_args(
+    const std::string& folder) const {
+  return {"-u",
+          name,
+          "-e",
+          external_id(),
+          "-p",
+          "user",
+          "-m",
+          audio_only() ? "A" : "AV",
+          "--enable-media-io",
+          "-f",
+          (std::filesystem::path(folder) / media).string(),
+          "-initial-spatial-position",
+          format_number(x) + ";" + format_number(y) + ";" + format_number(z),
+          "-initial-yaw-rotation",
+          format_number(r)};
+}
+
+conversation conversation::load(const std::string& path) {
+  std::filesystem::path def_path{path};
+  if (std::filesystem::is_directory(def_path))
+    def_path /= definition_file_name;
+
+  conversation conv;
+  conv.definition_file = def_path.string();
+  conv.folder = def_path.parent_path().string();
+  conv.name = def_path.parent_path().filename().string();
+
+  const auto definition = json_value::parse_file(conv.definition_file);
+  // The bots are addressed, and matched when reloading, by name
+  std::set<std::string> names;
+  for (const auto& entry : definition.as_array()) {
+    auto def = bot_definition::from_json(entry);
+    if (!names.insert(def.name).second)
+      throw std::runtime_error("Bot " + def.name + " defined twice in " +
+                               conv.definition_file);
+    conv.bots.push_back(std::move(def));
+  }
+  if (conv.bots.empty())
+    throw std::runtime_error("No bots defined in " + conv.definition_file);
+  return conv;
+}
+
+conversation_delta conversation_delta::between(
+    const conversation& running,
+    const conversation& updated) {
+  auto find = [](const conversation& conv, const std::string& name) {
+    return std::find_if(
+        conv.bots.begin(), conv.bots.end(),
+        [&name](const bot_definition& def) { return def.name == name; });
+  };
+
+  conversation_delta delta;
+  for (const auto& def : running.bots) {
+    auto it = find(updated, def.name);
+    if (it == updated.bots.end() || it->audio_only() != def.audio_only() ||
+        it->t1 != def.t1 || it->t2 != def.t2)
+      delta.removed.push_back(def.name);
+  }
+  for (const auto& def : updated.bots) {
+    auto it = find(running, def.name);
+    if (it == running.bots.end() ||
+        std::find(delta.removed.begin(), delta.removed.end(), def.name) !=
+            delta.removed.end()) {
+      delta.added.push_back(def);
+      continue;
+    }
+    if (it->placement() != def.placement() || it->path != def.path)
+      delta.moved.push_back(def);
+    if (it->media != def.media)
+      delta.media_changed.push_back(def);
+    if (it->start != def.start || it->stop != def.stop)
+      delta.rescheduled.push_back(def);
+  }
+  return delta;
+}
+
+bool conversation_delta::empty() const {
+  return added.empty() && removed.empty() && moved.empty() &&
+         media_changed.empty() && rescheduled.empty();
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,83 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/json.h"
+#include "utils/trajectory.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Single entry of a conversation definition file (def.json), describing one
+ * injection bot: its name, the media it injects and its place in the shared
+ * spatial scene.
+ */
+struct bot_definition {
+  std::string name{};
+  std::string media{};  // Relative to the conversation folder
+  double x{}, y{}, z{}, r{};
+  std::string t1{}, t2{};
+  std::optional<trajectory> path{};  // Moving from the placement above
+  // Seconds from the start of the conversation to start and stop injecting,
+  // the media starting from its beginning.
+  std::optional<double> start{}, stop{};
+
+  spatial_placement placement() const { return {x, y, z, r}; }
+
+  static bot_definition from_json(const json_value& entry);
+
+  // External ID understood by the client side demo applications, the same
+  // base64 encoded JSON which demo.py builds.
+  std::string external_id() const;
+  bool audio_only() const;
+
+  // The command line switches which configure a bot for this entry, these
+  // are appended to the common switches of the bot host.
+  std::vector<std::string> command_line_args(const std::string& folder) const;
+};
+
+/**
+ * A conversation folder holding the def.json file and the referenced media.
+ */
+struct conversation {
+  std::string name{};
+  std::string folder{};
+  std::string definition_file{};
+  std::vector<bot_definition> bots{};
+
+  // Accepts either the conversation folder or the path to its def.json.
+  static conversation load(const std::string& path);
+};
+
+/**
+ * Changes between the bots of a running conversation and its updated
+ * definition, matched by name. A bot whose audio only mode or t1/t2 change is
+ * removed and added again, as these are set when joining.
+ */
+struct conversation_delta {
+  std::vector<bot_definition> added{};
+  std::vector<std::string> removed{};
+  std::vector<bot_definition> moved{};          // Placement or path
+  std::vector<bot_definition> media_changed{};  // Same kind of media
+  std::vector<bot_definition> rescheduled{};    // Start or stop
+
+  static conversation_delta between(const conversation& running,
+                                    const conversation& updated);
+  bool empty() const;
+};
+
+// Format a number the way it is written in def.json (no trailing zeros).
+std::string format_number(double value);
+
+}  // namespace dolbyio::comms::sample
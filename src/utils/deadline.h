@@ -0,0 +1,92 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/async_combinators.h"
+#include "utils/timer_service.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+// Failure of an operation which did not complete within its budget.
+class timeout_error : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+/**
+ * Fails the async_result with a timeout_error if the operation has not
+ * completed within the budget, a zero budget meaning no deadline. The
+ * operation itself keeps running, its late outcome is dropped: on_timeout
+ * lets the operation know, for it to undo its late outcome.
+ */
+template <typename T>
+async_result<T> with_deadline(async_result<T>&& res,
+                              std::chrono::milliseconds budget,
+                              const std::string& what,
+                              std::function<void()> on_timeout = {}) {
+  if (budget.count() <= 0)
+    return std::move(res);
+
+  struct state : detail::fan_in<T> {
+    using detail::fan_in<T>::fan_in;
+    std::atomic<timer_service::timer_id> timer{0};
+  };
+  auto st = std::make_shared<state>(1);
+  auto result = st->result();
+  st->timer = timer_service::instance().schedule_after(
+      budget, [st, what, budget, on_timeout{std::move(on_timeout)}]() {
+        if (on_timeout)
+          on_timeout();
+        st->fail(std::make_exception_ptr(timeout_error(
+            what + " timed out after " + std::to_string(budget.count()) +
+            "ms")));
+      });
+  detail::subscribe(
+      std::move(res),
+      [st](auto&& value) {
+        timer_service::instance().cancel(st->timer);
+        if constexpr (std::is_void_v<T>)
+          st->resolve();
+        else
+          st->resolve(std::move(value));
+      },
+      [st](std::exception_ptr&& err) {
+        timer_service::instance().cancel(st->timer);
+        st->fail(std::move(err));
+      });
+  return result;
+}
+
+/**
+ * Blocks until the operation has completed, for at most the budget (zero
+ * meaning no deadline). Rethrows the failure of the operation, or throws
+ * timeout_error.
+ */
+inline void wait_with_deadline(async_result<void>&& res,
+                               std::chrono::milliseconds budget,
+                               const std::string& what) {
+  auto promise = std::make_shared<std::promise<void>>();
+  auto future = promise->get_future();
+  with_deadline(std::move(res), budget, what)
+      .then([promise]() { promise->set_value(); })
+      .on_error([promise](std::exception_ptr&& ex) {
+        promise->set_exception(std::move(ex));
+      });
+  future.get();
+}
+
+}  // namespace dolbyio::comms::sample
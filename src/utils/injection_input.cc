@@ -0,0 +1,143 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/injection_input.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+std::string vector_arg(const json_value& vec) {
+  return format_number(vec["x"].as_number()) + ";" +
+         format_number(vec["y"].as_number()) + ";" +
+         format_number(vec["z"].as_number());
+}
+
+std::string to_lower(std::string str) {
+  std::transform(str.begin(), str.end(), str.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return str;
+}
+
+}  // namespace
+
+injection_input injection_input::load(const std::string& path) {
+  const auto content = json_value::parse_file(path);
+  injection_input input;
+
+  const auto& access = content["access"];
+  input.client_access_token = access.string_or("client_access_token", "");
+  input.token_server_url = access.string_or("token_server_url", "");
+  if (input.client_access_token.empty()) {
+    if (!input.token_server_url.empty())
+      throw std::runtime_error(
+          "Fetching the token from token_server_url is not supported, place "
+          "a client access token under \"client_access_token\" in " +
+          path);
+    throw std::runtime_error("No client access token specified in " + path);
+  }
+
+  input.conf_alias = content.string_or("conf_alias", "");
+  if (input.conf_alias.empty()) {
+    std::cerr << "No conference alias specified in " << path
+              << ", default value \"demo\" will be used" << std::endl;
+    input.conf_alias = "demo";
+  }
+
+  std::istringstream conversations{content["conversations"].as_string()};
+  for (std::string idx; std::getline(conversations, idx, ',');)
+    if (!idx.empty())
+      input.conversations.push_back(idx);
+  if (input.conversations.empty())
+    throw std::runtime_error("No conversations selected in " + path);
+
+  const auto& spatial = content["spatial"];
+  input.spatial_style = to_lower(spatial["style"].as_string());
+  if (input.spatial_style != "shared" && input.spatial_style != "individual" &&
+      input.spatial_style != "none") {
+    std::cerr << "Invalid spatial style " << input.spatial_style
+              << ", default value \"shared\" will be used" << std::endl;
+    input.spatial_style = "shared";
+  }
+  input.scale = vector_arg(spatial["scale"]);
+  input.right = vector_arg(spatial["right"]);
+  input.up = vector_arg(spatial["up"]);
+  input.forward = vector_arg(spatial["forward"]);
+
+  input.video_codec = content.string_or("video_codec", "");
+  if (input.video_codec != "VP8" && input.video_codec != "H264") {
+    std::cerr << "Video codec " << input.video_codec
+              << " is not recognized, H264 will be used" << std::endl;
+    input.video_codec = "H264";
+  }
+  return input;
+}
+
+std::vector<conversation> injection_input::select_conversations(
+    const std::string& conversations_root) const {
+  std::vector<std::string> folders;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(conversations_root)) {
+    const auto name = entry.path().filename().string();
+    if (entry.is_directory() && name.rfind('.', 0) != 0)
+      folders.push_back(name);
+  }
+  std::sort(folders.begin(), folders.end());
+
+  std::vector<conversation> selected;
+  for (const auto& idx : conversations) {
+    bool found = false;
+    for (const auto& folder : folders) {
+      if (folder.rfind(idx, 0) != 0)
+        continue;
+      found = true;
+      const auto path = std::filesystem::path(conversations_root) / folder;
+      if (std::filesystem::exists(path / "def.json"))
+        selected.push_back(conversation::load(path.string()));
+    }
+    if (!found)
+      std::cerr << "Invalid conversation index specified " << idx
+                << ", request ignored" << std::endl;
+  }
+  return selected;
+}
+
+std::vector<std::string> injection_input::common_args() const {
+  std::vector<std::string> args = {"-c",
+                                   conf_alias,
+                                   "-k",
+                                   client_access_token,
+                                   "-l",
+                                   "3",
+                                   "-initial-scale",
+                                   scale,
+                                   "-loop",
+                                   "-initial-right",
+                                   right,
+                                   "-initial-up",
+                                   up,
+                                   "-initial-forward",
+                                   forward,
+                                   "-video-codec",
+                                   video_codec};
+  if (spatial_style != "none") {
+    args.push_back("-spatial");
+    args.push_back(spatial_style);
+  }
+  return args;
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,47 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/conversation.h"
+
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * The injection input file (injection-input.json), which selects the
+ * conversations to inject and holds the settings common to every bot. The
+ * same validation and defaults as demo.py are applied.
+ */
+struct injection_input {
+  std::string client_access_token{};
+  std::string token_server_url{};
+  std::string conf_alias{"demo"};
+  std::vector<std::string> conversations{};  // Folder name prefixes
+  std::string spatial_style{"shared"};
+  std::string scale{"1;1;1"};
+  std::string right{"1;0;0"};
+  std::string up{"0;1;0"};
+  std::string forward{"0;0;-1"};
+  std::string video_codec{"H264"};
+
+  static injection_input load(const std::string& path);
+
+  // The conversation folders selected by the input, in the conversations
+  // root folder. Unknown indexes are reported and ignored.
+  std::vector<conversation> select_conversations(
+      const std::string& conversations_root) const;
+
+  // The command line switches common to every bot.
+  std::vector<std::string> common_args() const;
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,392 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/json.h"
+
+#include <fstream>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+
+namespace dolbyio::comms::sample {
+
+class json_value::parser {
+ public:
+  explicit parser(const std::string& text) : text_(text) {}
+
+  json_value parse_document() {
+    json_value value = parse_value();
+    skip_whitespace();
+    if (pos_ != text_.size())
+      fail("Unexpected trailing characters");
+    return value;
+  }
+
+ private:
+  [[noreturn]] void fail(const std::string& what) const {
+    throw std::runtime_error("JSON parse error at offset " +
+                             std::to_string(pos_) + ": " + what);
+  }
+
+  void skip_whitespace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+            text_[pos_] == '\r'))
+      ++pos_;
+  }
+
+  char peek() {
+    skip_whitespace();
+    if (pos_ >= text_.size())
+      fail("Unexpected end of input");
+    return text_[pos_];
+  }
+
+  void expect(char c) {
+    if (peek() != c)
+      fail(std::string("Expected '") + c + "'");
+    ++pos_;
+  }
+
+  bool consume_literal(const char* literal) {
+    const std::string lit{literal};
+    if (text_.compare(pos_, lit.size(), lit) != 0)
+      return false;
+    pos_ += lit.size();
+    return true;
+  }
+
+  json_value parse_value() {
+    json_value value;
+    switch (peek()) {
+      case '{':
+        value.type_ = type::object;
+        parse_object(value.object_);
+        break;
+      case '[':
+        value.type_ = type::array;
+        parse_array(value.array_);
+        break;
+      case '"':
+        value.type_ = type::string;
+        value.string_ = parse_string();
+        break;
+      case 't':
+      case 'f':
+        value.type_ = type::boolean;
+        if (consume_literal("true"))
+          value.bool_ = true;
+        else if (consume_literal("false"))
+          value.bool_ = false;
+        else
+          fail("Invalid literal");
+        break;
+      case 'n':
+        if (!consume_literal("null"))
+          fail("Invalid literal");
+        break;
+      default:
+        value.type_ = type::number;
+        value.number_ = parse_number();
+        break;
+    }
+    return value;
+  }
+
+  void parse_object(object& members) {
+    expect('{');
+    if (peek() == '}') {
+      ++pos_;
+      return;
+    }
+    while (true) {
+      if (peek() != '"')
+        fail("Expected object key");
+      auto key = parse_string();
+      expect(':');
+      members.emplace_back(std::move(key), parse_value());
+      if (peek() == ',') {
+        ++pos_;
+        continue;
+      }
+      expect('}');
+      return;
+    }
+  }
+
+  void parse_array(array& elements) {
+    expect('[');
+    if (peek() == ']') {
+      ++pos_;
+      return;
+    }
+    while (true) {
+      elements.push_back(parse_value());
+      if (peek() == ',') {
+        ++pos_;
+        continue;
+      }
+      expect(']');
+      return;
+    }
+  }
+
+  std::string parse_string() {
+    expect('"');
+    std::string out;
+    while (true) {
+      if (pos_ >= text_.size())
+        fail("Unterminated string");
+      char c = text_[pos_++];
+      if (c == '"')
+        return out;
+      if (c != '\\') {
+        out.push_back(c);
+        continue;
+      }
+      if (pos_ >= text_.size())
+        fail("Unterminated escape sequence");
+      c = text_[pos_++];
+      switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+          out.push_back(c);
+          break;
+        case 'b':
+          out.push_back('\b');
+          break;
+        case 'f':
+          out.push_back('\f');
+          break;
+        case 'n':
+          out.push_back('\n');
+          break;
+        case 'r':
+          out.push_back('\r');
+          break;
+        case 't':
+          out.push_back('\t');
+          break;
+        case 'u':
+          append_utf8(out, parse_code_point());
+          break;
+        default:
+          fail("Invalid escape sequence");
+      }
+    }
+  }
+
+  unsigned parse_hex4() {
+    if (pos_ + 4 > text_.size())
+      fail("Truncated unicode escape");
+    unsigned code = 0;
+    for (int i = 0; i < 4; ++i) {
+      char c = text_[pos_++];
+      code <<= 4;
+      if (c >= '0' && c <= '9')
+        code |= c - '0';
+      else if (c >= 'a' && c <= 'f')
+        code |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        code |= c - 'A' + 10;
+      else
+        fail("Invalid unicode escape");
+    }
+    return code;
+  }
+
+  // A character outside of the basic plane is escaped as a surrogate pair
+  unsigned parse_code_point() {
+    const unsigned code = parse_hex4();
+    if (code >= 0xDC00 && code <= 0xDFFF)
+      fail("Unpaired low surrogate");
+    if (code < 0xD800 || code > 0xDBFF)
+      return code;
+    if (text_.compare(pos_, 2, "\\u") != 0)
+      fail("Unpaired high surrogate");
+    pos_ += 2;
+    const unsigned low = parse_hex4();
+    if (low < 0xDC00 || low > 0xDFFF)
+      fail("Unpaired high surrogate");
+    return 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+  }
+
+  static void append_utf8(std::string& out, unsigned code) {
+    if (code < 0x80) {
+      out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+      out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+  }
+
+  bool digit_at(size_t pos) const {
+    return pos < text_.size() && text_[pos] >= '0' && text_[pos] <= '9';
+  }
+
+  size_t skip_digits(size_t pos) const {
+    while (digit_at(pos))
+      ++pos;
+    return pos;
+  }
+
+  // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? only: no leading +, hex,
+  // nan nor inf, which strtod accepts.
+  double parse_number() {
+    size_t end = pos_;
+    if (end < text_.size() && text_[end] == '-')
+      ++end;
+    if (!digit_at(end))
+      fail("Invalid value");
+    end = text_[end] == '0' ? end + 1 : skip_digits(end);
+    if (end < text_.size() && text_[end] == '.') {
+      if (!digit_at(end + 1))
+        fail("Invalid number");
+      end = skip_digits(end + 1);
+    }
+    if (end < text_.size() && (text_[end] == 'e' || text_[end] == 'E')) {
+      ++end;
+      if (end < text_.size() && (text_[end] == '+' || text_[end] == '-'))
+        ++end;
+      if (!digit_at(end))
+        fail("Invalid number");
+      end = skip_digits(end);
+    }
+    // Whatever the locale of the process, the decimal separator is a dot
+    std::istringstream in(text_.substr(pos_, end - pos_));
+    in.imbue(std::locale::classic());
+    double value = 0;
+    in >> value;
+    if (in.fail())
+      fail("Number out of range");
+    pos_ = end;
+    return value;
+  }
+
+  const std::string& text_;
+  size_t pos_{0};
+};
+
+json_value json_value::parse(const std::string& text) {
+  return parser{text}.parse_document();
+}
+
+json_value json_value::parse_file(const std::string& path) {
+  std::ifstream file(path);
+  if (!file)
+    throw std::runtime_error("Unable to open JSON file: " + path);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  try {
+    return parse(contents.str());
+  } catch (const std::runtime_error& ex) {
+    throw std::runtime_error(path + ": " + ex.what());
+  }
+}
+
+bool json_value::as_bool() const {
+  if (type_ != type::boolean)
+    throw std::runtime_error("JSON value is not a boolean");
+  return bool_;
+}
+
+double json_value::as_number() const {
+  if (type_ != type::number)
+    throw std::runtime_error("JSON value is not a number");
+  return number_;
+}
+
+const std::string& json_value::as_string() const {
+  if (type_ != type::string)
+    throw std::runtime_error("JSON value is not a string");
+  return string_;
+}
+
+const json_value::array& json_value::as_array() const {
+  if (type_ != type::array)
+    throw std::runtime_error("JSON value is not an array");
+  return array_;
+}
+
+const json_value::object& json_value::as_object() const {
+  if (type_ != type::object)
+    throw std::runtime_error("JSON value is not an object");
+  return object_;
+}
+
+const json_value* json_value::find(const std::string& key) const {
+  for (const auto& member : as_object())
+    if (member.first == key)
+      return &member.second;
+  return nullptr;
+}
+
+const json_value& json_value::operator[](const std::string& key) const {
+  const auto* value = find(key);
+  if (!value)
+    throw std::runtime_error("JSON object has no member: " + key);
+  return *value;
+}
+
+double json_value::number_or(const std::string& key, double fallback) const {
+  const auto* value = find(key);
+  return value ? value->as_number() : fallback;
+}
+
+std::string json_value::string_or(const std::string& key,
+                                  const std::string& fallback) const {
+  const auto* value = find(key);
+  return value ? value->as_string() : fallback;
+}
+
+std::string json_quote(const std::string& str) {
+  std::string out{"\""};
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          static const char hex[] = "0123456789abcdef";
+          out += "\\u00";
+          out.push_back(hex[(c >> 4) & 0xF]);
+          out.push_back(hex[c & 0xF]);
+        } else {
+          out.push_back(c);
+        }
+    }
+  }
+  out.push_back('"');
+  return out;
+}
+
+}  // namespace dolbyio::comms::sample
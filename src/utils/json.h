@@ -0,0 +1,72 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Minimal JSON document model used for reading the conversation definition
+ * files (def.json) and the injection input. It parses the JSON grammar of
+ * RFC 8259, whatever the locale, into UTF-8 strings, but only provides read
+ * access to the parsed values.
+ */
+class json_value {
+ public:
+  enum class type { null, boolean, number, string, array, object };
+  using array = std::vector<json_value>;
+  using object = std::vector<std::pair<std::string, json_value>>;
+
+  // Parsing throws std::runtime_error describing the offending position.
+  static json_value parse(const std::string& text);
+  static json_value parse_file(const std::string& path);
+
+  type get_type() const { return type_; }
+  bool is_null() const { return type_ == type::null; }
+  bool is_number() const { return type_ == type::number; }
+  bool is_string() const { return type_ == type::string; }
+  bool is_array() const { return type_ == type::array; }
+  bool is_object() const { return type_ == type::object; }
+
+  bool as_bool() const;
+  double as_number() const;
+  const std::string& as_string() const;
+  const array& as_array() const;
+  const object& as_object() const;
+
+  // Object member access, find() returns nullptr if the key is not present
+  // while operator[] throws.
+  const json_value* find(const std::string& key) const;
+  const json_value& operator[](const std::string& key) const;
+  bool contains(const std::string& key) const { return find(key) != nullptr; }
+
+  // Convenience accessors returning the fallback when the member is missing.
+  double number_or(const std::string& key, double fallback) const;
+  std::string string_or(const std::string& key,
+                        const std::string& fallback) const;
+
+ private:
+  class parser;
+
+  type type_{type::null};
+  bool bool_{};
+  double number_{};
+  std::string string_{};
+  array array_{};
+  object object_{};
+};
+
+// Serialize a string as a quoted JSON string literal.
+std::string json_quote(const std::string& str);
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,218 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/metrics.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace dolbyio::comms::sample::metrics {
+
+namespace {
+
+std::string escape(const std::string& value) {
+  std::string out;
+  for (char c : value) {
+    if (c == '\\' || c == '"')
+      out += '\\';
+    if (c == '\n')
+      out += "\\n";
+    else
+      out += c;
+  }
+  return out;
+}
+
+std::string render_labels(const labels& lbls) {
+  std::string out;
+  for (const auto& [key, value] : lbls) {
+    if (!out.empty())
+      out += ',';
+    out += key + "=\"" + escape(value) + "\"";
+  }
+  return out;
+}
+
+// Series name with its labels and an optional extra label (le)
+std::string series(const std::string& name,
+                   const std::string& lbls,
+                   const std::string& extra = {}) {
+  if (lbls.empty() && extra.empty())
+    return name;
+  std::string out = name + "{" + lbls;
+  if (!lbls.empty() && !extra.empty())
+    out += ',';
+  return out + extra + "}";
+}
+
+void add(std::atomic<double>& target, double value) {
+  double current = target.load(std::memory_order_relaxed);
+  while (!target.compare_exchange_weak(current, current + value,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+histogram::histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)),
+      counts_(new std::atomic<uint64_t>[bounds_.size() + 1]) {
+  for (size_t i = 0; i <= bounds_.size(); ++i)
+    counts_[i] = 0;
+}
+
+void histogram::observe(double value) {
+  const size_t bucket =
+      std::lower_bound(bounds_.begin(), bounds_.end(), value) -
+      bounds_.begin();
+  counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+  add(sum_, value);
+}
+
+std::vector<uint64_t> histogram::cumulative_counts() const {
+  std::vector<uint64_t> counts(bounds_.size() + 1);
+  uint64_t total = 0;
+  for (size_t i = 0; i <= bounds_.size(); ++i) {
+    total += counts_[i].load(std::memory_order_relaxed);
+    counts[i] = total;
+  }
+  return counts;
+}
+
+std::vector<double> frame_time_buckets() {
+  return {0.0005, 0.001, 0.0025, 0.005, 0.0075, 0.01,  0.0125,
+          0.015,  0.02,  0.025,  0.033, 0.04,   0.05,  0.075,
+          0.1,    0.25,  0.5,    1.0};
+}
+
+registry& registry::instance() {
+  static registry reg;
+  return reg;
+}
+
+registry::family& registry::get_family(const std::string& name,
+                                       const std::string& help,
+                                       type kind) {
+  auto it = families_.find(name);
+  if (it == families_.end())
+    it = families_.emplace(name, family{kind, help, {}}).first;
+  else if (it->second.kind != kind)
+    throw std::runtime_error("Metric " + name +
+                             " registered with different types");
+  return it->second;
+}
+
+counter& registry::get_counter(const std::string& name,
+                               const std::string& help,
+                               const labels& lbls) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto& slot =
+      get_family(name, help, type::counter).series[render_labels(lbls)];
+  if (!slot)
+    slot = std::make_shared<counter>();
+  return *std::static_pointer_cast<counter>(slot);
+}
+
+gauge& registry::get_gauge(const std::string& name,
+                           const std::string& help,
+                           const labels& lbls) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto& slot =
+      get_family(name, help, type::gauge).series[render_labels(lbls)];
+  if (!slot)
+    slot = std::make_shared<gauge>();
+  return *std::static_pointer_cast<gauge>(slot);
+}
+
+histogram& registry::get_histogram(const std::string& name,
+                                   const std::string& help,
+                                   const labels& lbls,
+                                   std::vector<double> bounds) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto& slot =
+      get_family(name, help, type::histogram).series[render_labels(lbls)];
+  if (!slot)
+    slot = std::make_shared<histogram>(std::move(bounds));
+  return *std::static_pointer_cast<histogram>(slot);
+}
+
+std::string registry::render() const {
+  std::ostringstream out;
+  // Counters of bytes and sums of seconds exceed the 6 digits by default
+  out.precision(std::numeric_limits<double>::max_digits10);
+  std::lock_guard<std::mutex> lock(lock_);
+  for (const auto& [name, fam] : families_) {
+    static const char* type_names[] = {"counter", "gauge", "histogram"};
+    out << "# HELP " << name << " " << fam.help << "\n# TYPE " << name << " "
+        << type_names[static_cast<int>(fam.kind)] << "\n";
+    for (const auto& [lbls, metric] : fam.series) {
+      switch (fam.kind) {
+        case type::counter:
+          out << series(name, lbls) << " "
+              << static_cast<const counter*>(metric.get())->value() << "\n";
+          break;
+        case type::gauge:
+          out << series(name, lbls) << " "
+              << static_cast<const gauge*>(metric.get())->value() << "\n";
+          break;
+        case type::histogram: {
+          const auto* hist = static_cast<const histogram*>(metric.get());
+          const auto counts = hist->cumulative_counts();
+          for (size_t i = 0; i < hist->bounds().size(); ++i) {
+            std::ostringstream le;
+            le << "le=\"" << hist->bounds()[i] << "\"";
+            out << series(name + "_bucket", lbls, le.str()) << " "
+                << counts[i] << "\n";
+          }
+          out << series(name + "_bucket", lbls, "le=\"+Inf\"") << " "
+              << counts.back() << "\n"
+              << series(name + "_sum", lbls) << " " << hist->sum() << "\n"
+              << series(name + "_count", lbls) << " " << counts.back()
+              << "\n";
+          break;
+        }
+      }
+    }
+  }
+  return out.str();
+}
+
+injection_metrics::media::media(const std::string& bot, const char* kind)
+    : injected(registry::instance().get_counter(
+          "injection_frames_total",
+          "Frames pushed into the injector.",
+          {{"bot", bot}, {"media", kind}})),
+      dropped(registry::instance().get_counter(
+          "injection_frames_dropped_total",
+          "Frames the injector did not accept.",
+          {{"bot", bot}, {"media", kind}})),
+      push_interval(registry::instance().get_histogram(
+          "injection_push_interval_seconds",
+          "Time between two consecutive frames pushed into the injector, "
+          "before the pacing of the SDK injector when it paces them.",
+          {{"bot", bot}, {"media", kind}})),
+      push_jitter(registry::instance().get_gauge(
+          "injection_push_jitter_seconds",
+          "Smoothed variation of the push interval (RFC 3550).",
+          {{"bot", bot}, {"media", kind}})),
+      queued(registry::instance().get_gauge(
+          "injection_queue_frames",
+          "Frames decoded ahead of the injection and waiting for it.",
+          {{"bot", bot}, {"media", kind}})),
+      underruns(registry::instance().get_counter(
+          "injection_underruns_total",
+          "Frames due for injection which had not been decoded in time.",
+          {{"bot", bot}, {"media", kind}})) {}
+
+injection_metrics::injection_metrics(const std::string& bot)
+    : audio(bot, "audio"), video(bot, "video") {}
+
+}  // namespace dolbyio::comms::sample::metrics
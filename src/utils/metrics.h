@@ -0,0 +1,133 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Process wide registry of the metrics, rendered in the Prometheus text
+ * exposition format. The metrics are looked up once, by name and labels, and
+ * then updated without locking from the media threads.
+ */
+namespace metrics {
+using labels = std::vector<std::pair<std::string, std::string>>;
+
+class counter {
+ public:
+  void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+class gauge {
+ public:
+  void set(double value) { value_.store(value, std::memory_order_relaxed); }
+  double value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<double> value_{0};
+};
+
+class histogram {
+ public:
+  // Upper bounds of the buckets, in increasing order.
+  explicit histogram(std::vector<double> bounds);
+
+  void observe(double value);
+  void observe(std::chrono::steady_clock::duration duration) {
+    observe(std::chrono::duration<double>(duration).count());
+  }
+
+  const std::vector<double>& bounds() const { return bounds_; }
+  // Cumulative count of the observations in each bucket, the last one is
+  // the total count.
+  std::vector<uint64_t> cumulative_counts() const;
+  double sum() const { return sum_.load(std::memory_order_relaxed); }
+
+ private:
+  std::vector<double> bounds_;
+  std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+  std::atomic<double> sum_{0};
+};
+
+// Buckets for the durations of the media frames, in seconds.
+std::vector<double> frame_time_buckets();
+
+class registry {
+ public:
+  static registry& instance();
+
+  counter& get_counter(const std::string& name,
+                       const std::string& help,
+                       const labels& lbls = {});
+  gauge& get_gauge(const std::string& name,
+                   const std::string& help,
+                   const labels& lbls = {});
+  histogram& get_histogram(const std::string& name,
+                           const std::string& help,
+                           const labels& lbls = {},
+                           std::vector<double> bounds = frame_time_buckets());
+
+  std::string render() const;
+
+ private:
+  enum class type { counter, gauge, histogram };
+  struct family {
+    type kind;
+    std::string help;
+    std::map<std::string, std::shared_ptr<void>> series;
+  };
+
+  family& get_family(const std::string& name,
+                     const std::string& help,
+                     type kind);
+
+  mutable std::mutex lock_{};
+  std::map<std::string, family> families_{};
+};
+
+/**
+ * Metrics of the media injected by one bot.
+ */
+struct injection_metrics {
+  struct media {
+    media(const std::string& bot, const char* kind);
+
+    counter& injected;
+    counter& dropped;
+    // Timed as the frames are pushed: ahead of the pacing of the SDK, which
+    // does not expose when it passes them on, unless paced by the caller
+    histogram& push_interval;
+    gauge& push_jitter;
+    // Frames decoded ahead of the injection, when streaming
+    gauge& queued;
+    counter& underruns;
+  };
+
+  explicit injection_metrics(const std::string& bot);
+
+  media audio;
+  media video;
+};
+}  // namespace metrics
+
+}  // namespace dolbyio::comms::sample
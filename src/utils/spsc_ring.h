@@ -0,0 +1,94 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Bounded ring of preallocated slots between a single producer thread and a
+ * single consumer thread. The producer fills the slot returned by
+ * write_slot() and publishes it with push(), the consumer reads front() and
+ * hands the slot back with pop(). Neither side locks nor allocates.
+ *
+ * The indices only ever grow, each is written by one side only and kept on
+ * a cache line of its own, along with the copy of the other index its owner
+ * last read, so that the two threads only share a cache line when the ring
+ * looks full or empty to one of them.
+ */
+template <typename T>
+class spsc_ring {
+ public:
+  explicit spsc_ring(size_t capacity)
+      : capacity_(capacity), slots_(std::make_unique<T[]>(capacity)) {}
+
+  spsc_ring(const spsc_ring&) = delete;
+  spsc_ring& operator=(const spsc_ring&) = delete;
+
+  size_t capacity() const { return capacity_; }
+
+  // Slots published and not yet popped. Exact from either side, an estimate
+  // from any other thread.
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  // Producer side: the slot to fill, null when the ring is full.
+  T* write_slot() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == capacity_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == capacity_)
+        return nullptr;
+    }
+    return &slots_[tail % capacity_];
+  }
+
+  // Producer side: publishes the slot returned by write_slot().
+  void push() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  // Consumer side: the oldest published slot, null when the ring is empty.
+  T* front() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_)
+        return nullptr;
+    }
+    return &slots_[head % capacity_];
+  }
+
+  // Consumer side: hands the slot returned by front() back to the producer.
+  void pop() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+ private:
+  static constexpr size_t cache_line = 64;
+
+  const size_t capacity_;
+  const std::unique_ptr<T[]> slots_;
+
+  alignas(cache_line) std::atomic<size_t> head_{0};
+  size_t cached_tail_{0};
+
+  alignas(cache_line) std::atomic<size_t> tail_{0};
+  size_t cached_head_{0};
+};
+
+}  // namespace dolbyio::comms::sample
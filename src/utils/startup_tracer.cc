@@ -0,0 +1,118 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/startup_tracer.h"
+#include "utils/json.h"
+#include "utils/trace.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace dolbyio::comms::sample {
+
+namespace {
+constexpr char output_file_name[] = "startup.jsonl";
+
+// Bots hosted in the same process share the output file
+std::mutex output_lock{};
+}  // namespace
+
+startup_tracer::startup_tracer()
+    : start_(clock::now()), start_wall_(std::chrono::system_clock::now()) {}
+
+void startup_tracer::set_output(const std::string& log_dir,
+                                const std::string& bot_name) {
+  std::lock_guard<std::mutex> lock(lock_);
+  log_dir_ = log_dir;
+  bot_name_ = bot_name;
+}
+
+void startup_tracer::stage(const char* name) {
+  const auto now = clock::now();
+  std::lock_guard<std::mutex> lock(lock_);
+  stages_.push_back({name, now});
+  trace::instant("startup", name, "\"bot\": " + json_quote(bot_name_));
+}
+
+void startup_tracer::joined(bool expect_frames) {
+  std::lock_guard<std::mutex> lock(lock_);
+  joined_ = true;
+  expect_frames_ = expect_frames;
+  if (!expect_frames_ || first_frame_)
+    emit(std::nullopt);
+}
+
+void startup_tracer::first_frame() {
+  const auto now = clock::now();
+  std::lock_guard<std::mutex> lock(lock_);
+  if (first_frame_)
+    return;
+  first_frame_ = now;
+  if (joined_)
+    emit(std::nullopt);
+}
+
+void startup_tracer::failed(const std::string& error) {
+  std::lock_guard<std::mutex> lock(lock_);
+  emit(error);
+}
+
+double startup_tracer::ms_since_start(clock::time_point at) const {
+  return std::chrono::duration<double, std::milli>(at - start_).count();
+}
+
+void startup_tracer::emit(const std::optional<std::string>& error) {
+  if (emitted_)
+    return;
+  emitted_ = true;
+
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1);
+  line << "{\"bot\": " << json_quote(bot_name_);
+#if defined(__linux__)
+  line << ", \"pid\": " << getpid();
+#endif
+  line << ", \"start_unix_ms\": "
+       << std::chrono::duration_cast<std::chrono::milliseconds>(
+              start_wall_.time_since_epoch())
+              .count()
+       << ", \"stages\": [";
+  auto previous = start_;
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    const auto& stage = stages_[i];
+    line << (i ? ", " : "") << "{\"name\": " << json_quote(stage.name)
+         << ", \"at_ms\": " << ms_since_start(stage.at) << ", \"duration_ms\": "
+         << std::chrono::duration<double, std::milli>(stage.at - previous)
+                .count()
+         << "}";
+    previous = stage.at;
+  }
+  line << "], \"time_to_first_frame_ms\": ";
+  if (first_frame_)
+    line << ms_since_start(*first_frame_);
+  else
+    line << "null";
+  line << ", \"error\": " << (error ? json_quote(*error) : "null") << "}\n";
+
+  std::lock_guard<std::mutex> lock(output_lock);
+  if (log_dir_.empty()) {
+    std::cerr << line.str() << std::flush;
+    return;
+  }
+  std::ofstream out(log_dir_ + "/" + output_file_name, std::ios::app);
+  out << line.str() << std::flush;
+}
+
+}  // namespace dolbyio::comms::sample
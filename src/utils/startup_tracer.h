@@ -0,0 +1,70 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Records the monotonic time at which every stage of the startup of a bot
+ * completes, and the time to the first frame pushed into the injector. Once
+ * the startup is over (first frame injected, or failure) a single JSON line
+ * is appended to startup.jsonl in the log directory of the bot:
+ *
+ *   {"bot": "Dan", "pid": 42, "start_unix_ms": 1690000000000,
+ *    "stages": [{"name": "open_session", "at_ms": 310.2,
+ *                "duration_ms": 250.7}, ...],
+ *    "time_to_first_frame_ms": 1210.4, "error": null}
+ *
+ * The times are relative to the creation of the bot.
+ */
+class startup_tracer {
+ public:
+  startup_tracer();
+
+  // Where the line is written, stderr if the log directory is empty.
+  void set_output(const std::string& log_dir, const std::string& bot_name);
+
+  void stage(const char* name);
+
+  // The startup is over once the bot has joined, and has injected its first
+  // frame if it injects anything.
+  void joined(bool expect_frames);
+  void first_frame();
+  void failed(const std::string& error);
+
+ private:
+  using clock = std::chrono::steady_clock;
+  struct stage_time {
+    std::string name;
+    clock::time_point at;
+  };
+
+  void emit(const std::optional<std::string>& error);
+  double ms_since_start(clock::time_point at) const;
+
+  const clock::time_point start_;
+  const std::chrono::system_clock::time_point start_wall_;
+  std::mutex lock_{};
+  std::string log_dir_{};
+  std::string bot_name_{};
+  std::vector<stage_time> stages_{};
+  std::optional<clock::time_point> first_frame_{};
+  bool joined_{false};
+  bool expect_frames_{false};
+  bool emitted_{false};
+};
+
+}  // namespace dolbyio::comms::sample
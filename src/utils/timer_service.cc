@@ -0,0 +1,81 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/timer_service.h"
+#include "utils/trace.h"
+
+#include <iostream>
+
+namespace dolbyio::comms::sample {
+
+timer_service& timer_service::instance() {
+  static timer_service service;
+  return service;
+}
+
+timer_service::~timer_service() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    quit_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+timer_service::timer_id timer_service::schedule(clock::time_point at,
+                                                std::function<void()> cb) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!thread_.joinable())
+    thread_ = std::thread([this]() { run(); });
+  const timer_id id = next_id_++;
+  const bool earliest = timers_.empty() || at < timers_.begin()->first.first;
+  timers_.emplace(std::make_pair(at, id), std::move(cb));
+  due_.emplace(id, at);
+  if (earliest)
+    cond_.notify_all();
+  return id;
+}
+
+bool timer_service::cancel(timer_id id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = due_.find(id);
+  if (it == due_.end())
+    return false;
+  timers_.erase(std::make_pair(it->second, id));
+  due_.erase(it);
+  return true;
+}
+
+void timer_service::run() {
+  trace::set_thread_name("timer_service");
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!quit_) {
+    if (timers_.empty()) {
+      cond_.wait(lock);
+      continue;
+    }
+    const auto next = timers_.begin()->first.first;
+    if (next > clock::now()) {
+      cond_.wait_until(lock, next);
+      continue;
+    }
+    auto timer = timers_.extract(timers_.begin());
+    due_.erase(timer.key().second);
+    lock.unlock();
+    try {
+      timer.mapped()();
+    } catch (const std::exception& ex) {
+      std::cerr << "Timer callback failed: " << ex.what() << std::endl;
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace dolbyio::comms::sample
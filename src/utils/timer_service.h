@@ -0,0 +1,63 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Process wide timer thread, running the callbacks of the timers when they
+ * are due. The callbacks run on the timer thread and must be short, they
+ * typically fail an async_result or post work elsewhere. The thread is
+ * started by the first timer, so that a process can fork before using it.
+ */
+class timer_service {
+ public:
+  using clock = std::chrono::steady_clock;
+  using timer_id = uint64_t;
+
+  static timer_service& instance();
+
+  timer_service() = default;
+  ~timer_service();
+
+  timer_service(const timer_service&) = delete;
+  timer_service& operator=(const timer_service&) = delete;
+
+  timer_id schedule(clock::time_point at, std::function<void()> cb);
+  timer_id schedule_after(clock::duration delay, std::function<void()> cb) {
+    return schedule(clock::now() + delay, std::move(cb));
+  }
+
+  // Returns false if the timer has already fired or been cancelled.
+  bool cancel(timer_id id);
+
+ private:
+  void run();
+
+  std::mutex lock_{};
+  std::condition_variable cond_{};
+  std::map<std::pair<clock::time_point, timer_id>, std::function<void()>>
+      timers_{};
+  std::map<timer_id, clock::time_point> due_{};
+  timer_id next_id_{1};
+  bool quit_{false};
+  std::thread thread_{};
+};
+
+}  // namespace dolbyio::comms::sample
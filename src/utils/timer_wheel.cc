@@ -0,0 +1,92 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/timer_wheel.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace dolbyio::comms::sample {
+
+timer_wheel::timer_wheel(clock::time_point start,
+                         clock::duration tick,
+                         size_t slots)
+    : start_(start), tick_(tick), slots_(slots) {}
+
+int64_t timer_wheel::tick_of(clock::time_point at) const {
+  // Rounded up, so that a timer never fires early
+  return (at - start_ + tick_ - clock::duration(1)) / tick_;
+}
+
+timer_wheel::timer_id timer_wheel::schedule(clock::time_point at,
+                                            std::function<void()> cb) {
+  const int64_t tick = std::max(tick_of(at), current_ + 1);
+  const size_t slot = tick % slots_.size();
+  const timer_id id = next_id_++;
+  slots_[slot].push_back({id, tick, std::move(cb)});
+  slot_of_.emplace(id, slot);
+  return id;
+}
+
+bool timer_wheel::cancel(timer_id id) {
+  auto it = slot_of_.find(id);
+  if (it == slot_of_.end())
+    return false;
+  auto& slot = slots_[it->second];
+  slot.erase(std::find_if(slot.begin(), slot.end(),
+                          [id](const timer& t) { return t.id == id; }));
+  slot_of_.erase(it);
+  return true;
+}
+
+std::vector<timer_wheel::timer> timer_wheel::take_due(size_t slot,
+                                                      int64_t tick) {
+  auto& timers = slots_[slot];
+  auto due = std::stable_partition(
+      timers.begin(), timers.end(),
+      [tick](const timer& t) { return t.tick > tick; });
+  std::vector<timer> taken(std::make_move_iterator(due),
+                           std::make_move_iterator(timers.end()));
+  timers.erase(due, timers.end());
+  for (const auto& t : taken)
+    slot_of_.erase(t.id);
+  return taken;
+}
+
+void timer_wheel::advance(clock::time_point now) {
+  const int64_t target = (now - start_) / tick_;
+  while (current_ < target) {
+    // Past a whole turn every slot holds due timers, which are run at once
+    // in the order of their ticks.
+    std::vector<timer> due;
+    if (target - current_ >= static_cast<int64_t>(slots_.size())) {
+      for (size_t slot = 0; slot < slots_.size(); ++slot) {
+        auto taken = take_due(slot, target);
+        std::move(taken.begin(), taken.end(), std::back_inserter(due));
+      }
+      std::stable_sort(due.begin(), due.end(),
+                       [](const timer& a, const timer& b) {
+                         return a.tick < b.tick;
+                       });
+      current_ = target;
+    } else {
+      ++current_;
+      due = take_due(current_ % slots_.size(), current_);
+    }
+    for (auto& t : due) {
+      try {
+        t.cb();
+      } catch (const std::exception& ex) {
+        std::cerr << "Timer callback failed: " << ex.what() << std::endl;
+      }
+    }
+  }
+}
+
+}  // namespace dolbyio::comms::sample
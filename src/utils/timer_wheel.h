@@ -0,0 +1,70 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Hashed timing wheel, for the many timers of the bots hosted by a process
+ * which are scheduled ahead: scheduling and cancelling a timer is constant
+ * time, and advancing the wheel only looks at the slot of every elapsed
+ * tick. A timer lands in the slot of its tick modulo the number of slots,
+ * along with the timers due whole turns of the wheel later.
+ *
+ * Not thread safe, the wheel is advanced by the thread owning it, e.g. from
+ * a timer of the event loop, and the timers fire on the first advance past
+ * their tick, in the order of their ticks.
+ */
+class timer_wheel {
+ public:
+  using clock = std::chrono::steady_clock;
+  using timer_id = uint64_t;
+
+  timer_wheel(clock::time_point start,
+              clock::duration tick = std::chrono::milliseconds(10),
+              size_t slots = 512);
+
+  // A time already past fires on the next advance.
+  timer_id schedule(clock::time_point at, std::function<void()> cb);
+  // Returns false if the timer has already fired or been cancelled.
+  bool cancel(timer_id id);
+
+  // Runs the callbacks of the timers due by now, which may schedule and
+  // cancel timers.
+  void advance(clock::time_point now);
+
+  size_t size() const { return slot_of_.size(); }
+  clock::duration tick() const { return tick_; }
+
+ private:
+  struct timer {
+    timer_id id;
+    int64_t tick;
+    std::function<void()> cb;
+  };
+
+  int64_t tick_of(clock::time_point at) const;
+  std::vector<timer> take_due(size_t slot, int64_t tick);
+
+  const clock::time_point start_;
+  const clock::duration tick_;
+  std::vector<std::vector<timer>> slots_;
+  std::unordered_map<timer_id, size_t> slot_of_{};
+  int64_t current_{0};  // Last tick advanced to
+  timer_id next_id_{1};
+};
+
+}  // namespace dolbyio::comms::sample
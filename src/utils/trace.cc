@@ -0,0 +1,322 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/trace.h"
+#include "utils/json.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace dolbyio::comms::sample::trace {
+
+namespace {
+
+constexpr std::chrono::milliseconds flush_interval{200};
+
+struct event {
+  char phase;
+  const char* category;
+  // Literals, the name of the event is the prefix followed by the name
+  // unless it has been copied
+  const char* prefix;
+  const char* name;
+  std::string copied_name;
+  int64_t ts_us;
+  int64_t dur_us;
+  uint64_t tid;
+  std::string args;
+};
+
+uint64_t current_tid() {
+#if defined(__linux__)
+  thread_local const uint64_t tid = syscall(SYS_gettid);
+#else
+  thread_local const uint64_t tid =
+      std::hash<std::thread::id>{}(std::this_thread::get_id());
+#endif
+  return tid;
+}
+
+uint64_t current_pid() {
+#if defined(__linux__)
+  return getpid();
+#else
+  return 1;
+#endif
+}
+
+// Events of a thread, collected by the writer thread. Its lock is only
+// contended by the collection, and its storage is reused afterwards, so the
+// threads recording do not allocate nor wait for each other.
+struct thread_buffer {
+  thread_buffer();
+  ~thread_buffer();
+
+  std::mutex lock{};
+  std::vector<event> events{};
+};
+
+class writer {
+ public:
+  void configure(const std::string& path) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!path_.empty())
+      return;  // Bots hosted in one process all pass the switch
+    path_ = path;
+    epoch_ = clock::now();
+    enabled_ = true;
+  }
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  int64_t since_epoch_us(clock::time_point at) const {
+    return to_us(at - epoch_);
+  }
+
+  void record(event&& ev) {
+    thread_local thread_buffer buffer;
+    std::lock_guard<std::mutex> lock(buffer.lock);
+    buffer.events.push_back(std::move(ev));
+  }
+
+  void attach(thread_buffer* buffer) {
+    std::lock_guard<std::mutex> lock(lock_);
+    buffers_.push_back(buffer);
+  }
+
+  // The events of a thread which exits are written with the others.
+  void detach(thread_buffer* buffer) {
+    std::lock_guard<std::mutex> lock(lock_);
+    buffers_.erase(std::find(buffers_.begin(), buffers_.end(), buffer));
+    std::lock_guard<std::mutex> buffer_lock(buffer->lock);
+    std::move(buffer->events.begin(), buffer->events.end(),
+              std::back_inserter(detached_));
+  }
+
+  void start() {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!enabled_ || file_)
+      return;
+    file_ = fopen(path_.c_str(), "w");
+    if (!file_) {
+      std::cerr << "Failed to open the trace file " << path_ << std::endl;
+      enabled_ = false;
+      std::vector<event> dropped;
+      collect(dropped);
+      return;
+    }
+    pid_ = current_pid();
+    fputs("[", file_);
+    thread_ = std::thread([this]() { run(); });
+  }
+
+  void stop() {
+    {
+      // The threads still running record nothing from now on
+      std::lock_guard<std::mutex> lock(lock_);
+      if (!file_)
+        return;
+      enabled_ = false;
+      quit_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+    std::vector<event> rest;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      collect(rest);
+    }
+    write(rest);
+    fputs("\n]\n", file_);
+    fclose(file_);
+    file_ = nullptr;
+  }
+
+ private:
+  void run() {
+    std::vector<event> batch;
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!quit_) {
+      cond_.wait_for(lock, flush_interval, [this]() { return quit_; });
+      collect(batch);
+      lock.unlock();
+      write(batch);
+      batch.clear();
+      lock.lock();
+    }
+  }
+
+  // Under lock_, takes the events recorded so far.
+  void collect(std::vector<event>& batch) {
+    std::move(detached_.begin(), detached_.end(), std::back_inserter(batch));
+    detached_.clear();
+    for (auto* buffer : buffers_) {
+      std::lock_guard<std::mutex> lock(buffer->lock);
+      std::move(buffer->events.begin(), buffer->events.end(),
+                std::back_inserter(batch));
+      buffer->events.clear();
+    }
+  }
+
+  void write(const std::vector<event>& events) {
+    std::ostringstream out;
+    for (const auto& ev : events) {
+      const auto name = ev.copied_name.empty()
+                            ? std::string(ev.prefix) + ev.name
+                            : ev.copied_name;
+      out << (first_ ? "\n" : ",\n") << "{\"ph\": \"" << ev.phase
+          << "\", \"cat\": \"" << ev.category
+          << "\", \"name\": " << json_quote(name) << ", \"ts\": "
+          << ev.ts_us << ", \"pid\": " << pid_ << ", \"tid\": " << ev.tid;
+      if (ev.phase == 'X')
+        out << ", \"dur\": " << ev.dur_us;
+      if (ev.phase == 'i')
+        out << ", \"s\": \"t\"";
+      out << ", \"args\": {" << ev.args << "}}";
+      first_ = false;
+    }
+    const auto str = out.str();
+    fwrite(str.data(), 1, str.size(), file_);
+    fflush(file_);
+  }
+
+  std::atomic<bool> enabled_{false};
+  std::mutex lock_{};
+  std::condition_variable cond_{};
+  std::string path_{};
+  clock::time_point epoch_{};
+  std::vector<thread_buffer*> buffers_{};
+  std::vector<event> detached_{};
+  FILE* file_{nullptr};
+  uint64_t pid_{0};
+  bool first_{true};
+  bool quit_{false};
+  std::thread thread_{};
+};
+
+writer& get_writer() {
+  static writer instance;
+  return instance;
+}
+
+thread_buffer::thread_buffer() {
+  get_writer().attach(this);
+}
+
+thread_buffer::~thread_buffer() {
+  get_writer().detach(this);
+}
+
+void record_complete(const char* category,
+                     const char* prefix,
+                     const char* name,
+                     std::string copied_name,
+                     clock::time_point begin,
+                     const std::string& args) {
+  auto& w = get_writer();
+  const auto begin_us = w.since_epoch_us(begin);
+  w.record({'X', category, prefix, name, std::move(copied_name), begin_us,
+            w.since_epoch_us(clock::now()) - begin_us, current_tid(), args});
+}
+
+}  // namespace
+
+void configure(const std::string& path) {
+  get_writer().configure(path);
+}
+
+bool enabled() {
+  return get_writer().enabled();
+}
+
+void start() {
+  get_writer().start();
+}
+
+void stop() {
+  get_writer().stop();
+}
+
+void set_thread_name(const std::string& name) {
+  if (!enabled())
+    return;
+  get_writer().record({'M', "__metadata", "", "thread_name", {}, 0, 0,
+                       current_tid(), "\"name\": " + json_quote(name)});
+}
+
+void instant(const char* category, const char* name, const std::string& args) {
+  if (!enabled())
+    return;
+  auto& w = get_writer();
+  w.record({'i', category, "", name, {}, w.since_epoch_us(clock::now()), 0,
+            current_tid(), args});
+}
+
+void complete(const char* category,
+              const char* name,
+              clock::time_point begin,
+              const std::string& args) {
+  if (enabled())
+    record_complete(category, "", name, {}, begin, args);
+}
+
+scope::scope(const char* category, const char* name)
+    : category_(category), name_(name) {
+  if (enabled())
+    begin_ = clock::now();
+}
+
+scope::scope(const char* category, const std::string& name)
+    : category_(category), name_("") {
+  if (!enabled())
+    return;
+  copied_name_ = name;
+  begin_ = clock::now();
+}
+
+scope::~scope() {
+  if (begin_ != clock::time_point{} && enabled())
+    record_complete(category_, "", name_, std::move(copied_name_), begin_,
+                    {});
+}
+
+lock_guard::lock_guard(std::mutex& mutex, const char* name)
+    : lock_(mutex, std::defer_lock), name_(name) {
+  if (!enabled()) {
+    lock_.lock();
+    return;
+  }
+  if (!lock_.try_lock()) {
+    const auto begin = clock::now();
+    lock_.lock();
+    if (enabled())
+      record_complete("lock", "wait ", name_, {}, begin, {});
+  }
+  acquired_ = clock::now();
+}
+
+lock_guard::~lock_guard() {
+  if (acquired_ != clock::time_point{} && enabled())
+    record_complete("lock", "hold ", name_, {}, acquired_, {});
+}
+
+}  // namespace dolbyio::comms::sample::trace
@@ -0,0 +1,92 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Process wide tracing of the media pipeline (--trace-file), written in the
+ * Trace Event Format which chrome://tracing and ui.perfetto.dev load. Every
+ * thread gets its own track. Recording is a cheap check when tracing is not
+ * enabled; when enabled the events are buffered in memory, by every thread in
+ * a buffer of its own, and written to the file by a background thread. The
+ * names are string literals, which the events only point to.
+ */
+namespace trace {
+using clock = std::chrono::steady_clock;
+
+// Enables the tracing. The events recorded before start() are kept in
+// memory, so that the process can still daemonize.
+void configure(const std::string& path);
+bool enabled();
+
+// Open the file and start writing the events, stop() flushes and terminates
+// the file.
+void start();
+void stop();
+
+void set_thread_name(const std::string& name);
+
+inline int64_t to_us(clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+// The args are the members of a JSON object, e.g. "\"state\": 2".
+void instant(const char* category,
+             const char* name,
+             const std::string& args = {});
+void complete(const char* category,
+              const char* name,
+              clock::time_point begin,
+              const std::string& args = {});
+
+// Records a complete event for the lifetime of the scope.
+class scope {
+ public:
+  scope(const char* category, const char* name);
+  // Copies the name, when tracing, for the names which are not literals,
+  // e.g. commands.
+  scope(const char* category, const std::string& name);
+  ~scope();
+
+  scope(const scope&) = delete;
+  scope& operator=(const scope&) = delete;
+
+ private:
+  const char* category_;
+  const char* name_;
+  std::string copied_name_{};
+  clock::time_point begin_{};
+};
+
+// std::lock_guard recording how long the lock was waited for, when it was
+// contended, and how long it was held.
+class lock_guard {
+ public:
+  lock_guard(std::mutex& mutex, const char* name);
+  ~lock_guard();
+
+  lock_guard(const lock_guard&) = delete;
+  lock_guard& operator=(const lock_guard&) = delete;
+
+ private:
+  std::unique_lock<std::mutex> lock_;
+  const char* name_;
+  clock::time_point acquired_{};
+};
+}  // namespace trace
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,133 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/trajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// Below these a move is not worth an update of the scene
+constexpr double min_distance = 0.01;
+constexpr double min_rotation = 0.5;
+
+trajectory::easing parse_easing(const std::string& name) {
+  if (name == "linear")
+    return trajectory::easing::linear;
+  if (name == "in")
+    return trajectory::easing::in;
+  if (name == "out")
+    return trajectory::easing::out;
+  if (name == "in_out")
+    return trajectory::easing::in_out;
+  if (name == "step")
+    return trajectory::easing::step;
+  throw std::runtime_error("Unknown path easing: " + name);
+}
+
+double ease(trajectory::easing easing, double progress) {
+  switch (easing) {
+    case trajectory::easing::in:
+      return progress * progress;
+    case trajectory::easing::out:
+      return 1 - (1 - progress) * (1 - progress);
+    case trajectory::easing::in_out:
+      return progress * progress * (3 - 2 * progress);
+    case trajectory::easing::step:
+      return progress < 1 ? 0 : 1;
+    case trajectory::easing::linear:
+      break;
+  }
+  return progress;
+}
+
+double lerp(double from, double to, double progress) {
+  return from + (to - from) * progress;
+}
+
+// Turns the shortest way, the result is not normalized
+double lerp_angle(double from, double to, double progress) {
+  const double delta = std::remainder(to - from, 360.0);
+  return from + delta * progress;
+}
+
+}  // namespace
+
+bool spatial_placement::operator==(const spatial_placement& other) const {
+  return x == other.x && y == other.y && z == other.z && r == other.r;
+}
+
+bool spatial_placement::moved_from(const spatial_placement& other) const {
+  return std::abs(x - other.x) >= min_distance ||
+         std::abs(y - other.y) >= min_distance ||
+         std::abs(z - other.z) >= min_distance;
+}
+
+bool spatial_placement::turned_from(const spatial_placement& other) const {
+  return std::abs(std::remainder(r - other.r, 360.0)) >= min_rotation;
+}
+
+bool trajectory::waypoint::operator==(const waypoint& other) const {
+  return t == other.t && placement == other.placement && ease == other.ease;
+}
+
+trajectory trajectory::from_json(const json_value& path,
+                                 const spatial_placement& start,
+                                 bool loop) {
+  trajectory traj;
+  traj.loop_ = loop;
+  spatial_placement previous = start;
+  for (const auto& point : path.as_array()) {
+    const double previous_t =
+        traj.waypoints_.empty() ? 0 : traj.waypoints_.back().t;
+    waypoint wp;
+    wp.t = point.number_or("t", previous_t);
+    wp.placement.x = point.number_or("x", previous.x);
+    wp.placement.y = point.number_or("y", previous.y);
+    wp.placement.z = point.number_or("z", previous.z);
+    wp.placement.r = point.number_or("r", previous.r);
+    wp.ease = parse_easing(point.string_or("ease", "linear"));
+    if (wp.t < previous_t)
+      throw std::runtime_error("Path waypoints must be in time order");
+    previous = wp.placement;
+    traj.waypoints_.push_back(wp);
+  }
+  if (traj.waypoints_.empty())
+    throw std::runtime_error("Empty path");
+  return traj;
+}
+
+spatial_placement trajectory::at(double seconds) const {
+  const double duration = waypoints_.back().t;
+  if (loop_ && duration > 0)
+    seconds = std::fmod(std::max(seconds, 0.0), duration);
+
+  // The first waypoint past the time
+  auto next = std::upper_bound(
+      waypoints_.begin(), waypoints_.end(), seconds,
+      [](double t, const waypoint& wp) { return t < wp.t; });
+  if (next == waypoints_.begin())
+    return next->placement;
+  if (next == waypoints_.end())
+    return waypoints_.back().placement;
+
+  const auto& prev = *std::prev(next);
+  const auto& from = prev.placement;
+  const auto& to = next->placement;
+  const double progress =
+      ease(next->ease, (seconds - prev.t) / (next->t - prev.t));
+  return {lerp(from.x, to.x, progress), lerp(from.y, to.y, progress),
+          lerp(from.z, to.z, progress), lerp_angle(from.r, to.r, progress)};
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,72 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/json.h"
+
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+// Position and yaw rotation in degrees of a bot in the spatial scene.
+struct spatial_placement {
+  double x{}, y{}, z{}, r{};
+
+  bool operator==(const spatial_placement& other) const;
+  bool operator!=(const spatial_placement& other) const {
+    return !(*this == other);
+  }
+  // Whether the position or the rotation changed enough to be heard.
+  bool moved_from(const spatial_placement& other) const;
+  bool turned_from(const spatial_placement& other) const;
+};
+
+/**
+ * Keyframed path of a bot in the spatial scene, the "path" of its def.json
+ * entry, played once or looped ("path_loop": true):
+ *
+ *   "path": [{"t": 0}, {"t": 4, "x": 10, "r": 90, "ease": "in_out"}]
+ *
+ * A waypoint gives the placement of the bot "t" seconds after the start of
+ * the path, its members default to the previous waypoint, and the first one
+ * to the placement of the entry. The placement moves from a waypoint to the
+ * next one with the easing of the next one, "linear" (default), "in",
+ * "out", "in_out" or "step", and the yaw rotation turns the shortest way.
+ */
+class trajectory {
+ public:
+  enum class easing { linear, in, out, in_out, step };
+
+  struct waypoint {
+    double t{};
+    spatial_placement placement{};
+    easing ease{easing::linear};
+
+    bool operator==(const waypoint& other) const;
+  };
+
+  static trajectory from_json(const json_value& path,
+                              const spatial_placement& start,
+                              bool loop);
+
+  // Placement at the time since the start of the path.
+  spatial_placement at(double seconds) const;
+
+  bool operator==(const trajectory& other) const {
+    return loop_ == other.loop_ && waypoints_ == other.waypoints_;
+  }
+  bool operator!=(const trajectory& other) const { return !(*this == other); }
+
+ private:
+  std::vector<waypoint> waypoints_{};
+  bool loop_{false};
+};
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,198 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "wrappers/bot.h"
+#include "utils/async_combinators.h"
+#include "utils/deadline.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+
+#if defined(__linux__)
+#include "linux/metrics_server.h"
+#endif
+
+#include <iostream>
+
+namespace dolbyio::comms::sample {
+
+bot::bot()
+    : sdk_wrap_(std::make_shared<sdk_wrapper>()),
+      media_io_wrap_(
+          std::make_shared<media_io_wrapper>(sdk_wrap_->get_params())) {
+  // Register the wrappers with command handler
+  command_handler_.add_interactor(sdk_wrap_);
+  command_handler_.add_interactor(media_io_wrap_);
+
+  // Consumed by the bot_host before the bots parse the command line, it is
+  // registered here so that it shows up in the help.
+  command_handler_.add_command_line_switch(
+      {"--conversation", "-conversation"},
+      "<folder|def.json>\n\tHost a bot for every entry of the conversation "
+      "definition in this process. The other switches are common to all of "
+      "the bots.",
+      [](const std::string&) {});
+  command_handler_.add_command_line_switch(
+      {"--trace-file", "-trace-file"},
+      "<file>\n\tWrite a trace of the media pipeline in the Trace Event "
+      "Format, to be opened in chrome://tracing or ui.perfetto.dev. Shared "
+      "by all of the bots of the process.",
+      [](const std::string& arg) { trace::configure(arg); });
+#if defined(__linux__)
+  command_handler_.add_command_line_switch(
+      {"--metrics-socket", "-metrics-socket"},
+      "<path>\n\tServe the metrics of the bots of the process in the "
+      "Prometheus text format over HTTP on this Unix socket.",
+      [](const std::string& arg) { metrics_server::configure(arg); });
+#endif
+}
+
+bot::~bot() {
+  // Detach the wrappers while the SDK instance is still alive
+  command_handler_.set_sdk(nullptr);
+}
+
+void bot::parse_command_line(const std::vector<std::string>& args) {
+  command_handler_.parse_command_line(args);
+  tracer_.set_output(get_params().log_dir, name());
+  media_io_wrap_->set_first_frame_cb([this]() { tracer_.first_frame(); });
+  media_io_wrap_->set_metrics(
+      std::make_shared<metrics::injection_metrics>(name()));
+}
+
+void bot::create_sdk() {
+  // Create the SDK passing in the token and a refresh token callback
+  sdk_ = dolbyio::comms::sdk::create(
+      get_params().access_token,
+      [](std::unique_ptr<dolbyio::comms::refresh_token>&&) {
+        // This sample currently does not provide any token fetching mechanism
+        // It is the responsibilty of the application to provide a lambda here
+        // which can fetch a token when it is invoked by the SDK and then
+        // provide this token to the dolbio::comms::refresh_token interface.
+      });
+
+  // Set the SDK instance on the wrappers
+  command_handler_.set_sdk(sdk_.get());
+  tracer_.stage("create_sdk");
+
+  auto& state = metrics::registry::instance().get_gauge(
+      "conference_state",
+      "Conference status of the bot (value of the SDK conference_status).",
+      {{"bot", name()}});
+  sdk_->conference()
+      .add_event_handler(
+          [&state](const dolbyio::comms::conference_status_updated& status) {
+            state.set(static_cast<int>(status.status));
+          })
+      .on_error([](auto&&) {});
+}
+
+async_result<void> bot::join() {
+  auto sdk_wrap = sdk_wrap_;
+  auto media_io_wrap = media_io_wrap_;
+  // The steps run on the SDK thread, possibly after the bot was removed
+  std::weak_ptr<bot> weak = weak_from_this();
+  auto stage = [weak](const char* name) {
+    if (auto self = weak.lock())
+      self->tracer_.stage(name);
+  };
+  // Set once the join timed out, and the host gave up on the bot
+  auto abandoned = std::make_shared<std::atomic<bool>>(false);
+  auto joining =
+      media_io_wrap->initialize_injection()
+          .then([stage, sdk_wrap]() {
+            stage("initialize_injection");
+            return sdk_wrap->open_session();
+          })
+          .then([stage, sdk_wrap]() {
+            stage("open_session");
+            return sdk_wrap->create_and_or_join_conference();
+          })
+          .then([stage, sdk_wrap]() -> dolbyio::comms::async_result<void> {
+            stage("join_conference");
+            // The following operations can happen concurrently, but their
+            // combined result must be waited for before start capture.
+            return when_all(sdk_wrap->apply_spatial_audio_configuration(),
+                            sdk_wrap->set_audio_processing());
+          })
+          .then([weak, abandoned, sdk_wrap, media_io_wrap,
+                 leaving{leaving_}]() {
+            // The SDK is gone with the bot
+            auto self = weak.lock();
+            if (!self)
+              return;
+            if (*abandoned) {
+              std::cerr << "Bot " << sdk_wrap->get_params().user_name
+                        << " joined past its timeout, leaving" << std::endl;
+              *leaving = true;
+              sdk_wrap->leave_conference()
+                  .then([sdk_wrap]() { return sdk_wrap->close_session(); })
+                  .on_error([](auto&&) {});
+              return;
+            }
+            self->tracer_.stage("spatial_and_audio_processing");
+            auto media = sdk_wrap->get_params().conf;
+            if (self->capture_held_)
+              media_io_wrap->set_scheduled_capture(false);
+            else
+              media_io_wrap->set_initial_capture(media.join_with_audio(),
+                                                 media.join_with_video());
+            self->tracer_.stage("set_initial_capture");
+            self->joined_ = true;
+            self->tracer_.joined(media_io_wrap->injecting());
+          });
+  return with_deadline(std::move(joining), get_params().join_timeout,
+                       "Joining the conference",
+                       [abandoned]() { *abandoned = true; });
+}
+
+async_result<void> bot::leave() {
+  auto sdk_wrap = sdk_wrap_;
+  joined_ = false;
+  *leaving_ = true;
+  return sdk_wrap->leave_conference().then(
+      [sdk_wrap]() { return sdk_wrap->close_session(); });
+}
+
+void bot::on_conference_ended(std::function<void()>&& cb) {
+  sdk_->conference()
+      .add_event_handler(
+          [cb{std::move(cb)}, leaving{leaving_}](
+              const dolbyio::comms::conference_status_updated& status) {
+            if (status.is_ended() && !*leaving)
+              cb();
+          })
+      .on_error([](auto&&) {});
+}
+
+async_result<void> bot::update_spatial_placement(
+    const std::optional<dolbyio::comms::spatial_position>& position,
+    std::optional<double> yaw) {
+  std::optional<dolbyio::comms::spatial_direction> direction;
+  if (yaw)
+    direction.emplace(0, *yaw, 0);
+  return sdk_wrap_->update_spatial_placement(position, direction);
+}
+
+media_io_wrapper::loaded_file bot::load_media(const std::string& file) {
+  return media_io_wrap_->load_file(file);
+}
+
+void bot::play_media(media_io_wrapper::loaded_file&& media) {
+  media_io_wrap_->play_loaded(false, std::move(media));
+}
+
+void bot::set_capture(bool enable) {
+  media_io_wrap_->set_scheduled_capture(enable);
+}
+
+void bot::set_timeline(std::chrono::steady_clock::time_point origin) {
+  media_io_wrap_->set_timeline(origin);
+}
+
+};  // namespace dolbyio::comms::sample
@@ -0,0 +1,87 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/commands_handler.h"
+#include "utils/startup_tracer.h"
+#include "wrappers/mediaio.h"
+#include "wrappers/sdk.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * A single injection bot: one SDK instance together with the SDK and Media IO
+ * wrappers configured from its own set of command line switches. Owned by a
+ * shared_ptr, its asynchronous operations only hold on to a weak one.
+ */
+class bot : public std::enable_shared_from_this<bot> {
+ public:
+  bot();
+  ~bot();
+
+  commands_handler& get_commands_handler() { return command_handler_; }
+  const command_line::sdk& get_params() const {
+    return sdk_wrap_->get_params();
+  }
+  const std::string& name() const { return get_params().user_name; }
+  bool joined() const { return joined_; }
+
+  void parse_command_line(const std::vector<std::string>& args);
+
+  // Create the SDK instance for this bot and set it on the wrappers.
+  void create_sdk();
+
+  // Open the session, join the conference and start the injection, within
+  // the join timeout. A join completing after its timeout leaves the
+  // conference and closes the session again rather than injecting.
+  async_result<void> join();
+  async_result<void> leave();
+
+  // Not called for the end of the conference caused by leave().
+  void on_conference_ended(std::function<void()>&& cb);
+
+  // Changes made to a running bot, when its definition changes.
+  async_result<void> update_spatial_placement(
+      const std::optional<dolbyio::comms::spatial_position>& position,
+      std::optional<double> yaw);
+  // Decodes the new media of the bot, from any thread, for play_media() to
+  // play it from the thread of the host.
+  media_io_wrapper::loaded_file load_media(const std::string& file);
+  void play_media(media_io_wrapper::loaded_file&& media);
+  // Joins with the capture stopped, for set_capture() to start it later.
+  void hold_capture() { capture_held_ = true; }
+  void set_capture(bool enable);
+  // Plays the media on the timeline of the conversation from the origin.
+  void set_timeline(std::chrono::steady_clock::time_point origin);
+
+  startup_tracer& get_startup_tracer() { return tracer_; }
+
+ private:
+  // Declare the SDK pointer first so it outlives the wrappers
+  std::unique_ptr<dolbyio::comms::sdk> sdk_{};
+  commands_handler command_handler_{};
+  std::shared_ptr<sdk_wrapper> sdk_wrap_{};
+  std::shared_ptr<media_io_wrapper> media_io_wrap_{};
+  std::atomic<bool> joined_{false};
+  bool capture_held_{false};
+  std::shared_ptr<std::atomic<bool>> leaving_{
+      std::make_shared<std::atomic<bool>>(false)};
+  startup_tracer tracer_{};
+};
+
+};  // namespace dolbyio::comms::sample
@@ -0,0 +1,534 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "wrappers/bot_host.h"
+#include "utils/deadline.h"
+#include "utils/trace.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <future>
+#include <iostream>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+std::string describe(const std::exception_ptr& err) {
+  try {
+    std::rethrow_exception(err);
+  } catch (const std::exception& ex) {
+    return ex.what();
+  } catch (...) {
+    return "unknown error";
+  }
+}
+
+void log_failure(const std::string& what,
+                 const std::string& name,
+                 const std::exception_ptr& err) {
+  std::cerr << "Bot " << name << " failed to " << what << ": "
+            << describe(err) << std::endl;
+}
+
+// Period of the moves of the bots along their paths
+constexpr std::chrono::milliseconds path_tick{50};
+
+// Joins the bots concurrently, returns the number of them which joined and
+// the first failure.
+std::pair<size_t, std::exception_ptr> join_bots(const std::vector<bot*>& bots) {
+  // Start all of the joins first so that they run concurrently, then wait
+  // for every one of them.
+  std::vector<std::future<void>> joins;
+  for (auto* b : bots) {
+    auto promise = std::make_shared<std::promise<void>>();
+    joins.push_back(promise->get_future());
+    b->join()
+        .then([promise]() { promise->set_value(); })
+        .on_error([promise, name{b->name()},
+                   weak{b->weak_from_this()}](auto&& ex) {
+          log_failure("join", name, ex);
+          if (auto failed = weak.lock())
+            failed->get_startup_tracer().failed(describe(ex));
+          promise->set_exception(std::move(ex));
+        });
+  }
+
+  std::exception_ptr first_failure{};
+  size_t joined = 0;
+  for (auto& join : joins) {
+    try {
+      join.get();
+      ++joined;
+    } catch (...) {
+      if (!first_failure)
+        first_failure = std::current_exception();
+    }
+  }
+  return {joined, first_failure};
+}
+
+void leave_bots(const std::vector<bot*>& bots) {
+  std::vector<std::future<void>> leaves;
+  for (auto* b : bots) {
+    if (!b->joined())
+      continue;
+    auto promise = std::make_shared<std::promise<void>>();
+    leaves.push_back(promise->get_future());
+    with_deadline(b->leave(), b->get_params().leave_timeout,
+                  "Leaving the conference")
+        .then([promise]() { promise->set_value(); })
+        .on_error([promise, name{b->name()}](auto&& ex) {
+          log_failure("leave", name, ex);
+          promise->set_value();
+        });
+  }
+  for (auto& leave : leaves)
+    leave.get();
+}
+
+std::vector<bot*> pointers(const std::vector<std::shared_ptr<bot>>& bots) {
+  std::vector<bot*> ptrs;
+  for (const auto& b : bots)
+    ptrs.push_back(b.get());
+  return ptrs;
+}
+}  // namespace
+
+std::optional<std::string> bot_host::take_conversation_switch(
+    std::vector<std::string>& args) {
+  for (auto it = args.begin(); it != args.end(); ++it) {
+    if (*it != "--conversation" && *it != "-conversation")
+      continue;
+    if (std::next(it) == args.end())
+      throw std::runtime_error("No value provided for option: " + *it);
+    std::string path = *std::next(it);
+    args.erase(it, it + 2);
+    return path;
+  }
+  return std::nullopt;
+}
+
+void bot_host::add_interactive_command(const std::string& cmd,
+                                       const std::string& desc,
+                                       action act) {
+  if (!bots_.empty())
+    throw std::runtime_error("Bots have already been added");
+  interactive_commands_.push_back({cmd, desc, std::move(act)});
+}
+
+void bot_host::add_bot(const std::vector<std::string>& args) {
+  auto new_bot = std::make_shared<bot>();
+  for (const auto& ic : interactive_commands_)
+    new_bot->get_commands_handler().add_interactive_command(ic.cmd, ic.desc,
+                                                            ic.act);
+  new_bot->parse_command_line(args);
+  // Started by the timeline
+  if (synchronized_)
+    new_bot->hold_capture();
+  bots_.push_back(std::move(new_bot));
+}
+
+void bot_host::add_conversation(const conversation& conv,
+                                const std::vector<std::string>& common_args) {
+  conversation_ = conv;
+  common_args_ = common_args;
+  for (const auto& def : conv.bots)
+    add_conversation_bot(def, conv.folder);
+}
+
+void bot_host::add_conversation_bot(const bot_definition& def,
+                                    const std::string& folder) {
+  auto args = common_args_;
+  auto bot_args = def.command_line_args(folder);
+  args.insert(args.end(), bot_args.begin(), bot_args.end());
+  add_bot(args);
+  // Started by the timeline of the conversation
+  if (def.start)
+    bots_.back()->hold_capture();
+}
+
+std::optional<std::string> bot_host::conversation_file() const {
+  if (!conversation_)
+    return std::nullopt;
+  return conversation_->definition_file;
+}
+
+void bot_host::reload_conversation() {
+  if (!conversation_)
+    return;
+  const auto& file = conversation_->definition_file;
+  conversation updated;
+  try {
+    updated = conversation::load(file);
+  } catch (const std::exception& ex) {
+    std::cerr << "Keeping the running bots, failed to reload " << file << ": "
+              << ex.what() << std::endl;
+    return;
+  }
+  const auto delta = conversation_delta::between(*conversation_, updated);
+  if (delta.empty())
+    return;
+  std::cerr << "Reloaded " << file << ": " << delta.added.size()
+            << " bot(s) added, " << delta.removed.size() << " removed, "
+            << delta.moved.size() << " moved, " << delta.media_changed.size()
+            << " with new media" << std::endl;
+
+  // Only the tasks which have completed are dropped, none is waited for
+  background_.erase(
+      std::remove_if(background_.begin(), background_.end(),
+                     [](const std::future<void>& task) {
+                       return task.wait_for(std::chrono::seconds(0)) ==
+                              std::future_status::ready;
+                     }),
+      background_.end());
+
+  // Out of the host right away, the bots leave in the background
+  for (const auto& name : delta.removed) {
+    scene_.forget(name);
+    cancel_capture(name);
+    // Not added again if it was waiting for its predecessor
+    if (auto it = retiring_.find(name); it != retiring_.end())
+      it->second = false;
+    auto it = std::find_if(
+        bots_.begin(), bots_.end(),
+        [&name](const std::shared_ptr<bot>& b) { return b->name() == name; });
+    if (it == bots_.end())
+      continue;
+    auto removed = std::move(*it);
+    bots_.erase(it);
+    retire(std::move(removed));
+  }
+
+  for (const auto& def : delta.moved) {
+    // The bots with a path are moved on the next tick
+    auto* b = find_bot(def.name);
+    if (b && b->joined() && !def.path)
+      scene_.place(*b, def.placement());
+  }
+  scene_.flush(std::chrono::steady_clock::now());
+  for (const auto& def : delta.media_changed) {
+    for (const auto& b : bots_)
+      if (b->name() == def.name)
+        swap_media(
+            b, (std::filesystem::path(updated.folder) / def.media).string(),
+            def.media);
+  }
+
+  for (const auto& def : delta.added) {
+    // Its predecessor of the same name must have left the conference first
+    if (auto it = retiring_.find(def.name); it != retiring_.end())
+      it->second = true;
+    else
+      add_reloaded_bot(def, updated.folder);
+  }
+  conversation_ = std::move(updated);
+
+  if (!timeline_)
+    return;
+  // The rescheduled bots may have lost their start or stop
+  for (const auto& def : delta.rescheduled) {
+    if (auto* b = find_bot(def.name); b && b->joined())
+      schedule_capture(*b, def.start, def.stop);
+  }
+}
+
+void bot_host::retire(std::shared_ptr<bot> b) {
+  retiring_.emplace(b->name(), false);
+  if (!b->joined()) {
+    tear_down(std::move(b));
+    return;
+  }
+  // Whichever of the completions runs hands the bot back to the thread of
+  // the host, so that the SDK is not destroyed on one of its own threads
+  auto holder = std::make_shared<std::shared_ptr<bot>>(std::move(b));
+  auto done = [this, post{post_}, holder]() {
+    post([this, left{std::move(*holder)}]() mutable {
+      tear_down(std::move(left));
+    });
+  };
+  auto& leaving = **holder;
+  with_deadline(leaving.leave(), leaving.get_params().leave_timeout,
+                "Leaving the conference")
+      .then(done)
+      .on_error([done, name{leaving.name()}](auto&& ex) {
+        log_failure("leave", name, ex);
+        done();
+      });
+}
+
+void bot_host::tear_down(std::shared_ptr<bot> b) {
+  // Destroying the SDK of a bot which has not left waits for it to leave
+  background_.push_back(std::async(
+      std::launch::async, [this, post{post_}, b{std::move(b)}]() mutable {
+        const auto name = b->name();
+        b.reset();
+        post([this, name]() { retired(name); });
+      }));
+}
+
+void bot_host::retired(const std::string& name) {
+  auto it = retiring_.find(name);
+  if (it == retiring_.end())
+    return;
+  const bool add_again = it->second;
+  retiring_.erase(it);
+  if (!add_again || !conversation_)
+    return;
+  // As defined by now, it may have changed while its predecessor left
+  for (const auto& def : conversation_->bots)
+    if (def.name == name)
+      add_reloaded_bot(def, conversation_->folder);
+}
+
+void bot_host::add_reloaded_bot(const bot_definition& def,
+                                const std::string& folder) {
+  const size_t count = bots_.size();
+  try {
+    add_conversation_bot(def, folder);
+    bots_.back()->create_sdk();
+  } catch (...) {
+    log_failure("start", def.name, std::current_exception());
+    bots_.resize(count);
+    return;
+  }
+  if (conference_ended_)
+    bots_.back()->on_conference_ended(action{conference_ended_});
+  join_added(bots_.back(), def);
+}
+
+void bot_host::join_added(const std::shared_ptr<bot>& b,
+                          const bot_definition& def) {
+  b->join()
+      .then([this, post{post_}, def]() {
+        post([this, def]() {
+          // Removed again meanwhile, or its capture scheduled already
+          auto* b = find_bot(def.name);
+          if (!b || !b->joined() || !timeline_)
+            return;
+          if (def.start || def.stop || synchronized_)
+            schedule_capture(*b, def.start, def.stop);
+        });
+      })
+      .on_error([name{b->name()}, weak{std::weak_ptr<bot>(b)}](auto&& ex) {
+        log_failure("join", name, ex);
+        if (auto failed = weak.lock())
+          failed->get_startup_tracer().failed(describe(ex));
+      });
+}
+
+void bot_host::swap_media(const std::shared_ptr<bot>& b,
+                          const std::string& file,
+                          const std::string& media) {
+  // Loading the audio decodes the whole file away from the thread of the
+  // host, which then plays it like any of the commands of the bot
+  background_.push_back(std::async(
+      std::launch::async, [this, weak{std::weak_ptr<bot>(b)}, name{b->name()},
+                           file, media, post{post_}]() {
+        auto loaded = std::make_shared<media_io_wrapper::loaded_file>();
+        try {
+          if (auto loading = weak.lock())
+            *loaded = loading->load_media(file);
+          else
+            return;
+        } catch (...) {
+          log_failure("load " + media, name, std::current_exception());
+          return;
+        }
+        post([this, weak, name, media, loaded]() {
+          // Unless the bot was removed while its media was loading, found
+          // without a reference which would keep it on this thread
+          auto it = std::find_if(bots_.begin(), bots_.end(),
+                                 [&weak](const std::shared_ptr<bot>& b) {
+                                   return !weak.owner_before(b) &&
+                                          !b.owner_before(weak);
+                                 });
+          if (it == bots_.end())
+            return;
+          try {
+            (*it)->play_media(std::move(*loaded));
+          } catch (...) {
+            log_failure("play " + media, name, std::current_exception());
+          }
+        });
+      }));
+}
+
+const command_line::sdk& bot_host::get_params() const {
+  if (bots_.empty())
+    throw std::runtime_error("No bots have been added");
+  return bots_.front()->get_params();
+}
+
+void bot_host::create_sdks() {
+  for (auto& b : bots_)
+    b->create_sdk();
+}
+
+void bot_host::join_all() {
+  auto [joined, first_failure] = join_bots(pointers(bots_));
+  if (!joined && first_failure)
+    std::rethrow_exception(first_failure);
+}
+
+void bot_host::leave_all() {
+  leave_bots(pointers(bots_));
+}
+
+void bot_host::on_conference_ended(action cb) {
+  // All of the bots are in the same conference, whichever notices the end of
+  // the conference first triggers the callback.
+  for (auto& b : bots_)
+    b->on_conference_ended(action{cb});
+  conference_ended_ = std::move(cb);
+}
+
+void bot_host::start_conversation(
+    std::chrono::steady_clock::time_point epoch) {
+  epoch_ = epoch;
+  // From now on, as an epoch agreed with other processes may be ahead
+  timeline_.emplace(std::min(epoch, std::chrono::steady_clock::now()),
+                    timeline_tick);
+  if (!conversation_) {
+    for (auto& b : bots_)
+      if (synchronized_ && b->joined())
+        schedule_capture(*b, std::nullopt, std::nullopt);
+    return;
+  }
+  for (const auto& def : conversation_->bots) {
+    auto* b = find_bot(def.name);
+    if (b && b->joined() && (def.start || def.stop || synchronized_))
+      schedule_capture(*b, def.start, def.stop);
+  }
+  schedule_paths(epoch);
+}
+
+void bot_host::advance_timeline(std::chrono::steady_clock::time_point now) {
+  if (timeline_)
+    timeline_->advance(now);
+}
+
+void bot_host::schedule_paths(std::chrono::steady_clock::time_point at) {
+  timeline_->schedule(at, [this, at]() {
+    const auto now = std::chrono::steady_clock::now();
+    move_along_paths(now);
+    // Late ticks are not caught up with
+    auto next = at + path_tick;
+    if (next <= now)
+      next = now + path_tick;
+    schedule_paths(next);
+  });
+}
+
+void bot_host::move_along_paths(std::chrono::steady_clock::time_point now) {
+  const double seconds = std::chrono::duration<double>(now - *epoch_).count();
+  for (const auto& def : conversation_->bots) {
+    if (!def.path)
+      continue;
+    if (auto* b = find_bot(def.name); b && b->joined())
+      scene_.place(*b, def.path->at(seconds));
+  }
+  scene_.flush(now);
+}
+
+void bot_host::schedule_capture(bot& b,
+                                std::optional<double> start,
+                                std::optional<double> stop) {
+  cancel_capture(b.name());
+  auto at = [this](double offset) {
+    return *epoch_ + std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::duration<double>(offset));
+  };
+  // The audio of a synchronized bot is on the timeline from its start, its
+  // capture starts a tick early for the first frame to be on time.
+  std::chrono::milliseconds ahead{0};
+  if (synchronized_) {
+    start = start.value_or(0.0);
+    b.set_timeline(at(*start));
+    ahead = timeline_tick;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  const bool started = !start || at(*start) - ahead <= now;
+  const bool stopped = stop && at(*stop) <= now;
+  b.set_capture(started && !stopped);
+
+  auto set_capture = [this, name{b.name()}](bool enable) {
+    auto* b = find_bot(name);
+    if (!b || !b->joined())
+      return;
+    std::cerr << "Bot " << name << (enable ? " starts" : " stops")
+              << " injecting" << std::endl;
+    b->set_capture(enable);
+  };
+  auto& timers = capture_timers_[b.name()];
+  if (!started)
+    timers.push_back(timeline_->schedule(
+        at(*start) - ahead, [set_capture]() { set_capture(true); }));
+  if (stop && !stopped)
+    timers.push_back(timeline_->schedule(
+        at(*stop), [set_capture]() { set_capture(false); }));
+}
+
+void bot_host::cancel_capture(const std::string& name) {
+  auto it = capture_timers_.find(name);
+  if (it == capture_timers_.end())
+    return;
+  for (auto id : it->second)
+    timeline_->cancel(id);
+  capture_timers_.erase(it);
+}
+
+bot* bot_host::find_bot(const std::string& name) {
+  for (auto& b : bots_)
+    if (b->name() == name)
+      return b.get();
+  return nullptr;
+}
+
+void bot_host::print_interactive_options() const {
+  if (!bots_.empty())
+    bots_.front()->get_commands_handler().print_interactive_options();
+}
+
+std::optional<std::string> bot_host::handle_interactive_command(
+    const std::string& cmd,
+    const std::string& arg,
+    const std::string& bot_name) {
+  if (bots_.empty())
+    return "No bots hosted";
+  std::optional<std::string> error;
+  bool found = false;
+  for (auto& b : bots_) {
+    if (!bot_name.empty() && b->name() != bot_name)
+      continue;
+    found = true;
+    trace::scope scope("command", cmd);
+    auto bot_error =
+        b->get_commands_handler().handle_interactive_command(cmd, arg);
+    if (bot_error && !error)
+      error = std::move(bot_error);
+  }
+  if (!found)
+    return "No bot named " + bot_name;
+  return error;
+}
+
+std::optional<std::string> bot_host::handle_typed_command(
+    const std::string& cmd) {
+  std::optional<std::string> prompt;
+  if (!bots_.empty())
+    prompt = bots_.front()->get_commands_handler().argument_prompt(cmd);
+  std::string arg;
+  if (prompt) {
+    std::cout << *prompt << std::endl;
+    std::cin >> arg;
+  }
+  return handle_interactive_command(cmd, arg);
+}
+
+};  // namespace dolbyio::comms::sample
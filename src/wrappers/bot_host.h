@@ -0,0 +1,150 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/conversation.h"
+#include "utils/timer_wheel.h"
+#include "wrappers/bot.h"
+#include "wrappers/spatial_scene.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Hosts one or more bots inside of a single process. Either a single bot
+ * configured from the command line, or a bot for every entry of a
+ * conversation definition (--conversation), where the command line provides
+ * the switches common to all of the bots.
+ */
+class bot_host {
+  using action = std::function<void()>;
+
+ public:
+  // Removes the --conversation switch and its value from the arguments.
+  static std::optional<std::string> take_conversation_switch(
+      std::vector<std::string>& args);
+
+  // Interactive commands registered on every hosted bot, must be added
+  // before the bots.
+  void add_interactive_command(const std::string& cmd,
+                               const std::string& desc,
+                               action act);
+
+  void add_bot(const std::vector<std::string>& args);
+  void add_conversation(const conversation& conv,
+                        const std::vector<std::string>& common_args);
+  // Definition file of the hosted conversation, if any.
+  std::optional<std::string> conversation_file() const;
+  // Loads the definition of the hosted conversation again and applies the
+  // changes to the running bots: the bots which moved are moved in the
+  // spatial scene and the ones whose media changed play the new media, only
+  // the bots which were added or removed join or leave the conference. Keeps
+  // the running bots as they are if the definition cannot be loaded.
+  //
+  // Does not block: the joins, leaves and media loads are started, and
+  // their completions posted back to the thread of the host.
+  void reload_conversation();
+  // Runs the completions on the thread of the host, e.g. by posting them to
+  // its event loop. Called from any thread, they run inline by default.
+  void set_poster(std::function<void(action)> post) { post_ = std::move(post); }
+
+  // Period at which advance_timeline() is to be called.
+  static constexpr std::chrono::milliseconds timeline_tick{10};
+  // Starts the timeline of the conversation at the epoch, once the bots have
+  // joined: the bots move along their paths, and the bots of the entries
+  // with a "start" or "stop" start and stop injecting at these offsets.
+  void start_conversation(std::chrono::steady_clock::time_point epoch);
+  // Runs the events of the timeline due by now.
+  void advance_timeline(std::chrono::steady_clock::time_point now);
+  // The bots added from now on start together on the timeline, at their
+  // start or else at the epoch, with their decoded audio on the timeline.
+  void synchronize_start() { synchronized_ = true; }
+
+  // Parameters shared by all hosted bots (log settings, access token).
+  const command_line::sdk& get_params() const;
+  size_t size() const { return bots_.size(); }
+
+  void create_sdks();
+
+  // Block until every bot has either joined or failed to join. Throws if
+  // none of the bots managed to join.
+  void join_all();
+  void leave_all();
+
+  void on_conference_ended(action cb);
+
+  void print_interactive_options() const;
+  // Runs the command on every hosted bot, or on the named bot only. Returns
+  // the first error.
+  std::optional<std::string> handle_interactive_command(
+      const std::string& cmd,
+      const std::string& arg = {},
+      const std::string& bot_name = {});
+  // Runs a command typed on stdin, prompting once for its argument if it
+  // takes one, rather than once per bot.
+  std::optional<std::string> handle_typed_command(const std::string& cmd);
+
+ private:
+  struct interactive_command {
+    std::string cmd;
+    std::string desc;
+    action act;
+  };
+
+  void add_conversation_bot(const bot_definition& def,
+                            const std::string& folder);
+  bot* find_bot(const std::string& name);
+  void move_along_paths(std::chrono::steady_clock::time_point now);
+  void schedule_paths(std::chrono::steady_clock::time_point at);
+  // Sets the capture of the bot as it is by now on the timeline, and
+  // schedules its next changes.
+  void schedule_capture(bot& b,
+                        std::optional<double> start,
+                        std::optional<double> stop);
+  void cancel_capture(const std::string& name);
+  // Leaves the conference with a bot no longer hosted, then destroys it in
+  // the background, as destroying its SDK waits for it.
+  void retire(std::shared_ptr<bot> b);
+  void tear_down(std::shared_ptr<bot> b);
+  // Adds again the bots of the name once the retired one is destroyed.
+  void retired(const std::string& name);
+  void add_reloaded_bot(const bot_definition& def, const std::string& folder);
+  void join_added(const std::shared_ptr<bot>& b, const bot_definition& def);
+  void swap_media(const std::shared_ptr<bot>& b,
+                  const std::string& file,
+                  const std::string& media);
+
+  std::vector<interactive_command> interactive_commands_{};
+  std::vector<std::shared_ptr<bot>> bots_{};
+  std::optional<conversation> conversation_{};
+  std::vector<std::string> common_args_{};
+  action conference_ended_{};
+  bool synchronized_{false};
+  std::optional<std::chrono::steady_clock::time_point> epoch_{};
+  std::optional<timer_wheel> timeline_{};
+  std::map<std::string, std::vector<timer_wheel::timer_id>> capture_timers_{};
+  spatial_scene scene_{};
+  std::function<void(action)> post_{[](action act) { act(); }};
+  // Names of the bots retiring, and whether to add them again once destroyed
+  std::map<std::string, bool> retiring_{};
+  // Media loads and bot teardowns away from the thread of the host, joined on
+  // destruction
+  std::vector<std::future<void>> background_{};
+};
+
+};  // namespace dolbyio::comms::sample
@@ -13,7 +13,9 @@
 #include <dolbyio/comms/multimedia_streaming/recorder.h>
 #include <dolbyio/comms/sdk.h>
 
+#include <chrono>
 #include <iostream>
+#include <map>
 #include <optional>
 #include <string>
 
@@ -29,6 +31,10 @@ struct sdk {
   log_level sdk_log_level{log_level::INFO};
   log_level me_log_level{log_level::OFF};
   std::string log_dir{};
+  bool foreground{false};
+  // Budgets of the join and of the leave, zero meaning no deadline
+  std::chrono::seconds join_timeout{60};
+  std::chrono::seconds leave_timeout{10};
   std::string user_name{};
   std::string external_id{};
 
@@ -58,6 +64,7 @@ struct sdk {
     spatial_position initial_right{1, 0, 0};
     spatial_position initial_up{0, 1, 0};
     spatial_position initial_forward{0, 0, -1};
+    int spatial_update_rate{5};  // Per second, when moving along a path
 
     bool join_as_user() const {
       return nonlistener_join.value_or(default_nonlistener_join);
@@ -83,6 +90,19 @@ struct mediaio {
   std::optional<bool> override_inject_audio_{};
   std::optional<bool> override_inject_video_{};
   bool loop_the_injection_{false};
+  bool decode_audio_once_{false};
+  bool share_decoded_audio_{false};
+  bool stream_audio_{false};
+  bool use_prepared_assets_{false};
+  bool host_pacer_{false};
+  // Set by any of -d, -v and -a
+  bool record_{false};
+  // Container of the encoded video recordings: mkv, mp4 or raw
+  std::string record_container_{"mkv"};
+  // Mixdown of the recorded audio: off, also or only
+  std::string mixdown_{"off"};
+  int mix_gain_db_{0};
+  std::map<std::string, int> mix_gains_db_{};
 };
 }  // namespace command_line
 }  // namespace dolbyio::comms::sample
@@ -8,7 +8,17 @@
  ***************************************************************************/
 
 #include "wrappers/mediaio.h"
+#include "media/audio_decoder.h"
 #include "utils/async_accumulator.h"
+#include "utils/deadline.h"
+#include "utils/json.h"
+#include "utils/trace.h"
+
+#if defined(__linux__)
+#include "linux/host_pacer.h"
+#include "linux/shared_asset_store.h"
+#include "media/media_recorder.h"
+#endif
 
 namespace dolbyio::comms::sample {
 
@@ -17,16 +27,18 @@ media_io_wrapper::~media_io_wrapper() {
 }
 
 void media_io_wrapper::set_sdk(dolbyio::comms::sdk* sdk) {
-  std::lock_guard<std::mutex> lock(sdk_lock_);
+  trace::lock_guard lock(sdk_lock_, "sdk_lock_");
   if (!sdk && sdk_) {
     sdk_params_.video_frame_handler = nullptr;
-    auto promise = std::make_shared<std::promise<void>>();
-    auto future = promise->get_future();
-    stop_video()
-        .then([promise]() { promise->set_value(); })
-        .on_error(
-            [promise](auto&& ex) { promise->set_exception(std::move(ex)); });
-    future.get();
+    // Also called from the destructors, a hung stop must not block the
+    // teardown forever.
+    try {
+      wait_with_deadline(stop_video(), sdk_params_.leave_timeout,
+                         "Stopping the video");
+    } catch (const std::exception& ex) {
+      std::cerr << ex.what() << ", detaching anyway" << std::endl;
+    }
+    stop_recording();
   }
   sdk_ = sdk;
 }
@@ -45,31 +57,85 @@ async_result<void> media_io_wrapper::initialize_injection() {
     std::cerr << "No injection requested for audio or video, the input file "
                  "will not be used"
               << std::endl;
-    return {};
+    return start_recording();
   }
 
+  std::vector<std::shared_ptr<const inj_file>> assets;
+  if (params_.use_prepared_assets_ && !prepared_)
+    assets = open_prepared_assets();
+
   if (!injector_) {
-    injector_ = std::make_unique<plugin::injector_paced>(
+    // The host pacer drives the players of this sample, the file source
+    // paces its frames through the SDK injector.
+    const bool players_only =
+        prepared_ || !assets.empty() ||
+        (!video && (params_.decode_audio_once_ || params_.stream_audio_));
+    host_paced_ = params_.host_pacer_ && players_only;
+    if (params_.host_pacer_ && !host_paced_)
+      std::cerr << "The host pacer requires prepared assets, or audio only "
+                   "decoded once or streamed. Using the SDK pacing instead."
+                << std::endl;
+    injector_ = make_instrumented_injector(
+        !host_paced_,
         [](const dolbyio::comms::plugin::media_injection_status& state) {
+          trace::instant(
+              "injection", "media_injection_status",
+              "\"type\": " + std::to_string(static_cast<int>(state.type_)) +
+                  ", \"state\": " +
+                  std::to_string(static_cast<int>(state.state_)) +
+                  ", \"desc\": " + json_quote(state.description_));
           std::cerr << "Media Injection Status Change ===> type: "
                     << state.type_ << " state: " << state.state_
                     << " desc: " << state.description_ << std::endl;
-        });
+        },
+        std::move(first_frame_cb_), metrics_);
     if (video)
       sdk_params_.video_frame_handler = injector_.get();
   }
-  if (!source_) {
+  if (!assets.empty()) {
+    start_prepared_players(std::move(assets), audio, video);
+    prepared_ = true;
+  }
+  if (audio && params_.decode_audio_once_ && !pcm_player_) {
+    // Decode the audio of every file once, the player then loops the decoded
+    // samples without any further demuxing or decoding.
+    create_pcm_player();
+    for (size_t i = 0; i < params_.files.size(); ++i) {
+      auto buffer = load_audio(params_.files[i]);
+      std::cerr << "Decoded " << buffer->duration_ms() << "ms of audio from "
+                << params_.files[i] << std::endl;
+      if (i == 0)
+        pcm_player_->play(std::move(buffer));
+      else
+        pcm_player_->add_to_playlist(std::move(buffer));
+    }
+  }
+  if (audio && params_.stream_audio_ && !audio_from_player()) {
+    // Decode the audio progressively, a bounded number of frames ahead of
+    // the injection.
+    stream_player_ = std::make_unique<audio_stream_player>(
+        *injector_, params_.loop_the_injection_,
+        [this]() { on_audio_finished(); }, metrics_, host_paced_);
+    stream_player_->play(params_.files);
+  }
+  if (!source_ && !prepared_ && (video || !audio_from_player())) {
+    // When the audio comes from the players of the decoded audio the file
+    // source is only needed for the video.
+    const bool source_audio = audio && !audio_from_player();
     source_ = std::make_unique<file_source>(
         std::move(params_.files), params_.loop_the_injection_, *injector_,
-        [this, audio,
+        [this, source_audio,
          video](const dolbyio::comms::sample::file_source_status& status) {
           std::cerr << "File Source Status change\n";
+          trace::instant("injection", "file_source status",
+                         "\"state\": " + std::to_string(static_cast<int>(
+                                             status.current_state)));
 
-          std::lock_guard<std::mutex> lock(sdk_lock_);
+          trace::lock_guard lock(sdk_lock_, "sdk_lock_");
           if (sdk_) {
             if (status.current_state ==
                 dolbyio::comms::sample::source_state::STOPPED) {
-              if (audio)
+              if (source_audio)
                 stop_audio().on_error(
                     [](auto&&) { std::cerr << "Error stopping audio\n"; });
               if (video)
@@ -81,9 +147,25 @@ async_result<void> media_io_wrapper::initialize_injection() {
     injector_->set_has_video_sink_cb(
         [this](bool has_sink) { source_->set_video_capture(has_sink); });
   }
+  if (video_player_)
+    injector_->set_has_video_sink_cb(
+        [this](bool has_sink) { video_player_->set_capture(has_sink); });
+#if defined(__linux__)
+  if (host_paced_ && !pacer_tick_)
+    pacer_tick_ = host_pacer::instance().add(
+        [this](std::chrono::steady_clock::time_point now) {
+          if (pcm_player_)
+            pcm_player_->tick(now);
+          if (stream_player_)
+            stream_player_->tick(now);
+          if (video_player_)
+            video_player_->tick(now);
+        });
+#endif
 
   // Attach injector as audio/video source if that media is to be enabled
   async_result_accumulator accumulator;
+  accumulator += start_recording();
   if (audio)
     accumulator += sdk_->media_io().set_audio_source(injector_.get());
   if (video)
@@ -92,11 +174,202 @@ async_result<void> media_io_wrapper::initialize_injection() {
   return std::move(accumulator);
 }
 
+async_result<void> media_io_wrapper::start_recording() {
+  using video_config = plugin::recorder::video_recording_config;
+  using audio_config = plugin::recorder::audio_recording_config;
+  if (!params_.record_ || recorder_ ||
+      (params_.vid_config == video_config::NONE &&
+       params_.aud_config == audio_config::NONE))
+    return {};
+#if defined(__linux__)
+  // The sinks only copy the media into the staging buffers of the recorder,
+  // the disk is written by the thread of the batched writer.
+  auto container = media_recorder::container::matroska;
+  if (params_.record_container_ == "mp4")
+    container = media_recorder::container::mp4;
+  else if (params_.record_container_ == "raw")
+    container = media_recorder::container::raw;
+  media_recorder::mixdown_config mixdown;
+  if (params_.mixdown_ == "also")
+    mixdown.mix = media_recorder::mixdown_config::mode::alongside;
+  else if (params_.mixdown_ == "only")
+    mixdown.mix = media_recorder::mixdown_config::mode::only;
+  mixdown.gain_db = params_.mix_gain_db_;
+  mixdown.gains_db = params_.mix_gains_db_;
+  recorder_ = std::make_shared<media_recorder>(
+      params_.output_dir, sdk_params_.user_name, params_.vid_config,
+      params_.aud_config, container, mixdown, batched_writer::rotation{});
+  std::cerr << "Recording the received media into " << params_.output_dir
+            << "/" << sdk_params_.user_name << std::endl;
+  async_result_accumulator accumulator;
+  if (recorder_->records_audio())
+    accumulator += sdk_->media_io().set_audio_sink(recorder_.get());
+  if (recorder_->records_yuv())
+    accumulator += sdk_->video().remote().set_video_sink(recorder_.get());
+  if (recorder_->records_encoded())
+    accumulator += sdk_->media_io().set_encoded_video_sink(recorder_.get());
+  return std::move(accumulator);
+#else
+  std::cerr << "Recording the received media is only supported on Linux"
+            << std::endl;
+  return {};
+#endif
+}
+
+void media_io_wrapper::stop_recording() {
+#if defined(__linux__)
+  if (!recorder_)
+    return;
+  // No more media from the SDK threads once the sinks are detached, what is
+  // left of the recordings can then be written.
+  async_result_accumulator accumulator;
+  if (recorder_->records_audio())
+    accumulator += sdk_->media_io().set_audio_sink(nullptr);
+  if (recorder_->records_yuv())
+    accumulator += sdk_->video().remote().set_video_sink(nullptr);
+  if (recorder_->records_encoded())
+    accumulator += sdk_->media_io().set_encoded_video_sink(nullptr);
+  try {
+    wait_with_deadline(std::move(accumulator).forward(),
+                       sdk_params_.leave_timeout, "Detaching the recorder");
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << ", closing the recordings anyway" << std::endl;
+  }
+  recorder_->close();
+#endif
+}
+
 void media_io_wrapper::set_initial_capture(bool audio, bool video) {
-  if (source_) {
-    source_->set_audio_capture(audio);
+  set_audio_capture(audio);
+  if (source_)
     source_->set_video_capture(video);
+  if (video_player_)
+    video_player_->set_capture(video);
+}
+
+void media_io_wrapper::set_scheduled_capture(bool enable) {
+  // Already paused or playing is fine
+  if (enable) {
+    if (pcm_player_)
+      pcm_player_->resume();
+    if (stream_player_)
+      stream_player_->resume();
+    if (video_player_)
+      video_player_->resume();
+    if (source_)
+      source_->resume();
+    set_initial_capture(sdk_params_.conf.join_with_audio(),
+                        sdk_params_.conf.join_with_video());
+    return;
+  }
+  set_initial_capture(false, false);
+  if (pcm_player_)
+    pcm_player_->pause();
+  if (stream_player_)
+    stream_player_->pause();
+  if (video_player_)
+    video_player_->pause();
+  if (source_)
+    source_->pause();
+}
+
+void media_io_wrapper::set_timeline(
+    std::chrono::steady_clock::time_point origin) {
+  if (pcm_player_)
+    pcm_player_->set_timeline(origin);
+}
+
+void media_io_wrapper::create_pcm_player() {
+  pcm_player_ = std::make_unique<pcm_player>(
+      *injector_, params_.loop_the_injection_,
+      [this]() { on_audio_finished(); }, host_paced_);
+}
+
+void media_io_wrapper::on_audio_finished() {
+  trace::lock_guard lock(sdk_lock_, "sdk_lock_");
+  if (sdk_)
+    stop_audio().on_error(
+        [](auto&&) { std::cerr << "Error stopping audio\n"; });
+}
+
+std::vector<std::shared_ptr<const inj_file>>
+media_io_wrapper::open_prepared_assets() {
+  // Only when every file has been prepared, mixing prepared and decoded
+  // files in one playlist is not supported.
+  std::vector<std::shared_ptr<const inj_file>> assets;
+  for (const auto& file : params_.files) {
+    auto asset = open_prepared(file);
+    if (!asset) {
+      std::cerr << "No up to date prepared asset for " << file
+                << ", run cpp_injection_prepare first. Decoding the media "
+                   "instead."
+                << std::endl;
+      return {};
+    }
+    assets.push_back(std::move(asset));
+  }
+  return assets;
+}
+
+void media_io_wrapper::start_prepared_players(
+    std::vector<std::shared_ptr<const inj_file>>&& assets,
+    bool audio,
+    bool video) {
+#if defined(__linux__)
+  if (audio)
+    create_pcm_player();
+  if (video)
+    video_player_ = std::make_unique<video_frame_player>(
+        *injector_, params_.loop_the_injection_, host_paced_);
+  for (const auto& asset : assets) {
+    if (auto buffer = asset->audio(); buffer && pcm_player_)
+      pcm_player_->add_to_playlist(std::move(buffer));
+    if (asset->has_video() && video_player_)
+      video_player_->add_to_playlist(asset);
+  }
+  std::cerr << "Injecting " << assets.size() << " prepared asset(s)"
+            << std::endl;
+#endif
+}
+
+void media_io_wrapper::set_audio_capture(bool enable) {
+  if (pcm_player_)
+    pcm_player_->set_capture(enable);
+  if (stream_player_)
+    stream_player_->set_capture(enable);
+  if (source_)
+    source_->set_audio_capture(enable && !audio_from_player());
+}
+
+std::shared_ptr<const pcm_buffer> media_io_wrapper::load_audio(
+    const std::string& file) {
+#if defined(__linux__)
+  if (params_.share_decoded_audio_) {
+    shared_asset_store store{[](const std::string& path, int sample_rate) {
+      return decode_audio_file(path, sample_rate);
+    }};
+    return store.load_audio(file, injection_sample_rate);
+  }
+#endif
+  return decode_audio_file(file);
+}
+
+std::shared_ptr<const inj_file> media_io_wrapper::open_prepared(
+    const std::string& file) {
+#if defined(__linux__)
+  try {
+    const std::string ext = inj::extension;
+    if (file.size() > ext.size() &&
+        file.compare(file.size() - ext.size(), ext.size(), ext) == 0)
+      return inj_file::open(file);
+    auto asset = inj_file::open(inj::prepared_path(file));
+    if (asset && asset->prepared_from(file))
+      return asset;
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
   }
+#endif
+  return nullptr;
 }
 
 async_result<void> media_io_wrapper::stop_audio() {
@@ -109,28 +382,92 @@ async_result<void> media_io_wrapper::stop_video() {
       []() { std::cerr << "Video has been stopped\n"; });
 }
 
-void media_io_wrapper::new_file(bool add) {
-  std::cout << "file_name:" << std::endl;
-  std::string fname;
-  std::cin >> fname;
+void media_io_wrapper::new_file(bool add, std::string fname) {
+  play_loaded(add, load_file(fname));
+}
+
+media_io_wrapper::loaded_file media_io_wrapper::load_file(
+    const std::string& fname) {
+  // Prompted for by the host when typed, never read here on the thread
+  // running the command
+  if (fname.empty())
+    throw std::runtime_error("No file name given");
+  loaded_file file{fname};
+#if defined(__linux__)
+  if (prepared_) {
+    file.asset = open_prepared(fname);
+    if (!file.asset)
+      throw std::runtime_error("No up to date prepared asset for " + fname);
+    return file;
+  }
+#endif
+  if (pcm_player_)
+    file.audio = load_audio(fname);
+  return file;
+}
+
+void media_io_wrapper::play_loaded(bool add, loaded_file&& file) {
+  const auto& fname = file.name;
+#if defined(__linux__)
+  if (prepared_) {
+    auto asset = std::move(file.asset);
+    auto buffer = asset->audio();
+    if (pcm_player_ && buffer) {
+      if (add)
+        pcm_player_->add_to_playlist(std::move(buffer));
+      else
+        pcm_player_->play(std::move(buffer));
+    }
+    if (video_player_ && asset->has_video()) {
+      if (add)
+        video_player_->add_to_playlist(std::move(asset));
+      else
+        video_player_->play(std::move(asset));
+    }
+    return;
+  }
+#endif
+  if (pcm_player_) {
+    auto buffer = std::move(file.audio);
+    if (add)
+      pcm_player_->add_to_playlist(std::move(buffer));
+    else
+      pcm_player_->play(std::move(buffer));
+  }
+  if (stream_player_) {
+    if (add)
+      stream_player_->add_to_playlist(fname);
+    else
+      stream_player_->play({fname});
+  }
+  if (!source_)
+    return;
   if (add)
     source_->add_file_playlist(fname);
   else
     source_->play_new_file(fname);
 }
 
-void media_io_wrapper::seek_to_in_file() {
-  std::cout << "Enter the seek to time:" << std::endl;
+void media_io_wrapper::seek_to_in_file(std::string seek_str) {
+  if (seek_str.empty())
+    throw std::runtime_error("No seek time given");
+  int seek_time = 0;
   try {
-    std::string seek_str;
-    std::cin >> seek_str;
-    int seek_time;
     seek_time = std::stoi(seek_str);
-    if (!source_->seek(seek_time))
-      std::cerr << "Failed to Seek!\n";
-  } catch (const std::exception& e) {
-    std::cerr << e.what();
+  } catch (const std::exception&) {
+    throw std::runtime_error("Invalid seek time: " + seek_str);
   }
+  bool ok = true;
+  if (pcm_player_ && !pcm_player_->seek(std::chrono::seconds(seek_time)))
+    ok = false;
+  if (stream_player_ && !stream_player_->seek(std::chrono::seconds(seek_time)))
+    ok = false;
+  if (video_player_ && !video_player_->seek(std::chrono::seconds(seek_time)))
+    ok = false;
+  if (source_ && !source_->seek(seek_time))
+    ok = false;
+  if (!ok)
+    throw std::runtime_error("Failed to Seek!");
 }
 
 void media_io_wrapper::register_command_line_handlers(
@@ -158,6 +495,7 @@ void media_io_wrapper::register_command_line_handlers(
       "dumped (default: tmp)",
       [this](const std::string& arg) {
         cmdline_config_touched_.append("-d ");
+        params_.record_ = true;
         params_.output_dir = arg;
       });
   handler.add_command_line_switch({"-loop", "--loop"},
@@ -166,12 +504,73 @@ void media_io_wrapper::register_command_line_handlers(
                                     params_.loop_the_injection_ = true;
                                   });
 
+  handler.add_command_line_switch(
+      {"-decode-once", "--decode-once"},
+      "\n\tDecode the injected audio once into memory and play (or loop) it "
+      "from there, without decoding the files again.",
+      [this]() {
+        cmdline_config_touched_.append("-decode-once ");
+        params_.decode_audio_once_ = true;
+      });
+
+  handler.add_command_line_switch(
+      {"-stream-decode", "--stream-decode"},
+      "\n\tDecode the injected audio on a thread of its own, half a second "
+      "ahead of the injection at most. Unlike -decode-once, the memory used "
+      "does not grow with the length of the files.",
+      [this]() {
+        cmdline_config_touched_.append("-stream-decode ");
+        params_.stream_audio_ = true;
+      });
+
+#if defined(__linux__)
+  handler.add_command_line_switch(
+      {"-shared-decode", "--shared-decode"},
+      "\n\tLike -decode-once, but the decoded audio is kept in shared memory "
+      "and reused by all of the injection processes on this host.",
+      [this]() {
+        cmdline_config_touched_.append("-shared-decode ");
+        params_.decode_audio_once_ = true;
+        params_.share_decoded_audio_ = true;
+      });
+
+  handler.add_command_line_switch(
+      {"-prepared", "--prepared"},
+      "\n\tInject the assets prepared by cpp_injection_prepare (<file>.inj), "
+      "memory mapped with no decoding at all. Falls back to decoding the "
+      "files if they have not been prepared.",
+      [this]() {
+        cmdline_config_touched_.append("-prepared ");
+        params_.use_prepared_assets_ = true;
+      });
+
+  handler.add_command_line_switch(
+      {"-pacer", "--pacer"},
+      "<sdk|host>\n\tPacing of the injected frames: by the SDK injector of "
+      "every bot (default), or by a single timer of the process injecting "
+      "the frames due for all of its bots every 10ms. The host pacer "
+      "requires -prepared assets, or audio only with -decode-once or "
+      "-stream-decode.",
+      [this](const std::string& arg) {
+        cmdline_config_touched_.append("-pacer ");
+        if (arg == "host")
+          params_.host_pacer_ = true;
+        else if (arg == "sdk")
+          params_.host_pacer_ = false;
+        else
+          std::cerr << "Invalid argument for the -pacer option, using the "
+                       "SDK pacing."
+                    << std::endl;
+      });
+#endif
+
   handler.add_command_line_switch(
       {"-v"},
       "<video_format>\n\tVideo dump format: YUV, NONE, ENCODED, "
       "ENCODED_OPTIMIZED (default: ENCODED_OPTIMIZED)",
       [this](const std::string& arg) {
         cmdline_config_touched_.append("-v ");
+        params_.record_ = true;
         if (arg == "NONE")
           params_.vid_config =
               dolbyio::comms::plugin::recorder::video_recording_config::NONE;
@@ -193,6 +592,7 @@ void media_io_wrapper::register_command_line_handlers(
       "<audio_format>\n\tAudio dump format: AAC, NONE, PCM (default: PCM)",
       [this](const std::string& arg) {
         cmdline_config_touched_.append("-a ");
+        params_.record_ = true;
         if (arg == "NONE")
           params_.aud_config =
               dolbyio::comms::plugin::recorder::audio_recording_config::NONE;
@@ -207,6 +607,52 @@ void media_io_wrapper::register_command_line_handlers(
                     << std::endl;
       });
 
+  handler.add_command_line_switch(
+      {"-rec-container", "--rec-container"},
+      "<mkv|mp4|raw>\n\tContainer of the ENCODED and ENCODED_OPTIMIZED "
+      "video recordings: the frames are remuxed into one Matroska (default) "
+      "or fragmented MP4 file per track, seekable while being recorded, or "
+      "stored raw (IVF for VP8, Annex B for H264).",
+      [this](const std::string& arg) {
+        cmdline_config_touched_.append("-rec-container ");
+        if (arg == "mkv" || arg == "mp4" || arg == "raw")
+          params_.record_container_ = arg;
+        else
+          std::cerr << "Invalid argument for the -rec-container option, "
+                       "remuxing into Matroska."
+                    << std::endl;
+      });
+
+  handler.add_command_line_switch(
+      {"-mixdown", "--mixdown"},
+      "<off|also|only>\n\tMix the recorded audio of all of the remote "
+      "participants into a single 48kHz stereo track, along with the file of "
+      "every participant (also) or instead of them (only).",
+      [this](const std::string& arg) {
+        cmdline_config_touched_.append("-mixdown ");
+        if (arg == "off" || arg == "also" || arg == "only")
+          params_.mixdown_ = arg;
+        else
+          std::cerr << "Invalid argument for the -mixdown option, not mixing "
+                       "the audio down."
+                    << std::endl;
+      });
+
+  handler.add_command_line_switch(
+      {"-mix-gain", "--mix-gain"},
+      "<[stream_id=]dB>\n\tGain of the participants in the mixdown, in dB "
+      "(default: 0, at most +18). With a stream ID, the gain of that stream "
+      "only; can be given several times.",
+      [this](const std::string& arg) {
+        cmdline_config_touched_.append("-mix-gain ");
+        const auto eq = arg.rfind('=');
+        if (eq == std::string::npos)
+          params_.mix_gain_db_ = command_line::to_int(arg, "-mix-gain");
+        else
+          params_.mix_gains_db_[arg.substr(0, eq)] =
+              command_line::to_int(arg.substr(eq + 1), "-mix-gain");
+      });
+
   handler.add_command_line_switch(
       {"-iv"},
       "<true|false>\n\tOverride video injection setting (true - injecting "
@@ -256,26 +702,49 @@ void media_io_wrapper::register_interactive_commands(
     return;
   }
 
+  handler.add_interactive_command("stop-audio", "Stop audio injection",
+                                  [this]() { set_audio_capture(false); });
+  handler.add_interactive_command("start-audio", "Start audio injection",
+                                  [this]() { set_audio_capture(true); });
+  handler.add_interactive_command(
+      "f", "[file] set new file to play",
+      [this](const std::string& arg) { new_file(false, arg); });
   handler.add_interactive_command(
-      "stop-audio", "Stop audio injection",
-      [this]() { source_->set_audio_capture(false); });
+      "F", "[file] add new file to playlist",
+      [this](const std::string& arg) { new_file(true, arg); });
   handler.add_interactive_command(
-      "start-audio", "Start audio injection",
-      [this]() { source_->set_audio_capture(true); });
-  handler.add_interactive_command("f", "set new file to play",
-                                  [this]() { new_file(false); });
-  handler.add_interactive_command("F", "add new file to playlist",
-                                  [this]() { new_file(true); });
-  handler.add_interactive_command("s", "seek to timestamp in file",
-                                  [this]() { seek_to_in_file(); });
+      "s", "[seconds] seek to timestamp in file",
+      [this](const std::string& arg) { seek_to_in_file(arg); });
+  handler.set_argument_prompt("f", "file_name:");
+  handler.set_argument_prompt("F", "file_name:");
+  handler.set_argument_prompt("s", "Enter the seek to time:");
   handler.add_interactive_command(
       "r", "resume currently paused file", [this]() {
-        if (!source_->resume())
-          std::cerr << "Failed to perform Resume!\n";
+        // Every player is resumed, whichever of them failed
+        bool ok = true;
+        if (pcm_player_ && !pcm_player_->resume())
+          ok = false;
+        if (stream_player_ && !stream_player_->resume())
+          ok = false;
+        if (video_player_ && !video_player_->resume())
+          ok = false;
+        if (source_ && !source_->resume())
+          ok = false;
+        if (!ok)
+          throw std::runtime_error("Failed to perform Resume!");
       });
   handler.add_interactive_command("p", "pause currently play file", [this]() {
-    if (!source_->pause())
-      std::cerr << "Failed to perform Pause!\n";
+    bool ok = true;
+    if (pcm_player_ && !pcm_player_->pause())
+      ok = false;
+    if (stream_player_ && !stream_player_->pause())
+      ok = false;
+    if (video_player_ && !video_player_->pause())
+      ok = false;
+    if (source_ && !source_->pause())
+      ok = false;
+    if (!ok)
+      throw std::runtime_error("Failed to perform Pause!");
   });
 }
 
@@ -12,21 +12,35 @@
 
 #include "dolbyio/comms/sample/media_source/file/source_capture.h"
 
+#include "media/audio_stream_player.h"
+#include "media/inj_file.h"
+#include "media/instrumented_injector.h"
+#include "media/pcm_player.h"
+#include "media/video_frame_player.h"
 #include "utils/commands_handler.h"
 #include "utils/interactor.h"
 #include "wrappers/sdk.h"
 
+#include <chrono>
 #include <string>
 #include <vector>
 
 namespace dolbyio::comms::sample {
 
+class media_recorder;
+
 class media_io_wrapper : public interactor {
  public:
   media_io_wrapper(command_line::sdk& sdk_params) : sdk_params_(sdk_params) {}
   ~media_io_wrapper() override;
 
   void set_initial_capture(bool audio, bool video);
+  // Starts or stops injecting the media on the timeline of a conversation,
+  // the media is paused meanwhile so that it is not decoded.
+  void set_scheduled_capture(bool enable);
+  // Plays the decoded audio on the timeline starting at the origin, the
+  // other media only start with the capture.
+  void set_timeline(std::chrono::steady_clock::time_point origin);
 
   // interactor interface
   void set_sdk(dolbyio::comms::sdk* sdk) override;
@@ -35,23 +49,75 @@ class media_io_wrapper : public interactor {
   void register_interactive_commands(commands_handler& handler) override;
 
   bool media_io_enabled() const { return media_io_; }
+  bool injecting() const { return injector_ != nullptr; }
+
+  // Invoked on the first frame pushed into the injector, must be set before
+  // initialize_injection().
+  void set_first_frame_cb(std::function<void()>&& cb) {
+    first_frame_cb_ = std::move(cb);
+  }
+  // Metrics of the injected frames, must be set before
+  // initialize_injection().
+  void set_metrics(std::shared_ptr<metrics::injection_metrics> metrics) {
+    metrics_ = std::move(metrics);
+  }
 
   const command_line::mediaio& get_params() const { return params_; }
 
+  // A file loaded by load_file(), to be played by play_loaded().
+  struct loaded_file {
+    std::string name;
+    std::shared_ptr<const pcm_buffer> audio{};
+    std::shared_ptr<const inj_file> asset{};
+  };
+
+  // Replaces the media played, or adds it to the playlist.
+  void new_file(bool add, std::string fname);
+  // The two halves of new_file(): load_file() decodes the audio, from any
+  // thread, and play_loaded() hands the file over to the players from the
+  // thread running the commands.
+  loaded_file load_file(const std::string& fname);
+  void play_loaded(bool add, loaded_file&& file);
+
  private:
   async_result<void> stop_video();
   async_result<void> stop_audio();
-  void new_file(bool add);
-  void seek_to_in_file();
+  async_result<void> start_recording();
+  void stop_recording();
+  void set_audio_capture(bool enable);
+  void create_pcm_player();
+  void on_audio_finished();
+  bool audio_from_player() const { return pcm_player_ || stream_player_; }
+  std::vector<std::shared_ptr<const inj_file>> open_prepared_assets();
+  void start_prepared_players(
+      std::vector<std::shared_ptr<const inj_file>>&& assets,
+      bool audio,
+      bool video);
+  std::shared_ptr<const pcm_buffer> load_audio(const std::string& file);
+  std::shared_ptr<const inj_file> open_prepared(const std::string& file);
+  // Prompted for on stdin when not given along with the command
+  void seek_to_in_file(std::string seek_str);
 
-  std::shared_ptr<plugin::injector_paced> injector_{};
-  std::unique_ptr<file_source> source_{};
+  // Declared first so that it outlives the players, whose threads take it
+  // when they finish while being destroyed
   std::mutex sdk_lock_{};
-  dolbyio::comms::sdk* sdk_;
+  std::shared_ptr<plugin::injector> injector_{};
+  std::function<void()> first_frame_cb_{};
+  std::shared_ptr<metrics::injection_metrics> metrics_{};
+  std::unique_ptr<file_source> source_{};
+  std::unique_ptr<pcm_player> pcm_player_{};
+  std::unique_ptr<audio_stream_player> stream_player_{};
+  std::unique_ptr<video_frame_player> video_player_{};
+  // Unregisters the players from the host pacer, before they are destroyed
+  std::shared_ptr<void> pacer_tick_{};
+  std::shared_ptr<media_recorder> recorder_{};
+  dolbyio::comms::sdk* sdk_{nullptr};
   command_line::sdk& sdk_params_;
   command_line::mediaio params_;
 
   bool media_io_{false};
+  bool prepared_{false};
+  bool host_paced_{false};
   std::string cmdline_config_touched_{};
 };
 
@@ -84,15 +84,19 @@ async_result<void> sdk_wrapper::close_session() {
   return sdk_->session().close();
 }
 
+bool sdk_wrapper::spatial_audio_applies() const {
+  const auto& params = get_params().conf;
+  // Not when using opus or listener or no spatial audio
+  return params.dolby_voice && params.nonlistener_join &&
+         params.spatial != dolbyio::comms::spatial_audio_style::disabled;
+}
+
 async_result<void> sdk_wrapper::apply_spatial_audio_configuration() {
   check_if_sdk_set();
   auto params = get_params().conf;
 
-  // If using opus or listener or no spatial audio do nothing
-  if (!params.dolby_voice || !params.nonlistener_join ||
-      params.spatial == dolbyio::comms::spatial_audio_style::disabled) {
+  if (!spatial_audio_applies())
     return {};
-  }
   // Set the spatial environment, direction, position
   spatial_audio_batch_update batch_update;
   batch_update.set_spatial_environment(params.initial_scale,
@@ -107,6 +111,28 @@ async_result<void> sdk_wrapper::apply_spatial_audio_configuration() {
       std::move(batch_update));
 }
 
+async_result<void> sdk_wrapper::update_spatial_placement(
+    const std::optional<spatial_position>& position,
+    const std::optional<spatial_direction>& direction) {
+  check_if_sdk_set();
+  if (position)
+    params_.conf.initial_spatial_position = *position;
+  if (direction)
+    params_.conf.initial_spatial_direction = *direction;
+  if (!spatial_audio_applies() || (!position && !direction))
+    return {};
+
+  // The environment is kept from the join
+  spatial_audio_batch_update batch_update;
+  if (direction)
+    batch_update.set_spatial_direction(*direction);
+  if (position)
+    batch_update.set_spatial_position(session_info().participant_id.value(),
+                                      *position);
+  return sdk_->conference().update_spatial_audio_configuration(
+      std::move(batch_update));
+}
+
 void sdk_wrapper::register_command_line_handlers(commands_handler& handler) {
   handler.add_command_line_switch(
       {"-u", "--user_name"}, "<name>\n\tUser name to use in conferences.",
@@ -151,6 +177,34 @@ void sdk_wrapper::register_command_line_handlers(commands_handler& handler) {
       {"-ld", "--log_dir"}, "<dir>\n\tLog to file in directory.",
       [this](const std::string& arg) { params_.log_dir = arg; });
 
+#if defined(__linux__)
+  handler.add_command_line_switch(
+      {"-foreground", "--foreground"},
+      "\n\tDo not run as a daemon, used when the process is supervised by "
+      "cpp_injection_orchestrator.",
+      [this]() { params_.foreground = true; });
+#endif
+
+  handler.add_command_line_switch(
+      {"-join-timeout", "--join-timeout"},
+      "<seconds>\n\tTime the bot may take to join the conference and start "
+      "the injection before giving up on it, 0 to wait forever (default: "
+      "60).",
+      [this](const std::string& arg) {
+        params_.join_timeout =
+            std::chrono::seconds(command_line::to_int(arg, "-join-timeout"));
+      });
+
+  handler.add_command_line_switch(
+      {"-leave-timeout", "--leave-timeout"},
+      "<seconds>\n\tTime the bot may take to stop the injection and leave "
+      "the conference before exiting anyway, 0 to wait forever (default: "
+      "10).",
+      [this](const std::string& arg) {
+        params_.leave_timeout =
+            std::chrono::seconds(command_line::to_int(arg, "-leave-timeout"));
+      });
+
   handler.add_command_line_switch(
       {"-i"},
       "<id>\n\tJoin conference with ID (no conference creation attempt).",
@@ -356,6 +410,17 @@ void sdk_wrapper::register_command_line_handlers(commands_handler& handler) {
         auto z = std::stod(z_str);
         params_.conf.initial_forward = spatial_position{x, y, z};
       });
+
+  handler.add_command_line_switch(
+      {"-spatial-update-rate"},
+      "<n>\n\tMaximum updates per second of the spatial placement of a bot "
+      "moving along a path of the conversation definition (default: 5).",
+      [this](const std::string& arg) {
+        const int rate = command_line::to_int(arg, "-spatial-update-rate");
+        if (rate <= 0)
+          command_line::throw_bad_args_error("-spatial-update-rate", arg);
+        params_.conf.spatial_update_rate = rate;
+      });
 }
 
 void sdk_wrapper::register_interactive_commands(commands_handler& handler) {}
@@ -42,6 +42,11 @@ class sdk_wrapper : public interactor {
   async_result<void> leave_conference();
   async_result<void> close_session();
   async_result<void> apply_spatial_audio_configuration();
+  // Moves or turns the bot in the spatial scene set up when joining, the
+  // batch update only carries what is given.
+  async_result<void> update_spatial_placement(
+      const std::optional<dolbyio::comms::spatial_position>& position,
+      const std::optional<dolbyio::comms::spatial_direction>& direction);
 
   // Conference Info helpers
   dolbyio::comms::conference_info conference_info() { return conf_info_; }
@@ -55,6 +60,7 @@ class sdk_wrapper : public interactor {
   async_result<void> set_spatial_configuration(
       dolbyio::comms::spatial_audio_batch_update&& batch_update);
   void check_if_sdk_set();
+  bool spatial_audio_applies() const;
 
   dolbyio::comms::sdk* sdk_{nullptr};
   command_line::sdk params_{};
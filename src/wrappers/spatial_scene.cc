@@ -0,0 +1,90 @@
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "wrappers/spatial_scene.h"
+
+#include <iostream>
+
+namespace dolbyio::comms::sample {
+
+namespace {
+
+// The placement last sent to the conference, kept in the parameters of the
+// bot from the join on.
+spatial_placement current_placement(const bot& b) {
+  const auto& conf = b.get_params().conf;
+  return {conf.initial_spatial_position.x, conf.initial_spatial_position.y,
+          conf.initial_spatial_position.z, conf.initial_spatial_direction.y};
+}
+
+std::string describe(const std::exception_ptr& err) {
+  try {
+    std::rethrow_exception(err);
+  } catch (const std::exception& ex) {
+    return ex.what();
+  } catch (...) {
+    return "unknown error";
+  }
+}
+
+}  // namespace
+
+void spatial_scene::place(bot& b, const spatial_placement& placement) {
+  auto& state = bots_.try_emplace(b.name(), bot_state{&b}).first->second;
+  state.b = &b;
+  state.wanted = placement;
+}
+
+void spatial_scene::forget(const std::string& name) {
+  bots_.erase(name);
+}
+
+void spatial_scene::flush(clock::time_point now) {
+  for (auto& [name, state] : bots_) {
+    if (state.last->pending || !state.b->joined())
+      continue;
+    // The parameters of the bot hold the placement which failed
+    const bool resend = state.last->failed;
+    if (resend && !state.wanted)
+      state.wanted = current_placement(*state.b);
+    if (!state.wanted)
+      continue;
+    const std::chrono::microseconds min_interval{
+        1000000 / state.b->get_params().conf.spatial_update_rate};
+    if (now - state.last_update < min_interval)
+      continue;
+
+    const auto current = current_placement(*state.b);
+    const auto& wanted = *state.wanted;
+    std::optional<spatial_position> position;
+    std::optional<double> yaw;
+    // All of it again if the previous update failed
+    if (resend || wanted.moved_from(current))
+      position.emplace(wanted.x, wanted.y, wanted.z);
+    if (resend || wanted.turned_from(current))
+      yaw = wanted.r;
+    state.wanted.reset();
+    if (!position && !yaw)
+      continue;
+
+    state.last_update = now;
+    state.last = std::make_shared<request>();
+    state.last->pending = true;
+    state.b->update_spatial_placement(position, yaw)
+        .then([last{state.last}]() { last->pending = false; })
+        .on_error([last{state.last}, name{name}](auto&& ex) {
+          std::cerr << "Bot " << name << " failed to move: "
+                    << describe(ex) << std::endl;
+          last->failed = true;
+          last->pending = false;
+        });
+  }
+}
+
+}  // namespace dolbyio::comms::sample
@@ -0,0 +1,63 @@
+#pragma once
+
+/***************************************************************************
+ * This program is licensed by the accompanying "license" file. This file is
+ * distributed "AS IS" AND WITHOUT WARRANTY OF ANY KIND WHATSOEVER, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ *
+ *                Copyright (C) 2022-2023 by Dolby Laboratories.
+ ***************************************************************************/
+
+#include "utils/trajectory.h"
+#include "wrappers/bot.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace dolbyio::comms::sample {
+
+/**
+ * Placements of the bots of a process in the shared spatial scene, once
+ * they have joined. The SDK only places the local participant of a
+ * connection, so every bot gets its own batch updates: the environment of
+ * the scene is sent by each bot once, with its first placement when it
+ * joins, and the later moves of all of the bots are collected by place()
+ * and sent by flush().
+ *
+ * A flush sends a bot a single batch update with only what changed since
+ * the previous one, its position and/or its direction. It does so no more
+ * often than the -spatial-update-rate of the bot, and not while the
+ * previous update is pending. Moves made meanwhile are merged, the latest
+ * placement is sent next, and a failed update is sent again.
+ */
+class spatial_scene {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  // The bot must have joined and stays placed until forgotten.
+  void place(bot& b, const spatial_placement& placement);
+  void forget(const std::string& name);
+
+  void flush(clock::time_point now);
+
+ private:
+  struct request {
+    std::atomic<bool> pending{false};
+    std::atomic<bool> failed{false};
+  };
+  struct bot_state {
+    bot* b;
+    std::optional<spatial_placement> wanted{};
+    clock::time_point last_update{};
+    std::shared_ptr<request> last{std::make_shared<request>()};
+  };
+
+  std::map<std::string, bot_state> bots_{};
+};
+
+}  // namespace dolbyio::comms::sample